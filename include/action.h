@@ -10,6 +10,44 @@ struct view;
 struct server;
 struct cursor_context;
 
+/* Arguments are resolved to these keys when the config is parsed */
+enum action_arg_key {
+	ACTION_ARG_INVALID = 0,
+	ACTION_ARG_COMMAND,
+	ACTION_ARG_DIRECTION,
+	ACTION_ARG_SNAP_WINDOWS,
+	ACTION_ARG_COMBINE,
+	ACTION_ARG_WORKSPACE,
+	ACTION_ARG_OUTPUT,
+	ACTION_ARG_IDENTIFIER,
+	ACTION_ARG_MENU,
+	ACTION_ARG_AT_CURSOR,
+	ACTION_ARG_X_POSITION,
+	ACTION_ARG_Y_POSITION,
+	ACTION_ARG_DECORATIONS,
+	ACTION_ARG_FORCE_SSD,
+	ACTION_ARG_LEFT,
+	ACTION_ARG_RIGHT,
+	ACTION_ARG_TOP,
+	ACTION_ARG_BOTTOM,
+	ACTION_ARG_X,
+	ACTION_ARG_Y,
+	ACTION_ARG_WIDTH,
+	ACTION_ARG_HEIGHT,
+	ACTION_ARG_FOLLOW,
+	ACTION_ARG_TO,
+	ACTION_ARG_WRAP,
+	ACTION_ARG_TOGGLE,
+	ACTION_ARG_REGION,
+	ACTION_ARG_OUTPUT_NAME,
+	ACTION_ARG_POLICY,
+	ACTION_ARG_MESSAGE_PROMPT,
+	ACTION_ARG_QUERY,
+	ACTION_ARG_THEN,
+	ACTION_ARG_ELSE,
+	ACTION_ARG_NONE,
+};
+
 struct action {
 	struct wl_list link; /*
 			      * struct keybinding.actions
@@ -23,17 +61,20 @@ struct action {
 
 struct action *action_create(const char *action_name);
 
-const char *action_get_str(struct action *action, const char *key,
+const char *action_get_str(struct action *action, enum action_arg_key key,
 	const char *default_value);
 bool action_is_valid(struct action *action);
 bool action_is_show_menu(struct action *action);
 
-void action_arg_add_str(struct action *action, const char *key, const char *value);
-void action_arg_add_actionlist(struct action *action, const char *key);
-void action_arg_add_querylist(struct action *action, const char *key);
+void action_arg_add_str(struct action *action, enum action_arg_key key,
+	const char *value);
+void action_arg_add_actionlist(struct action *action, enum action_arg_key key);
+void action_arg_add_querylist(struct action *action, enum action_arg_key key);
 
-struct wl_list *action_get_actionlist(struct action *action, const char *key);
-struct wl_list *action_get_querylist(struct action *action, const char *key);
+struct wl_list *action_get_actionlist(struct action *action,
+	enum action_arg_key key);
+struct wl_list *action_get_querylist(struct action *action,
+	enum action_arg_key key);
 
 void action_arg_from_xml_node(struct action *action, const char *nodename, const char *content);
 
@@ -27,6 +27,7 @@
 #define LABWC_BUFFER_H
 
 #include <cairo.h>
+#include <stdatomic.h>
 #include <wlr/types/wlr_buffer.h>
 
 struct lab_data_buffer {
@@ -43,6 +44,20 @@ struct lab_data_buffer {
 	 */
 	uint32_t logical_width;
 	uint32_t logical_height;
+	/*
+	 * The pixel data has straight (non-pre-multiplied) alpha and must be
+	 * converted by buffer_premultiply() before it is used. This allows
+	 * to skip the conversion of buffers which are never shown.
+	 */
+	bool straight_alpha;
+	/*
+	 * References to the pixel data: one held by the creator of the
+	 * buffer plus one per buffer from buffer_create_shared(). Unlike the
+	 * locks of wlr_buffer, these can be taken and released by any thread.
+	 */
+	atomic_int shared_refs;
+	/* The buffer whose pixel data is used, for buffer_create_shared() */
+	struct lab_data_buffer *shared_src;
 };
 
 /*
@@ -77,6 +92,29 @@ struct lab_data_buffer *buffer_create_from_data(void *pixel_data, uint32_t width
 struct lab_data_buffer *buffer_create_from_wlr_buffer(
 	struct wlr_buffer *wlr_buffer);
 
+/*
+ * Create a buffer which uses the pixel data of @src instead of a copy.
+ * @src is kept alive until the returned buffer has been destroyed. Neither
+ * buffer must be drawn to any more. Safe to call from any thread as long as
+ * the caller holds a reference to @src.
+ */
+struct lab_data_buffer *buffer_create_shared(struct lab_data_buffer *src);
+
+/*
+ * Release the creator's reference to a buffer used with
+ * buffer_create_shared(), instead of dropping it. The buffer is destroyed
+ * once no buffers share its pixel data any more. Must only be used for
+ * buffers which have not been passed to wlroots.
+ */
+void buffer_release_shared(struct lab_data_buffer *buffer);
+
+/*
+ * Convert the pixel data of a buffer with straight_alpha set to
+ * pre-multiplied alpha in place. Does nothing for other buffers.
+ * Must not be called while other threads may read the buffer.
+ */
+void buffer_premultiply(struct lab_data_buffer *buffer);
+
 /*
  * Resize a buffer to the given size. The source buffer is rendered at the
  * center of the output buffer and shrunk if it overflows from the output buffer.
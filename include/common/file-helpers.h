@@ -2,6 +2,12 @@
 #ifndef LABWC_FILE_HELPERS_H
 #define LABWC_FILE_HELPERS_H
 #include <stdbool.h>
+#include <stddef.h>
+
+struct mapped_file {
+	const char *data;
+	size_t len;
+};
 
 /**
  * file_exists() - Test if file exists.
@@ -9,4 +15,20 @@
  */
 bool file_exists(const char *filename);
 
+/**
+ * file_map() - Map a file into memory read-only.
+ * @filename: Name of file to map.
+ * @file: Receives the mapping.
+ *
+ * The data is not NUL-terminated. Empty files cannot be mapped.
+ * Return: true on success, in which case file_unmap() must be called.
+ */
+bool file_map(const char *filename, struct mapped_file *file);
+
+/**
+ * file_unmap() - Release a mapping created by file_map().
+ * @file: Mapping to release.
+ */
+void file_unmap(struct mapped_file *file);
+
 #endif /* LABWC_FILE_HELPERS_H */
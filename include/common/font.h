@@ -31,9 +31,10 @@ int font_width(struct font *font, const char *string);
 
 /**
  * font_get_buffer_size - dry-run font_buffer_create() to get buffer size
+ * @use_markup: flag to measure @text as pango markup
  */
 void font_get_buffer_size(int max_width, const char *text, struct font *font,
-	int *width, int *height);
+	int *width, int *height, bool use_markup);
 
 /**
  * font_buffer_create - Create ARGB8888 lab_data_buffer using pango
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_HASH_H
+#define LABWC_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* Initial value for hash_add() and friends (64-bit FNV-1a offset basis) */
+#define HASH_INIT 0xcbf29ce484222325ULL
+
+/**
+ * hash_add() - add bytes to a 64-bit FNV-1a hash
+ * @hash: hash to be updated, initially HASH_INIT
+ * @data: bytes to add
+ * @len: number of bytes
+ *
+ * This is not a cryptographic hash. It is only intended for cache keys and
+ * change detection.
+ *
+ * Return: updated hash
+ */
+static inline uint64_t
+hash_add(uint64_t hash, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+/**
+ * hash_add_str() - add a string including its terminator to a hash
+ * @hash: hash to be updated
+ * @str: string to add, NULL is treated like an empty string
+ *
+ * The terminator is included so that "ab" + "c" and "a" + "bc" differ.
+ */
+static inline uint64_t
+hash_add_str(uint64_t hash, const char *str)
+{
+	return str ? hash_add(hash, str, strlen(str) + 1) : hash_add(hash, "", 1);
+}
+
+#endif /* LABWC_HASH_H */
@@ -0,0 +1,18 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_PREMULTIPLY_H
+#define LABWC_PREMULTIPLY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * premultiply_argb32() - convert pixels from straight to pre-multiplied alpha
+ * @pixels: ARGB32 pixels in native byte order, converted in place
+ * @nr_pixels: number of pixels
+ *
+ * Each color channel c becomes c * alpha / 255, rounded down. This gives
+ * the same result as doing the division per channel, just faster.
+ */
+void premultiply_argb32(uint32_t *pixels, size_t nr_pixels);
+
+#endif /* LABWC_PREMULTIPLY_H */
@@ -0,0 +1,30 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_RESAMPLE_H
+#define LABWC_RESAMPLE_H
+
+#include <stdint.h>
+
+/**
+ * resample_box_argb32() - downscale an image with a box (area) filter
+ * @src: source pixels
+ * @src_width: source width in pixels
+ * @src_height: source height in pixels
+ * @src_stride: source stride in bytes
+ * @dst: destination pixels
+ * @dst_width: destination width, 1 <= @dst_width <= @src_width
+ * @dst_height: destination height, 1 <= @dst_height <= @src_height
+ * @dst_stride: destination stride in bytes
+ *
+ * Each destination pixel is the average of the source area it covers,
+ * weighted by coverage. This is the right filter for large reductions
+ * like 512px application icons shown at 16px, where bilinear filtering
+ * just picks a few source pixels and aliases badly.
+ *
+ * Pixels are 32-bit with pre-multiplied alpha. All four channels are
+ * treated alike, so byte order does not matter.
+ */
+void resample_box_argb32(const uint32_t *src, int src_width, int src_height,
+	int src_stride, uint32_t *dst, int dst_width, int dst_height,
+	int dst_stride);
+
+#endif /* LABWC_RESAMPLE_H */
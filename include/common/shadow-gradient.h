@@ -0,0 +1,58 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_SHADOW_GRADIENT_H
+#define LABWC_SHADOW_GRADIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Window drop-shadows are a Gaussian fall-off, which is separable: the 2-D
+ * corner is the outer product of two 1-D profiles and the edge is a slice of
+ * the same profile. The profile is therefore computed once per shadow size
+ * and all pixels are derived from it with integer arithmetic only.
+ *
+ * Profile values are fixed-point with 15 fractional bits (1.0 == 1 << 15).
+ * Colors are premultiplied RGBA and pixels are written as ARGB32.
+ */
+#define SHADOW_GRADIENT_ONE (1 << 15)
+
+/**
+ * shadow_gradient_profile() - compute the 1-D Gaussian profile
+ * @profile: array of @total_size elements to be filled
+ * @total_size: visible plus obscured (inset) size of the shadow
+ */
+void shadow_gradient_profile(uint32_t *profile, int total_size);
+
+/**
+ * shadow_gradient_edge() - draw the 1 pixel tall edge buffer
+ * @pixels: row of @visible_size pixels
+ * @profile: profile from shadow_gradient_profile()
+ * @visible_size: size of the shadow extending beyond the window
+ * @total_size: visible plus obscured (inset) size of the shadow
+ * @color: color at the window edge
+ *
+ * The row is drawn as found at the right-hand edge of a window. It does not
+ * contain the inset, but lines up with the corners which do.
+ */
+void shadow_gradient_edge(uint32_t *pixels, const uint32_t *profile,
+	int visible_size, int total_size, const float color[4]);
+
+/**
+ * shadow_gradient_corner() - draw the square corner buffer
+ * @pixels: @total_size x @total_size pixels
+ * @stride: stride of @pixels in bytes
+ * @profile: profile from shadow_gradient_profile()
+ * @visible_size: size of the shadow extending beyond the window
+ * @total_size: visible plus obscured (inset) size of the shadow
+ * @titlebar_height: height of the titlebar for top corners, 0 otherwise
+ * @color: color at the window corner
+ *
+ * The corner is drawn for the bottom-right corner of a window. The part
+ * which would be visible through a translucent window, but not obscured
+ * by the (always opaque) titlebar, is left clear.
+ */
+void shadow_gradient_corner(uint32_t *pixels, size_t stride,
+	const uint32_t *profile, int visible_size, int total_size,
+	int titlebar_height, const float color[4]);
+
+#endif /* LABWC_SHADOW_GRADIENT_H */
@@ -13,8 +13,11 @@ pid_t spawn_primary_client(const char *command);
 /**
  * spawn_async_no_shell - execute asynchronously
  * @command: command to be executed
+ *
+ * Returns the pid of the child or -1 on failure. The child is reaped by
+ * the generic SIGCHLD handler in src/server.c.
  */
-void spawn_async_no_shell(char const *command);
+pid_t spawn_async_no_shell(char const *command);
 
 /**
  * spawn_sync_no_shell - execute synchronously
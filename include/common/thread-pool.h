@@ -0,0 +1,63 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_THREAD_POOL_H
+#define LABWC_THREAD_POOL_H
+
+struct thread_pool;
+struct wl_event_loop;
+
+typedef void (*thread_pool_func_t)(void *data);
+
+/**
+ * thread_pool_create() - create a pool of worker threads
+ * @nr_threads: number of workers; if <= 0, the number of online CPUs is used
+ * @loop: event loop to run completion callbacks on, may be NULL if
+ *        thread_pool_submit_async() is not used
+ *
+ * If no thread can be created, jobs are run synchronously by
+ * thread_pool_submit() instead, so callers do not need a fallback path.
+ */
+struct thread_pool *thread_pool_create(int nr_threads,
+	struct wl_event_loop *loop);
+
+/**
+ * thread_pool_submit() - queue a job to be run on a worker thread
+ * @pool: thread pool
+ * @func: function to run
+ * @data: argument passed to @func
+ *
+ * Jobs must only touch data that no other job or the main thread accesses
+ * until thread_pool_wait() has returned.
+ */
+void thread_pool_submit(struct thread_pool *pool, thread_pool_func_t func,
+	void *data);
+
+/**
+ * thread_pool_submit_async() - queue a job with a completion callback
+ * @pool: thread pool created with an event loop
+ * @func: function to run on a worker thread
+ * @done: function to run on the event loop once @func has returned
+ * @data: argument passed to @func and @done
+ *
+ * @done is never called from within thread_pool_submit_async(), even if
+ * the pool has no worker threads, so it is safe to submit jobs from code
+ * which @done calls back into.
+ */
+void thread_pool_submit_async(struct thread_pool *pool,
+	thread_pool_func_t func, thread_pool_func_t done, void *data);
+
+/**
+ * thread_pool_wait() - block until all submitted jobs have finished
+ * @pool: thread pool
+ */
+void thread_pool_wait(struct thread_pool *pool);
+
+/**
+ * thread_pool_destroy() - wait for pending jobs and join all workers
+ * @pool: thread pool (may be NULL)
+ *
+ * Completion callbacks of finished jobs which have not been run yet are
+ * run before returning.
+ */
+void thread_pool_destroy(struct thread_pool *pool);
+
+#endif /* LABWC_THREAD_POOL_H */
@@ -0,0 +1,13 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_TIME_H
+#define LABWC_TIME_H
+
+/**
+ * get_time_ms() - Get the time of the monotonic clock
+ *
+ * Return: time in milliseconds, only meaningful relative to other values
+ * returned by this function
+ */
+double get_time_ms(void);
+
+#endif /* LABWC_TIME_H */
@@ -50,6 +50,26 @@ enum tiling_events_mode {
 		(LAB_TILING_EVENTS_REGION | LAB_TILING_EVENTS_EDGE),
 };
 
+/*
+ * Groups of settings which are tracked separately on reconfigure, so that
+ * only the subsystems depending on a changed group are reloaded
+ */
+enum config_domain {
+	CONFIG_DOMAIN_CORE = 0, /* anything not covered below */
+	CONFIG_DOMAIN_THEME,
+	CONFIG_DOMAIN_FONTS,
+	CONFIG_DOMAIN_ICON_THEME,
+	CONFIG_DOMAIN_KEYBINDS,
+	CONFIG_DOMAIN_MOUSEBINDS,
+	CONFIG_DOMAIN_INPUT,
+	CONFIG_DOMAIN_WINDOW_RULES,
+	CONFIG_DOMAIN_REGIONS,
+	CONFIG_DOMAIN_WORKSPACES,
+	CONFIG_DOMAIN_MENUS,
+
+	CONFIG_DOMAIN_COUNT
+};
+
 struct buf;
 
 struct button_map_entry {
@@ -214,6 +234,7 @@ struct rcxml {
 	/* Menu */
 	unsigned int menu_ignore_button_release_period;
 	bool menu_show_icons;
+	unsigned int menu_release_delay;
 
 	/* Magnifier */
 	int mag_width;
@@ -221,11 +242,36 @@ struct rcxml {
 	float mag_scale;
 	float mag_increment;
 	bool mag_filter;
+
+	/* Hash of the settings and files of each enum config_domain */
+	uint64_t fingerprints[CONFIG_DOMAIN_COUNT];
 };
 
 /* defined in main.c */
 extern struct rcxml rc;
 
+struct rcxml_source;
+
+/**
+ * rcxml_source_load() - read and parse rc.xml without touching rc
+ * @filename: config file, or NULL to use the XDG Base Dirs
+ * @merge_config: merge the rc.xml files from all XDG Base Dirs
+ *
+ * Only does file I/O and XML parsing and does not read rc, so it may run on
+ * a worker thread.
+ * Malformed files are kept in the source and reported by
+ * rcxml_source_get_error().
+ */
+struct rcxml_source *rcxml_source_load(const char *filename,
+	bool merge_config);
+
+/* Returns the path of the first malformed file, or NULL */
+const char *rcxml_source_get_error(struct rcxml_source *source);
+void rcxml_source_destroy(struct rcxml_source *source);
+
+/* Fill rc from @source, rcxml_finish() must have been called before */
+void rcxml_read_source(struct rcxml_source *source);
+
 void rcxml_read(const char *filename);
 void rcxml_finish(void);
 
@@ -2,6 +2,9 @@
 #ifndef LABWC_SESSION_H
 #define LABWC_SESSION_H
 
+#include <stdbool.h>
+#include <sys/types.h>
+
 struct server;
 
 /**
@@ -19,9 +22,21 @@ void session_environment_init(void);
 
 /**
  * session_autostart_init - run autostart file as shell script
+ * @startup_cmd: command to run after autostart, may be NULL
  * Note: Same as `sh ~/.config/labwc/autostart` (or equivalent XDG config dir)
+ *
+ * The dbus and systemd activation environment is updated first without
+ * blocking; autostart is run once that has finished.
+ */
+void session_autostart_init(const char *startup_cmd);
+
+/**
+ * session_check_pid - check whether an exited child belongs to the
+ * activation environment update and advance it if so
+ * @pid: pid of the exited child
+ * @exit_code: exit status, or the negated signal number if it was killed
  */
-void session_autostart_init(void);
+bool session_check_pid(pid_t pid, int exit_code);
 
 /**
  * session_shutdown - run session shutdown file as shell script
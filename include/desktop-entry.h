@@ -5,14 +5,32 @@
 #if HAVE_LIBSFDO
 
 struct server;
+struct wl_listener;
 
+/*
+ * Start loading the desktop entry database and icon theme in the
+ * background. Until that has finished, icon lookups fail.
+ */
 void desktop_entry_init(void);
+
+/* Reload if the icon theme or XDG data directories have changed */
+void desktop_entry_reconfigure(void);
+
 void desktop_entry_finish(void);
 
+/*
+ * Get notified (on the main thread) whenever a newly loaded database has
+ * been put to use, so that icons can be refreshed.
+ */
+void desktop_entry_add_ready_listener(struct wl_listener *listener);
+
 struct lab_img *desktop_entry_load_icon_from_app_id(const char *app_id, int size, float scale);
 
 struct lab_img *desktop_entry_load_icon(const char *icon_name, int size, float scale);
 
+/* Print icon cache statistics to stdout (for the Debug action) */
+void desktop_entry_print_stats(void);
+
 /**
  * desktop_entry_name_lookup() - return the application name
  * from the sfdo desktop entry database based on app_id
@@ -18,6 +18,16 @@ struct ext_foreign_toplevel {
 		struct wl_listener new_app_id;
 		struct wl_listener new_title;
 	} on_view;
+
+	/* Title or app_id changes not yet sent */
+	int nr_updates;
+	struct wl_event_source *flush_idle;
+
+	/* State last sent to clients */
+	struct {
+		char *title;
+		char *app_id;
+	} sent;
 };
 
 void ext_foreign_toplevel_init(struct ext_foreign_toplevel *ext_toplevel,
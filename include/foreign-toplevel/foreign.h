@@ -5,9 +5,33 @@
 struct view;
 struct foreign_toplevel;
 
+/*
+ * State changes of a view are accumulated and sent to clients once per
+ * event loop iteration, see the *-foreign implementations.
+ */
+enum foreign_dirty {
+	FOREIGN_DIRTY_APP_ID = 1 << 0,
+	FOREIGN_DIRTY_TITLE = 1 << 1,
+	FOREIGN_DIRTY_OUTPUTS = 1 << 2,
+	FOREIGN_DIRTY_MAXIMIZED = 1 << 3,
+	FOREIGN_DIRTY_MINIMIZED = 1 << 4,
+	FOREIGN_DIRTY_FULLSCREEN = 1 << 5,
+	FOREIGN_DIRTY_ACTIVATED = 1 << 6,
+	FOREIGN_DIRTY_ALL = (1 << 7) - 1,
+};
+
 struct foreign_toplevel *foreign_toplevel_create(struct view *view);
 void foreign_toplevel_set_parent(struct foreign_toplevel *toplevel,
 	struct foreign_toplevel *parent);
 void foreign_toplevel_destroy(struct foreign_toplevel *toplevel);
 
+/**
+ * foreign_toplevel_count_updates() - account for a batch of updates
+ * @nr_updates: number of view state changes accumulated in the batch
+ * @nr_sent: number of those actually sent to clients
+ *
+ * The totals are logged at debug level from time to time.
+ */
+void foreign_toplevel_count_updates(int nr_updates, int nr_sent);
+
 #endif /* LABWC_FOREIGN_TOPLEVEL_H */
@@ -2,6 +2,8 @@
 #ifndef LABWC_WLR_FOREIGN_TOPLEVEL_H
 #define LABWC_WLR_FOREIGN_TOPLEVEL_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <wayland-server-core.h>
 
 struct wlr_foreign_toplevel {
@@ -28,6 +30,22 @@ struct wlr_foreign_toplevel {
 		struct wl_listener fullscreened;
 		struct wl_listener activated;
 	} on_view;
+
+	/* Changes not yet sent, enum foreign_dirty bits */
+	uint32_t dirty;
+	int nr_updates;
+	bool activated;
+	struct wl_event_source *flush_idle;
+
+	/* State last sent to clients */
+	struct {
+		char *title;
+		char *app_id;
+		bool maximized;
+		bool minimized;
+		bool fullscreen;
+		bool activated;
+	} sent;
 };
 
 void wlr_foreign_toplevel_init(struct wlr_foreign_toplevel *wlr_toplevel,
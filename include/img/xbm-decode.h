@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_XBM_DECODE_H
+#define LABWC_XBM_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * xbm_decode() - decode an XBM image
+ * @data: file contents, which need not be NUL-terminated
+ * @len: length of @data
+ * @color: ARGB32 color of set bits, other pixels are transparent
+ * @width: receives the image width
+ * @height: receives the image height
+ *
+ * The data is parsed in a single pass without copying, so it can come
+ * straight from file_map().
+ *
+ * Return: newly allocated ARGB32 pixels with a stride of @width * 4, or
+ * NULL if the data is not a valid XBM image
+ */
+uint32_t *xbm_decode(const char *data, size_t len, uint32_t color,
+	int *width, int *height);
+
+#endif /* LABWC_XBM_DECODE_H */
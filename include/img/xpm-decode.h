@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_XPM_DECODE_H
+#define LABWC_XPM_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * xpm_decode() - decode an XPM image
+ * @data: file contents, which need not be NUL-terminated
+ * @len: length of @data
+ * @width: receives the image width
+ * @height: receives the image height
+ *
+ * The data is parsed in a single pass without copying, so it can come
+ * straight from file_map().
+ *
+ * Return: newly allocated ARGB32 pixels with a stride of @width * 4, or
+ * NULL if the data is not a valid XPM image
+ */
+uint32_t *xpm_decode(const char *data, size_t len, int *width, int *height);
+
+#endif /* LABWC_XPM_DECODE_H */
@@ -255,6 +255,8 @@ struct server {
 	/* Workspaces */
 	struct {
 		struct wl_list all;  /* struct workspace.link */
+		/* struct view.omnipresent_link, front to back */
+		struct wl_list omnipresent_views;
 		struct workspace *current;
 		struct workspace *last;
 		struct wlr_ext_workspace_manager_v1 *ext_manager;
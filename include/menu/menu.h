@@ -3,6 +3,7 @@
 #define LABWC_MENU_H
 
 #include <wayland-server.h>
+#include "common/buf.h"
 
 /* forward declare arguments */
 struct view;
@@ -11,6 +12,7 @@ struct wl_list;
 struct wlr_scene_tree;
 struct wlr_scene_node;
 struct scaled_font_buffer;
+struct lab_scene_rect;
 
 enum menuitem_type {
 	LAB_MENU_ITEM = 0,
@@ -29,8 +31,11 @@ struct menuitem {
 	bool selectable;
 	bool use_markup;
 	enum menuitem_type type;
-	int native_width;
-	struct wlr_scene_tree *tree;
+	int native_width; /* -1 until the menu is first shown */
+	/* Position within the menu content and height, set by menu_layout() */
+	int y;
+	int height;
+	struct wlr_scene_tree *tree; /* NULL while not in view */
 	struct wlr_scene_tree *normal_tree;
 	struct wlr_scene_tree *selected_tree;
 	struct view *client_list_view;  /* used by internal client-list */
@@ -45,17 +50,28 @@ struct menu {
 	char *execute;
 	struct menu *parent;
 	struct menu_pipe_context *pipe_ctx;
+	/* Output of the pipemenu command, see <menu cache=""> */
+	struct {
+		int ttl; /* in ms, 0 if caching is disabled */
+		struct buf output;
+		double updated; /* CLOCK_MONOTONIC time in ms */
+	} pipe_cache;
 
 	struct {
 		int width;
 		int height;
 	} size;
+	/* Height of all items, may exceed size.height on small outputs */
+	int content_height;
+	int scroll;
+	int arrow_width;
 	struct wl_list menuitems;
 	struct {
 		struct menu *menu;
 		struct menuitem *item;
 	} selection;
 	struct wlr_scene_tree *scene_tree;
+	struct lab_scene_rect *bg_rect;
 	bool is_pipemenu_child;
 	bool align_left;
 	bool has_icons;
@@ -114,6 +130,17 @@ void menu_open_root(struct menu *menu, int x, int y);
  */
 void menu_process_cursor_motion(struct wlr_scene_node *node);
 
+/**
+ * menu_process_cursor_axis - scroll a menu taller than its output
+ *
+ * @node scene node of the menu item under the cursor
+ * @steps number of wheel steps to scroll by, negative to scroll up
+ *
+ * Return: false if the menu fits on its output and cannot be scrolled,
+ * in which case the event should be handled as usual.
+ */
+bool menu_process_cursor_axis(struct wlr_scene_node *node, int steps);
+
 /**
  *  menu_close_root - close root menu
  *
@@ -16,7 +16,17 @@ struct output {
 	struct wlr_scene_tree *layer_popup_tree;
 	struct wlr_scene_tree *cycle_osd_tree;
 	struct wlr_scene_tree *session_lock_tree;
-	struct wlr_scene_buffer *workspace_osd;
+
+	/* Kept while hidden, rebuilt by workspaces_reconfigure() */
+	struct {
+		struct wlr_scene_tree *tree;
+		/* One child per workspace, in order of server.workspaces.all */
+		struct wlr_scene_tree *boxes; /* may be NULL */
+		struct wlr_scene_tree *labels;
+		struct wlr_scene_rect *active_box; /* may be NULL */
+		int width;
+		int height;
+	} workspace_osd;
 
 	/* In output-relative scene coordinates */
 	struct wlr_box usable_area;
@@ -29,6 +29,11 @@ struct scaled_icon_buffer {
 
 	int width;
 	int height;
+
+	/* Private */
+	struct icon_request *request; /* pending asynchronous load */
+	struct wl_list request_link; /* icon_request.waiters */
+	struct wl_list link; /* all_icon_buffers */
 };
 
 /*
@@ -36,6 +41,9 @@ struct scaled_icon_buffer {
  * display. It gets destroyed automatically when the backing scaled_buffer
  * is being destroyed which in turn happens automatically when the backing
  * wlr_scene_buffer (or one of its parents) is being destroyed.
+ *
+ * Icons are looked up and rendered asynchronously, so the buffer stays
+ * empty until the icon has been loaded.
  */
 struct scaled_icon_buffer *scaled_icon_buffer_create(
 	struct wlr_scene_tree *parent, int width, int height);
@@ -64,4 +64,22 @@ struct scaled_img_buffer {
 struct scaled_img_buffer *scaled_img_buffer_create(struct wlr_scene_tree *parent,
 	struct lab_img *img, int width, int height);
 
+/*
+ * Replace the image shown by an existing image buffer, keeping its scene
+ * node. This is a no-op if @img draws the same content as the current image.
+ * Otherwise the backing buffer is shared with another scaled_img_buffer
+ * that already shows @img at the same scale, taken from the cache of
+ * recently rendered images or rendered.
+ *
+ * Like scaled_img_buffer_create(), @img is cloned.
+ */
+void scaled_img_buffer_update(struct scaled_img_buffer *self,
+	struct lab_img *img);
+
+/*
+ * Release the cache of recently rendered images, e.g. when the theme
+ * images are destroyed. Buffers still shown are kept alive by their nodes.
+ */
+void scaled_img_buffer_clear_cache(void);
+
 #endif /* LABWC_SCALED_IMG_BUFFER_H */
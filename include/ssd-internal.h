@@ -17,36 +17,33 @@ struct ssd_state_title_width {
  * type of each node (enum lab_node_type, stored in the node_descriptor
  * attached to the wlr_scene_node).
  *
+ * There is only one set of nodes per decoration. Switching between the
+ * active and inactive state (and between hover/toggled/rounded states of
+ * buttons) swaps the buffers and colors of the existing nodes in place,
+ * which keeps the scene-graph small when there are many windows. The
+ * only exception is the title: rendering it is expensive, so there is one
+ * title node per active state and (de)activation just toggles them.
+ *
  * ssd->tree (LAB_NODE_SSD_ROOT)
  * +--titlebar (LAB_NODE_TITLEBAR)
- * |  +--inactive
- * |  |  +--background bar
- * |  |  +--left corner
- * |  |  +--right corner
- * |  |  +--title (LAB_NODE_TITLE)
- * |  |  +--iconify button (LAB_NODE_BUTTON_ICONIFY)
- * |  |  |  +--normal close icon image
- * |  |  |  +--hovered close icon image
- * |  |  |  +--...
- * |  |  +--window icon (LAB_NODE_BUTTON_WINDOW_ICON)
- * |  |  |  +--window icon image
- * |  |  +--...
- * |  +--active
- * |     +--...
+ * |  +--background bar
+ * |  +--left corner
+ * |  +--right corner
+ * |  +--inactive title (LAB_NODE_TITLE)
+ * |  +--active title (LAB_NODE_TITLE)
+ * |  +--iconify button (LAB_NODE_BUTTON_ICONIFY)
+ * |  |  +--hitbox
+ * |  |  +--icon image
+ * |  +--window icon (LAB_NODE_BUTTON_WINDOW_ICON)
+ * |  |  +--hitbox
+ * |  |  +--window icon image
+ * |  +--...
  * +--border
- * |  +--inactive
- * |  |  +--top
- * |  |  +--...
- * |  +--active
- * |     +--top
- * |     +--...
+ * |  +--top
+ * |  +--...
  * +--shadow
- * |  +--inactive
- * |  |  +--top
- * |  |  +--...
- * |  +--active
- * |     +--top
- * |     +--...
+ * |  +--top
+ * |  +--...
  * +--extents
  *    +--top
  *    +--...
@@ -80,6 +77,10 @@ struct ssd {
 		 */
 		bool was_squared;
 
+		/* Buffers and colors are swapped on (de)activation */
+		enum ssd_active_state active;
+		bool keybind_inhibit_indicator;
+
 		struct wlr_box geometry;
 		struct ssd_state_title {
 			char *text;
@@ -98,33 +99,26 @@ struct ssd {
 	struct ssd_titlebar_scene {
 		int height;
 		struct wlr_scene_tree *tree;
-		struct ssd_titlebar_subtree {
-			struct wlr_scene_tree *tree;
-			struct wlr_scene_buffer *corner_left;
-			struct wlr_scene_buffer *corner_right;
-			struct wlr_scene_buffer *bar;
-			struct scaled_font_buffer *title;
-			struct wl_list buttons_left; /* ssd_button.link */
-			struct wl_list buttons_right; /* ssd_button.link */
-		} subtrees[2]; /* indexed by enum ssd_active_state */
+		struct wlr_scene_buffer *corner_left;
+		struct wlr_scene_buffer *corner_right;
+		struct wlr_scene_buffer *bar;
+		/* indexed by enum ssd_active_state */
+		struct scaled_font_buffer *title[2];
+		struct wl_list buttons_left; /* ssd_button.link */
+		struct wl_list buttons_right; /* ssd_button.link */
 	} titlebar;
 
 	/* Borders allow resizing as well */
 	struct ssd_border_scene {
 		struct wlr_scene_tree *tree;
-		struct ssd_border_subtree {
-			struct wlr_scene_tree *tree;
-			struct wlr_scene_rect *top, *bottom, *left, *right;
-		} subtrees[2]; /* indexed by enum ssd_active_state */
+		struct wlr_scene_rect *top, *bottom, *left, *right;
 	} border;
 
 	struct ssd_shadow_scene {
 		struct wlr_scene_tree *tree;
-		struct ssd_shadow_subtree {
-			struct wlr_scene_tree *tree;
-			struct wlr_scene_buffer *top, *bottom, *left, *right,
-				*top_left, *top_right, *bottom_left, *bottom_right;
-		} subtrees[2]; /* indexed by enum ssd_active_state */
+		/* NULL if shadows are disabled for both active states */
+		struct wlr_scene_buffer *top, *bottom, *left, *right,
+			*top_left, *top_right, *bottom_left, *bottom_right;
 	} shadow;
 
 	/*
@@ -145,18 +139,21 @@ struct ssd_button {
 	 */
 	uint8_t state_set;
 	/*
-	 * Image buffers for each combination of hover/toggled/rounded states.
-	 * img_buffers[state_set] is displayed. Some of these can be NULL
-	 * (e.g. img_buffers[LAB_BS_ROUNDED] is set only for corner buttons).
-	 *
-	 * When the button type is LAB_NODE_BUTTON_WINDOW_ICON,
-	 * these are all NULL and window_icon is used instead.
+	 * Images for each combination of hover/toggled/rounded states of the
+	 * current active state, owned by the theme. imgs[state_set] is shown
+	 * in img_buffer. Some of these can be NULL (e.g. imgs[LAB_BS_ROUNDED]
+	 * is set only for corner buttons), in which case img_buffer is hidden.
 	 */
-	struct scaled_img_buffer *img_buffers[LAB_BS_ALL + 1];
+	struct lab_img **imgs;
+	struct scaled_img_buffer *img_buffer;
 
+	/*
+	 * When the button type is LAB_NODE_BUTTON_WINDOW_ICON, imgs and
+	 * img_buffer are NULL and window_icon is used instead.
+	 */
 	struct scaled_icon_buffer *window_icon;
 
-	struct wl_list link; /* ssd_titlebar_subtree.buttons_{left,right} */
+	struct wl_list link; /* ssd_titlebar_scene.buttons_{left,right} */
 };
 
 struct wlr_buffer;
@@ -167,15 +164,21 @@ struct ssd_button *attach_ssd_button(struct wl_list *button_parts,
 	enum lab_node_type type, struct wlr_scene_tree *parent,
 	struct lab_img *imgs[LAB_BS_ALL + 1], int x, int y,
 	struct view *view);
+void ssd_button_set_imgs(struct ssd_button *button,
+	struct lab_img *imgs[LAB_BS_ALL + 1]);
+void ssd_button_update_state(struct ssd_button *button,
+	enum lab_button_state state, bool enable);
 
 /* SSD internal */
 void ssd_titlebar_create(struct ssd *ssd);
 void ssd_titlebar_update(struct ssd *ssd);
+void ssd_titlebar_set_active(struct ssd *ssd);
 void ssd_titlebar_destroy(struct ssd *ssd);
 bool ssd_should_be_squared(struct ssd *ssd);
 
 void ssd_border_create(struct ssd *ssd);
 void ssd_border_update(struct ssd *ssd);
+void ssd_border_update_color(struct ssd *ssd);
 void ssd_border_destroy(struct ssd *ssd);
 
 void ssd_extents_create(struct ssd *ssd);
@@ -184,6 +187,7 @@ void ssd_extents_destroy(struct ssd *ssd);
 
 void ssd_shadow_create(struct ssd *ssd);
 void ssd_shadow_update(struct ssd *ssd);
+void ssd_shadow_set_active(struct ssd *ssd);
 void ssd_shadow_destroy(struct ssd *ssd);
 
 #endif /* LABWC_SSD_INTERNAL_H */
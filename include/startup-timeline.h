@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_STARTUP_TIMELINE_H
+#define LABWC_STARTUP_TIMELINE_H
+
+struct wlr_output;
+
+/*
+ * Records when each phase of startup has finished, relative to the
+ * start of main(). Once the first frame has been presented and
+ * autostart has been run, a summary is logged at info level and, if
+ * LABWC_STARTUP_TIMELINE is set to a path, appended to that file as a
+ * line of JSON.
+ */
+void startup_timeline_init(void);
+
+/**
+ * startup_timeline_mark() - record that a startup phase has finished
+ * @phase: name of the phase, must be a string literal
+ *
+ * Does nothing once the summary has been emitted.
+ */
+void startup_timeline_mark(const char *phase);
+
+/**
+ * startup_timeline_autostart_done() - mark that the autostart script and
+ * the startup command have been launched
+ */
+void startup_timeline_autostart_done(void);
+
+/**
+ * startup_timeline_watch_output() - mark an output modeset and wait for
+ * the first frame presented on that output
+ */
+void startup_timeline_watch_output(struct wlr_output *wlr_output);
+
+#endif /* LABWC_STARTUP_TIMELINE_H */
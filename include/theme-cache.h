@@ -0,0 +1,42 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_THEME_CACHE_H
+#define LABWC_THEME_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct lab_data_buffer;
+
+/*
+ * On-disk cache of pre-rendered theme buffers, stored as premultiplied
+ * ARGB32 pixel data in $XDG_CACHE_HOME/labwc/theme-assets.
+ *
+ * The cache holds one set of buffers for the last theme it was written
+ * for, identified by @key which the caller derives from all inputs that
+ * affect the rendered buffers. A slot can be NULL (for example if shadows
+ * are disabled) and is restored as NULL.
+ */
+
+/**
+ * theme_cache_load() - restore buffers from the cache
+ * @key: hash of everything the buffers depend on
+ * @slots: array of pointers to be set to the cached buffers
+ * @nr_slots: number of elements in @slots
+ *
+ * Return: true if the cache matched @key and all slots were set,
+ * false otherwise, in which case @slots are left untouched.
+ */
+bool theme_cache_load(uint64_t key, struct lab_data_buffer **slots[],
+	size_t nr_slots);
+
+/**
+ * theme_cache_save() - replace the cache with the given buffers
+ * @key: hash of everything the buffers depend on
+ * @slots: array of pointers to buffers to be stored
+ * @nr_slots: number of elements in @slots
+ */
+void theme_cache_save(uint64_t key, struct lab_data_buffer **slots[],
+	size_t nr_slots);
+
+#endif /* LABWC_THEME_CACHE_H */
@@ -0,0 +1,27 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+#ifndef LABWC_TOPLEVEL_CAPTURE_H
+#define LABWC_TOPLEVEL_CAPTURE_H
+
+struct view;
+
+/*
+ * Capture of single views for ext-foreign-toplevel-image-capture-source,
+ * as used by screen sharing portals.
+ *
+ * Each view has its own wlr_scene (view->capture.scene) that mirrors its
+ * surfaces. wlroots renders that scene into a swapchain of its own only
+ * when a frame has been requested and the view has been damaged, so a
+ * static window costs nothing while it is being shared.
+ *
+ * The frame rate and the damaged area per frame are logged at debug level
+ * every minute while frames are produced and at info level when the view
+ * is destroyed. Rendering and copying frames happens inside wlroots and is
+ * not timed; the damaged area stands in for that cost instead.
+ */
+void toplevel_capture_init(void);
+void toplevel_capture_finish(void);
+
+/* Called by view_destroy() before the capture scene is destroyed */
+void toplevel_capture_view_destroy(struct view *view);
+
+#endif /* LABWC_TOPLEVEL_CAPTURE_H */
@@ -138,6 +138,12 @@ struct view {
 	enum view_type type;
 	const struct view_impl *impl;
 	struct wl_list link;
+	/* struct workspace.views, in the same order as server.views */
+	struct wl_list workspace_link;
+	/* server.workspaces.omnipresent_views, if visible_on_all_workspaces */
+	struct wl_list omnipresent_link;
+	/* Higher values are closer to the front of server.views */
+	int64_t stacking_order;
 
 	/* This is cleared when the view is not in the cycle list */
 	struct wl_list cycle_link;
@@ -179,8 +185,8 @@ struct view {
 
 	struct {
 		struct wlr_scene *scene;
-		struct wlr_ext_image_capture_source_v1 *source;
-		struct wl_listener on_capture_source_destroy;
+		/* NULL until the view is captured for the first time */
+		struct toplevel_capture *source;
 	} capture;
 
 	bool mapped;
@@ -440,6 +446,16 @@ struct view *view_prev(struct wl_list *head, struct view *view,
 void view_array_append(struct wl_array *views,
 	enum lab_view_criteria criteria);
 
+/**
+ * view_add_to_stack() - put a newly created view in front of all others
+ * @view: view whose workspace has already been set
+ *
+ * Adds the view to server.views and to the view list of its workspace,
+ * which are kept in the same order by view_move_to_front(),
+ * view_move_to_back() and view_move_to_workspace().
+ */
+void view_add_to_stack(struct view *view);
+
 enum view_wants_focus view_wants_focus(struct view *view);
 
 /* If view is NULL, the size of SSD is not considered */
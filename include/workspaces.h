@@ -14,6 +14,8 @@ struct workspace {
 	struct wl_list link; /* struct server.workspaces */
 
 	char *name;
+	/* struct view.workspace_link, front to back, omnipresent views included */
+	struct wl_list views;
 	struct wlr_scene_tree *tree;
 	struct wlr_scene_tree *view_trees[3];
 
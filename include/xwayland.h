@@ -40,6 +40,8 @@ struct xwayland_view {
 	struct wlr_xwayland_surface *xwayland_surface;
 	bool focused_before_map;
 	bool initial_geometry_set;
+	/* Hash of the last _NET_WM_ICON data, 0 if none */
+	uint64_t icon_hash;
 
 	/* Events unique to XWayland views */
 	struct wl_listener associate;
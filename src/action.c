@@ -47,7 +47,7 @@ enum action_arg_type {
 struct action_arg {
 	struct wl_list link;        /* struct action.args */
 
-	char *key;                  /* May be NULL if there is just one arg */
+	enum action_arg_key key;
 	enum action_arg_type type;
 };
 
@@ -179,75 +179,125 @@ const char *action_names[] = {
 
 #undef ACTION_TYPE_LIST
 
+static const char *const action_arg_names[] = {
+	[ACTION_ARG_INVALID] = "INVALID",
+	[ACTION_ARG_COMMAND] = "command",
+	[ACTION_ARG_DIRECTION] = "direction",
+	[ACTION_ARG_SNAP_WINDOWS] = "snapWindows",
+	[ACTION_ARG_COMBINE] = "combine",
+	[ACTION_ARG_WORKSPACE] = "workspace",
+	[ACTION_ARG_OUTPUT] = "output",
+	[ACTION_ARG_IDENTIFIER] = "identifier",
+	[ACTION_ARG_MENU] = "menu",
+	[ACTION_ARG_AT_CURSOR] = "atCursor",
+	[ACTION_ARG_X_POSITION] = "x.position",
+	[ACTION_ARG_Y_POSITION] = "y.position",
+	[ACTION_ARG_DECORATIONS] = "decorations",
+	[ACTION_ARG_FORCE_SSD] = "forceSSD",
+	[ACTION_ARG_LEFT] = "left",
+	[ACTION_ARG_RIGHT] = "right",
+	[ACTION_ARG_TOP] = "top",
+	[ACTION_ARG_BOTTOM] = "bottom",
+	[ACTION_ARG_X] = "x",
+	[ACTION_ARG_Y] = "y",
+	[ACTION_ARG_WIDTH] = "width",
+	[ACTION_ARG_HEIGHT] = "height",
+	[ACTION_ARG_FOLLOW] = "follow",
+	[ACTION_ARG_TO] = "to",
+	[ACTION_ARG_WRAP] = "wrap",
+	[ACTION_ARG_TOGGLE] = "toggle",
+	[ACTION_ARG_REGION] = "region",
+	[ACTION_ARG_OUTPUT_NAME] = "output_name",
+	[ACTION_ARG_POLICY] = "policy",
+	[ACTION_ARG_MESSAGE_PROMPT] = "message.prompt",
+	[ACTION_ARG_QUERY] = "query",
+	[ACTION_ARG_THEN] = "then",
+	[ACTION_ARG_ELSE] = "else",
+	[ACTION_ARG_NONE] = "none",
+};
+
+static enum action_arg_key
+action_arg_key_parse(const char *name)
+{
+	for (size_t i = 1; i < ARRAY_SIZE(action_arg_names); i++) {
+		if (!strcasecmp(name, action_arg_names[i])) {
+			return i;
+		}
+	}
+	return ACTION_ARG_INVALID;
+}
+
 void
-action_arg_add_str(struct action *action, const char *key, const char *value)
+action_arg_add_str(struct action *action, enum action_arg_key key,
+		const char *value)
 {
 	assert(action);
 	assert(key);
 	assert(value && "Tried to add NULL action string argument");
 	struct action_arg_str *arg = znew(*arg);
 	arg->base.type = LAB_ACTION_ARG_STR;
-	arg->base.key = xstrdup(key);
+	arg->base.key = key;
 	arg->value = xstrdup(value);
 	wl_list_append(&action->args, &arg->base.link);
 }
 
 static void
-action_arg_add_bool(struct action *action, const char *key, bool value)
+action_arg_add_bool(struct action *action, enum action_arg_key key, bool value)
 {
 	assert(action);
 	assert(key);
 	struct action_arg_bool *arg = znew(*arg);
 	arg->base.type = LAB_ACTION_ARG_BOOL;
-	arg->base.key = xstrdup(key);
+	arg->base.key = key;
 	arg->value = value;
 	wl_list_append(&action->args, &arg->base.link);
 }
 
 static void
-action_arg_add_int(struct action *action, const char *key, int value)
+action_arg_add_int(struct action *action, enum action_arg_key key, int value)
 {
 	assert(action);
 	assert(key);
 	struct action_arg_int *arg = znew(*arg);
 	arg->base.type = LAB_ACTION_ARG_INT;
-	arg->base.key = xstrdup(key);
+	arg->base.key = key;
 	arg->value = value;
 	wl_list_append(&action->args, &arg->base.link);
 }
 
 static void
-action_arg_add_list(struct action *action, const char *key, enum action_arg_type type)
+action_arg_add_list(struct action *action, enum action_arg_key key,
+		enum action_arg_type type)
 {
 	assert(action);
 	assert(key);
 	struct action_arg_list *arg = znew(*arg);
 	arg->base.type = type;
-	arg->base.key = xstrdup(key);
+	arg->base.key = key;
 	wl_list_init(&arg->value);
 	wl_list_append(&action->args, &arg->base.link);
 }
 
 void
-action_arg_add_querylist(struct action *action, const char *key)
+action_arg_add_querylist(struct action *action, enum action_arg_key key)
 {
 	action_arg_add_list(action, key, LAB_ACTION_ARG_QUERY_LIST);
 }
 
 void
-action_arg_add_actionlist(struct action *action, const char *key)
+action_arg_add_actionlist(struct action *action, enum action_arg_key key)
 {
 	action_arg_add_list(action, key, LAB_ACTION_ARG_ACTION_LIST);
 }
 
 static void *
-action_get_arg(struct action *action, const char *key, enum action_arg_type type)
+action_get_arg(struct action *action, enum action_arg_key key,
+		enum action_arg_type type)
 {
 	assert(action);
-	assert(key);
 	struct action_arg *arg;
 	wl_list_for_each(arg, &action->args, link) {
-		if (!strcasecmp(key, arg->key) && arg->type == type) {
+		if (arg->key == key && arg->type == type) {
 			return arg;
 		}
 	}
@@ -255,35 +305,38 @@ action_get_arg(struct action *action, const char *key, enum action_arg_type type
 }
 
 const char *
-action_get_str(struct action *action, const char *key, const char *default_value)
+action_get_str(struct action *action, enum action_arg_key key,
+		const char *default_value)
 {
 	struct action_arg_str *arg = action_get_arg(action, key, LAB_ACTION_ARG_STR);
 	return arg ? arg->value : default_value;
 }
 
 static bool
-action_get_bool(struct action *action, const char *key, bool default_value)
+action_get_bool(struct action *action, enum action_arg_key key,
+		bool default_value)
 {
 	struct action_arg_bool *arg = action_get_arg(action, key, LAB_ACTION_ARG_BOOL);
 	return arg ? arg->value : default_value;
 }
 
 static int
-action_get_int(struct action *action, const char *key, int default_value)
+action_get_int(struct action *action, enum action_arg_key key,
+		int default_value)
 {
 	struct action_arg_int *arg = action_get_arg(action, key, LAB_ACTION_ARG_INT);
 	return arg ? arg->value : default_value;
 }
 
 struct wl_list *
-action_get_querylist(struct action *action, const char *key)
+action_get_querylist(struct action *action, enum action_arg_key key)
 {
 	struct action_arg_list *arg = action_get_arg(action, key, LAB_ACTION_ARG_QUERY_LIST);
 	return arg ? &arg->value : NULL;
 }
 
 struct wl_list *
-action_get_actionlist(struct action *action, const char *key)
+action_get_actionlist(struct action *action, enum action_arg_key key)
 {
 	struct action_arg_list *arg = action_get_arg(action, key, LAB_ACTION_ARG_ACTION_LIST);
 	return arg ? &arg->value : NULL;
@@ -296,6 +349,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 
 	char *argument = xstrdup(nodename);
 	string_truncate_at_pattern(argument, ".action");
+	enum action_arg_key key = action_arg_key_parse(argument);
 
 	switch (action->type) {
 	case ACTION_TYPE_EXECUTE:
@@ -305,7 +359,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 		 * compatibility with old openbox-menu generators
 		 */
 		if (!strcmp(argument, "command") || !strcmp(argument, "execute")) {
-			action_arg_add_str(action, "command", content);
+			action_arg_add_str(action, ACTION_ARG_COMMAND, content);
 			goto cleanup;
 		}
 		break;
@@ -322,19 +376,19 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 				wlr_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
 			} else {
-				action_arg_add_int(action, argument, edge);
+				action_arg_add_int(action, key, edge);
 			}
 			goto cleanup;
 		}
 		if (action->type == ACTION_TYPE_MOVE_TO_EDGE
 				&& !strcasecmp(argument, "snapWindows")) {
-			action_arg_add_bool(action, argument, parse_bool(content, true));
+			action_arg_add_bool(action, key, parse_bool(content, true));
 			goto cleanup;
 		}
 		if ((action->type == ACTION_TYPE_SNAP_TO_EDGE
 					|| action->type == ACTION_TYPE_TOGGLE_SNAP_TO_EDGE)
 				&& !strcasecmp(argument, "combine")) {
-			action_arg_add_bool(action, argument, parse_bool(content, false));
+			action_arg_add_bool(action, key, parse_bool(content, false));
 			goto cleanup;
 		}
 		break;
@@ -344,9 +398,9 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 	case ACTION_TYPE_PREVIOUS_WINDOW_IMMEDIATE:
 		if (!strcasecmp(argument, "workspace")) {
 			if (!strcasecmp(content, "all")) {
-				action_arg_add_int(action, argument, CYCLE_WORKSPACE_ALL);
+				action_arg_add_int(action, key, CYCLE_WORKSPACE_ALL);
 			} else if (!strcasecmp(content, "current")) {
-				action_arg_add_int(action, argument, CYCLE_WORKSPACE_CURRENT);
+				action_arg_add_int(action, key, CYCLE_WORKSPACE_CURRENT);
 			} else {
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
@@ -355,11 +409,11 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 		}
 		if (!strcasecmp(argument, "output")) {
 			if (!strcasecmp(content, "all")) {
-				action_arg_add_int(action, argument, CYCLE_OUTPUT_ALL);
+				action_arg_add_int(action, key, CYCLE_OUTPUT_ALL);
 			} else if (!strcasecmp(content, "cursor")) {
-				action_arg_add_int(action, argument, CYCLE_OUTPUT_CURSOR);
+				action_arg_add_int(action, key, CYCLE_OUTPUT_CURSOR);
 			} else if (!strcasecmp(content, "focused")) {
-				action_arg_add_int(action, argument, CYCLE_OUTPUT_FOCUSED);
+				action_arg_add_int(action, key, CYCLE_OUTPUT_FOCUSED);
 			} else {
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
@@ -368,9 +422,9 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 		}
 		if (!strcasecmp(argument, "identifier")) {
 			if (!strcasecmp(content, "all")) {
-				action_arg_add_int(action, argument, CYCLE_APP_ID_ALL);
+				action_arg_add_int(action, key, CYCLE_APP_ID_ALL);
 			} else if (!strcasecmp(content, "current")) {
-				action_arg_add_int(action, argument, CYCLE_APP_ID_CURRENT);
+				action_arg_add_int(action, key, CYCLE_APP_ID_CURRENT);
 			} else {
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
@@ -380,19 +434,19 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 		break;
 	case ACTION_TYPE_SHOW_MENU:
 		if (!strcmp(argument, "menu")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		if (!strcasecmp(argument, "atCursor")) {
-			action_arg_add_bool(action, argument, parse_bool(content, true));
+			action_arg_add_bool(action, key, parse_bool(content, true));
 			goto cleanup;
 		}
 		if (!strcasecmp(argument, "x.position")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		if (!strcasecmp(argument, "y.position")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		break;
@@ -405,7 +459,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
 			} else {
-				action_arg_add_int(action, argument, axis);
+				action_arg_add_int(action, key, axis);
 			}
 			goto cleanup;
 		}
@@ -414,7 +468,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 		if (!strcmp(argument, "decorations")) {
 			enum lab_ssd_mode mode = ssd_mode_parse(content);
 			if (mode != LAB_SSD_MODE_INVALID) {
-				action_arg_add_int(action, argument, mode);
+				action_arg_add_int(action, key, mode);
 			} else {
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
@@ -422,7 +476,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 			goto cleanup;
 		}
 		if (!strcasecmp(argument, "forceSSD")) {
-			action_arg_add_bool(action, argument, parse_bool(content, false));
+			action_arg_add_bool(action, key, parse_bool(content, false));
 			goto cleanup;
 		}
 		break;
@@ -435,7 +489,7 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 					"Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
 			} else {
-				action_arg_add_int(action, argument, edge);
+				action_arg_add_int(action, key, edge);
 			}
 			goto cleanup;
 		}
@@ -443,55 +497,55 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 	case ACTION_TYPE_RESIZE_RELATIVE:
 		if (!strcmp(argument, "left") || !strcmp(argument, "right") ||
 				!strcmp(argument, "top") || !strcmp(argument, "bottom")) {
-			action_arg_add_int(action, argument, atoi(content));
+			action_arg_add_int(action, key, atoi(content));
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_MOVETO:
 	case ACTION_TYPE_MOVE_RELATIVE:
 		if (!strcmp(argument, "x") || !strcmp(argument, "y")) {
-			action_arg_add_int(action, argument, atoi(content));
+			action_arg_add_int(action, key, atoi(content));
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_RESIZETO:
 		if (!strcmp(argument, "width") || !strcmp(argument, "height")) {
-			action_arg_add_int(action, argument, atoi(content));
+			action_arg_add_int(action, key, atoi(content));
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_SEND_TO_DESKTOP:
 		if (!strcmp(argument, "follow")) {
-			action_arg_add_bool(action, argument, parse_bool(content, true));
+			action_arg_add_bool(action, key, parse_bool(content, true));
 			goto cleanup;
 		}
 		/* Falls through to GoToDesktop */
 	case ACTION_TYPE_GO_TO_DESKTOP:
 		if (!strcmp(argument, "to")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		if (!strcmp(argument, "wrap")) {
-			action_arg_add_bool(action, argument, parse_bool(content, true));
+			action_arg_add_bool(action, key, parse_bool(content, true));
 			goto cleanup;
 		}
 		if (!strcmp(argument, "toggle")) {
 			action_arg_add_bool(
-				action, argument, parse_bool(content, false));
+				action, key, parse_bool(content, false));
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_TOGGLE_SNAP_TO_REGION:
 	case ACTION_TYPE_SNAP_TO_REGION:
 		if (!strcmp(argument, "region")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_FOCUS_OUTPUT:
 	case ACTION_TYPE_MOVE_TO_OUTPUT:
 		if (!strcmp(argument, "output")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		if (!strcmp(argument, "direction")) {
@@ -501,19 +555,19 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 					action_names[action->type], argument, content);
 			} else {
-				action_arg_add_int(action, argument, edge);
+				action_arg_add_int(action, key, edge);
 			}
 			goto cleanup;
 		}
 		if (!strcmp(argument, "wrap")) {
-			action_arg_add_bool(action, argument, parse_bool(content, false));
+			action_arg_add_bool(action, key, parse_bool(content, false));
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_VIRTUAL_OUTPUT_ADD:
 	case ACTION_TYPE_VIRTUAL_OUTPUT_REMOVE:
 		if (!strcmp(argument, "output_name")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		break;
@@ -525,20 +579,20 @@ action_arg_from_xml_node(struct action *action, const char *nodename, const char
 				nag_log(WLR_ERROR, "Invalid argument for action %s: '%s' (%s)",
 						action_names[action->type], argument, content);
 			} else {
-				action_arg_add_int(action, argument, policy);
+				action_arg_add_int(action, key, policy);
 			}
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_WARP_CURSOR:
 		if (!strcmp(argument, "to") || !strcmp(argument, "x") || !strcmp(argument, "y")) {
-			action_arg_add_str(action, argument, content);
+			action_arg_add_str(action, key, content);
 			goto cleanup;
 		}
 		break;
 	case ACTION_TYPE_IF:
 		if (!strcmp(argument, "message.prompt")) {
-			action_arg_add_str(action, "message.prompt", content);
+			action_arg_add_str(action, ACTION_ARG_MESSAGE_PROMPT, content);
 		}
 		goto cleanup;
 	}
@@ -610,13 +664,16 @@ action_list_is_valid(struct wl_list *actions)
 static bool
 action_branches_are_valid(struct action *action)
 {
-	static const char * const branches[] = { "then", "else", "none" };
+	static const enum action_arg_key branches[] = {
+		ACTION_ARG_THEN, ACTION_ARG_ELSE, ACTION_ARG_NONE
+	};
 	for (size_t i = 0; i < ARRAY_SIZE(branches); i++) {
 		struct wl_list *children =
 			action_get_actionlist(action, branches[i]);
 		if (children && !action_list_is_valid(children)) {
 			wlr_log(WLR_ERROR, "Invalid action in %s '%s' branch",
-				action_names[action->type], branches[i]);
+				action_names[action->type],
+				action_arg_names[branches[i]]);
 			return false;
 		}
 	}
@@ -627,31 +684,31 @@ action_branches_are_valid(struct action *action)
 bool
 action_is_valid(struct action *action)
 {
-	const char *arg_name = NULL;
+	enum action_arg_key key = ACTION_ARG_INVALID;
 	enum action_arg_type arg_type = LAB_ACTION_ARG_STR;
 
 	switch (action->type) {
 	case ACTION_TYPE_EXECUTE:
-		arg_name = "command";
+		key = ACTION_ARG_COMMAND;
 		break;
 	case ACTION_TYPE_MOVE_TO_EDGE:
 	case ACTION_TYPE_TOGGLE_SNAP_TO_EDGE:
 	case ACTION_TYPE_SNAP_TO_EDGE:
 	case ACTION_TYPE_GROW_TO_EDGE:
 	case ACTION_TYPE_SHRINK_TO_EDGE:
-		arg_name = "direction";
+		key = ACTION_ARG_DIRECTION;
 		arg_type = LAB_ACTION_ARG_INT;
 		break;
 	case ACTION_TYPE_SHOW_MENU:
-		arg_name = "menu";
+		key = ACTION_ARG_MENU;
 		break;
 	case ACTION_TYPE_GO_TO_DESKTOP:
 	case ACTION_TYPE_SEND_TO_DESKTOP:
-		arg_name = "to";
+		key = ACTION_ARG_TO;
 		break;
 	case ACTION_TYPE_TOGGLE_SNAP_TO_REGION:
 	case ACTION_TYPE_SNAP_TO_REGION:
-		arg_name = "region";
+		key = ACTION_ARG_REGION;
 		break;
 	case ACTION_TYPE_IF:
 	case ACTION_TYPE_FOR_EACH:
@@ -661,12 +718,12 @@ action_is_valid(struct action *action)
 		return true;
 	}
 
-	if (action_get_arg(action, arg_name, arg_type)) {
+	if (action_get_arg(action, key, arg_type)) {
 		return true;
 	}
 
 	wlr_log(WLR_ERROR, "Missing required argument for %s: %s",
-		action_names[action->type], arg_name);
+		action_names[action->type], action_arg_names[key]);
 	return false;
 }
 
@@ -683,7 +740,6 @@ action_free(struct action *action)
 	struct action_arg *arg, *arg_tmp;
 	wl_list_for_each_safe(arg, arg_tmp, &action->args, link) {
 		wl_list_remove(&arg->link);
-		zfree(arg->key);
 		if (arg->type == LAB_ACTION_ARG_STR) {
 			struct action_arg_str *str_arg = (struct action_arg_str *)arg;
 			zfree(str_arg->value);
@@ -877,7 +933,7 @@ print_prompt_command(struct buf *buf, const char *format,
 		switch (*p) {
 		case 'm':
 			buf_add(buf, action_get_str(action,
-					"message.prompt", "Choose wisely"));
+					ACTION_ARG_MESSAGE_PROMPT, "Choose wisely"));
 			break;
 		case 'n':
 			buf_add(buf, _("No"));
@@ -956,12 +1012,12 @@ action_check_prompt_result(pid_t pid, int exit_code)
 		struct wl_list *actions = NULL;
 		if (exit_code == LAB_EXIT_SUCCESS) {
 			wlr_log(WLR_INFO, "Selected the 'then' branch");
-			actions = action_get_actionlist(prompt->action, "then");
+			actions = action_get_actionlist(prompt->action, ACTION_ARG_THEN);
 		} else if (exit_code == LAB_EXIT_CANCELLED) {
 			/* no-op */
 		} else {
 			wlr_log(WLR_INFO, "Selected the 'else' branch");
-			actions = action_get_actionlist(prompt->action, "else");
+			actions = action_get_actionlist(prompt->action, ACTION_ARG_ELSE);
 		}
 		if (actions) {
 			wlr_log(WLR_INFO, "Running actions");
@@ -980,7 +1036,7 @@ match_queries(struct view *view, struct action *action)
 {
 	assert(view);
 
-	struct wl_list *queries = action_get_querylist(action, "query");
+	struct wl_list *queries = action_get_querylist(action, ACTION_ARG_QUERY);
 	if (!queries) {
 		return true;
 	}
@@ -998,15 +1054,15 @@ match_queries(struct view *view, struct action *action)
 static struct output *
 get_target_output(struct output *output, struct action *action)
 {
-	const char *output_name = action_get_str(action, "output", NULL);
+	const char *output_name = action_get_str(action, ACTION_ARG_OUTPUT, NULL);
 	struct output *target = NULL;
 
 	if (output_name) {
 		target = output_from_name(output_name);
 	} else {
 		enum lab_edge edge =
-			action_get_int(action, "direction", LAB_EDGE_NONE);
-		bool wrap = action_get_bool(action, "wrap", false);
+			action_get_int(action, ACTION_ARG_DIRECTION, LAB_EDGE_NONE);
+		bool wrap = action_get_bool(action, ACTION_ARG_WRAP, false);
 		target = output_get_adjacent(output, edge, wrap);
 	}
 
@@ -1082,7 +1138,7 @@ run_action(struct view *view, struct action *action,
 		break;
 	case ACTION_TYPE_EXECUTE: {
 		struct buf cmd = BUF_INIT;
-		buf_add(&cmd, action_get_str(action, "command", NULL));
+		buf_add(&cmd, action_get_str(action, ACTION_ARG_COMMAND, NULL));
 		buf_expand_tilde(&cmd);
 		spawn_async_no_shell(cmd.data);
 		buf_reset(&cmd);
@@ -1094,8 +1150,9 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_MOVE_TO_EDGE:
 		if (view) {
 			/* Config parsing makes sure that direction is a valid direction */
-			enum lab_edge edge = action_get_int(action, "direction", 0);
-			bool snap_to_windows = action_get_bool(action, "snapWindows", true);
+			enum lab_edge edge = action_get_int(action, ACTION_ARG_DIRECTION, 0);
+			bool snap_to_windows = action_get_bool(action,
+				ACTION_ARG_SNAP_WINDOWS, true);
 			view_move_to_edge(view, edge, snap_to_windows);
 		}
 		break;
@@ -1103,7 +1160,7 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_SNAP_TO_EDGE:
 		if (view) {
 			/* Config parsing makes sure that direction is a valid direction */
-			enum lab_edge edge = action_get_int(action, "direction", 0);
+			enum lab_edge edge = action_get_int(action, ACTION_ARG_DIRECTION, 0);
 			if (action->type == ACTION_TYPE_TOGGLE_SNAP_TO_EDGE
 					&& view->maximized == VIEW_AXIS_NONE
 					&& !view->fullscreen
@@ -1113,7 +1170,7 @@ run_action(struct view *view, struct action *action,
 				view_apply_natural_geometry(view);
 				break;
 			}
-			bool combine = action_get_bool(action, "combine", false);
+			bool combine = action_get_bool(action, ACTION_ARG_COMBINE, false);
 			view_snap_to_edge(view, edge, /*across_outputs*/ true,
 				combine);
 		}
@@ -1121,14 +1178,14 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_GROW_TO_EDGE:
 		if (view) {
 			/* Config parsing makes sure that direction is a valid direction */
-			enum lab_edge edge = action_get_int(action, "direction", 0);
+			enum lab_edge edge = action_get_int(action, ACTION_ARG_DIRECTION, 0);
 			view_grow_to_edge(view, edge);
 		}
 		break;
 	case ACTION_TYPE_SHRINK_TO_EDGE:
 		if (view) {
 			/* Config parsing makes sure that direction is a valid direction */
-			enum lab_edge edge = action_get_int(action, "direction", 0);
+			enum lab_edge edge = action_get_int(action, ACTION_ARG_DIRECTION, 0);
 			view_shrink_to_edge(view, edge);
 		}
 		break;
@@ -1137,11 +1194,11 @@ run_action(struct view *view, struct action *action,
 		enum lab_cycle_dir dir = (action->type == ACTION_TYPE_NEXT_WINDOW) ?
 			LAB_CYCLE_DIR_FORWARD : LAB_CYCLE_DIR_BACKWARD;
 		struct cycle_filter filter = {
-			.workspace = action_get_int(action, "workspace",
+			.workspace = action_get_int(action, ACTION_ARG_WORKSPACE,
 				rc.window_switcher.workspace_filter),
-			.output = action_get_int(action, "output",
+			.output = action_get_int(action, ACTION_ARG_OUTPUT,
 				CYCLE_OUTPUT_ALL),
-			.app_id = action_get_int(action, "identifier",
+			.app_id = action_get_int(action, ACTION_ARG_IDENTIFIER,
 				CYCLE_APP_ID_ALL),
 		};
 		if (server.input_mode == LAB_INPUT_STATE_CYCLE) {
@@ -1156,11 +1213,11 @@ run_action(struct view *view, struct action *action,
 		enum lab_cycle_dir dir = (action->type == ACTION_TYPE_NEXT_WINDOW_IMMEDIATE) ?
 			LAB_CYCLE_DIR_FORWARD : LAB_CYCLE_DIR_BACKWARD;
 		struct cycle_filter filter = {
-			.workspace = action_get_int(action, "workspace",
+			.workspace = action_get_int(action, ACTION_ARG_WORKSPACE,
 				rc.window_switcher.workspace_filter),
-			.output = action_get_int(action, "output",
+			.output = action_get_int(action, ACTION_ARG_OUTPUT,
 				CYCLE_OUTPUT_ALL),
-			.app_id = action_get_int(action, "identifier",
+			.app_id = action_get_int(action, ACTION_ARG_IDENTIFIER,
 				CYCLE_APP_ID_ALL),
 		};
 		cycle_immediate(dir, filter);
@@ -1171,29 +1228,29 @@ run_action(struct view *view, struct action *action,
 		break;
 	case ACTION_TYPE_SHOW_MENU:
 		show_menu(view, ctx,
-			action_get_str(action, "menu", NULL),
-			action_get_bool(action, "atCursor", true),
-			action_get_str(action, "x.position", NULL),
-			action_get_str(action, "y.position", NULL));
+			action_get_str(action, ACTION_ARG_MENU, NULL),
+			action_get_bool(action, ACTION_ARG_AT_CURSOR, true),
+			action_get_str(action, ACTION_ARG_X_POSITION, NULL),
+			action_get_str(action, ACTION_ARG_Y_POSITION, NULL));
 		break;
 	case ACTION_TYPE_TOGGLE_MAXIMIZE:
 		if (view) {
 			enum view_axis axis = action_get_int(action,
-				"direction", VIEW_AXIS_BOTH);
+				ACTION_ARG_DIRECTION, VIEW_AXIS_BOTH);
 			view_toggle_maximize(view, axis);
 		}
 		break;
 	case ACTION_TYPE_MAXIMIZE:
 		if (view) {
 			enum view_axis axis = action_get_int(action,
-				"direction", VIEW_AXIS_BOTH);
+				ACTION_ARG_DIRECTION, VIEW_AXIS_BOTH);
 			view_maximize(view, axis);
 		}
 		break;
 	case ACTION_TYPE_UNMAXIMIZE:
 		if (view) {
 			enum view_axis axis = action_get_int(action,
-				"direction", VIEW_AXIS_BOTH);
+				ACTION_ARG_DIRECTION, VIEW_AXIS_BOTH);
 			view_maximize(view, view->maximized & ~axis);
 		}
 		break;
@@ -1205,9 +1262,9 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_SET_DECORATIONS:
 		if (view) {
 			enum lab_ssd_mode mode = action_get_int(action,
-				"decorations", LAB_SSD_MODE_FULL);
+				ACTION_ARG_DECORATIONS, LAB_SSD_MODE_FULL);
 			bool force_ssd = action_get_bool(action,
-				"forceSSD", false);
+				ACTION_ARG_FORCE_SSD, false);
 			view_set_decorations(view, mode, force_ssd);
 		}
 		break;
@@ -1276,7 +1333,7 @@ run_action(struct view *view, struct action *action,
 			 * the current cursor position (existing behaviour).
 			 */
 			enum lab_edge resize_edges =
-				action_get_int(action, "direction", LAB_EDGE_NONE);
+				action_get_int(action, ACTION_ARG_DIRECTION, LAB_EDGE_NONE);
 			/*
 			 * If triggered by mousebind, grab context was already
 			 * set by button press handling. For keybind-triggered
@@ -1291,25 +1348,25 @@ run_action(struct view *view, struct action *action,
 		break;
 	case ACTION_TYPE_RESIZE_RELATIVE:
 		if (view) {
-			int left = action_get_int(action, "left", 0);
-			int right = action_get_int(action, "right", 0);
-			int top = action_get_int(action, "top", 0);
-			int bottom = action_get_int(action, "bottom", 0);
+			int left = action_get_int(action, ACTION_ARG_LEFT, 0);
+			int right = action_get_int(action, ACTION_ARG_RIGHT, 0);
+			int top = action_get_int(action, ACTION_ARG_TOP, 0);
+			int bottom = action_get_int(action, ACTION_ARG_BOTTOM, 0);
 			view_resize_relative(view, left, right, top, bottom);
 		}
 		break;
 	case ACTION_TYPE_MOVETO:
 		if (view) {
-			int x = action_get_int(action, "x", 0);
-			int y = action_get_int(action, "y", 0);
+			int x = action_get_int(action, ACTION_ARG_X, 0);
+			int y = action_get_int(action, ACTION_ARG_Y, 0);
 			struct border margin = ssd_thickness(view);
 			view_move(view, x + margin.left, y + margin.top);
 		}
 		break;
 	case ACTION_TYPE_RESIZETO:
 		if (view) {
-			int width = action_get_int(action, "width", 0);
-			int height = action_get_int(action, "height", 0);
+			int width = action_get_int(action, ACTION_ARG_WIDTH, 0);
+			int height = action_get_int(action, ACTION_ARG_HEIGHT, 0);
 
 			/*
 			 * To support only setting one of width/height
@@ -1328,8 +1385,8 @@ run_action(struct view *view, struct action *action,
 		break;
 	case ACTION_TYPE_MOVE_RELATIVE:
 		if (view) {
-			int x = action_get_int(action, "x", 0);
-			int y = action_get_int(action, "y", 0);
+			int x = action_get_int(action, ACTION_ARG_X, 0);
+			int y = action_get_int(action, ACTION_ARG_Y, 0);
 			view_move_relative(view, x, y);
 		}
 		break;
@@ -1349,8 +1406,8 @@ run_action(struct view *view, struct action *action,
 		/* Falls through to GoToDesktop */
 	case ACTION_TYPE_GO_TO_DESKTOP: {
 		bool follow = true;
-		bool wrap = action_get_bool(action, "wrap", true);
-		const char *to = action_get_str(action, "to", NULL);
+		bool wrap = action_get_bool(action, ACTION_ARG_WRAP, true);
+		const char *to = action_get_str(action, ACTION_ARG_TO, NULL);
 		/*
 		 * `to` is always != NULL here because otherwise we would have
 		 * removed the action during the initial parsing step as it is
@@ -1359,7 +1416,7 @@ run_action(struct view *view, struct action *action,
 		struct workspace *target_workspace = workspaces_find(
 			server.workspaces.current, to, wrap);
 		if (action->type == ACTION_TYPE_GO_TO_DESKTOP) {
-			bool toggle = action_get_bool(action, "toggle", false);
+			bool toggle = action_get_bool(action, ACTION_ARG_TOGGLE, false);
 			if (target_workspace == server.workspaces.current
 				&& toggle) {
 				target_workspace = server.workspaces.last;
@@ -1370,7 +1427,7 @@ run_action(struct view *view, struct action *action,
 		}
 		if (action->type == ACTION_TYPE_SEND_TO_DESKTOP) {
 			view_move_to_workspace(view, target_workspace);
-			follow = action_get_bool(action, "follow", true);
+			follow = action_get_bool(action, ACTION_ARG_FOLLOW, true);
 
 			/* Ensure that the focus is not on another desktop */
 			if (!follow && server.active_view == view) {
@@ -1409,7 +1466,7 @@ run_action(struct view *view, struct action *action,
 		if (!output_is_usable(output)) {
 			break;
 		}
-		const char *region_name = action_get_str(action, "region", NULL);
+		const char *region_name = action_get_str(action, ACTION_ARG_REGION, NULL);
 		struct region *region = regions_from_name(region_name, output);
 		if (region) {
 			if (action->type == ACTION_TYPE_TOGGLE_SNAP_TO_REGION
@@ -1450,7 +1507,7 @@ run_action(struct view *view, struct action *action,
 	}
 	case ACTION_TYPE_IF: {
 		/* At least one of the queries was matched or there was no query */
-		if (action_get_str(action, "message.prompt", NULL)) {
+		if (action_get_str(action, ACTION_ARG_MESSAGE_PROMPT, NULL)) {
 			/*
 			 * We delay the selection and execution of the
 			 * branch until we get a response from the user.
@@ -1459,9 +1516,9 @@ run_action(struct view *view, struct action *action,
 		} else if (view) {
 			struct wl_list *actions;
 			if (match_queries(view, action)) {
-				actions = action_get_actionlist(action, "then");
+				actions = action_get_actionlist(action, ACTION_ARG_THEN);
 			} else {
-				actions = action_get_actionlist(action, "else");
+				actions = action_get_actionlist(action, ACTION_ARG_ELSE);
 			}
 			if (actions) {
 				actions_run(view, actions, ctx);
@@ -1481,9 +1538,9 @@ run_action(struct view *view, struct action *action,
 		wl_array_for_each(item, &views) {
 			if (match_queries(*item, action)) {
 				matches = true;
-				actions = action_get_actionlist(action, "then");
+				actions = action_get_actionlist(action, ACTION_ARG_THEN);
 			} else {
-				actions = action_get_actionlist(action, "else");
+				actions = action_get_actionlist(action, ACTION_ARG_ELSE);
 			}
 			if (actions) {
 				actions_run(*item, actions, ctx);
@@ -1491,7 +1548,7 @@ run_action(struct view *view, struct action *action,
 		}
 		wl_array_release(&views);
 		if (!matches) {
-			actions = action_get_actionlist(action, "none");
+			actions = action_get_actionlist(action, ACTION_ARG_NONE);
 			if (actions) {
 				actions_run(view, actions, NULL);
 			}
@@ -1501,7 +1558,7 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_VIRTUAL_OUTPUT_ADD: {
 		/* TODO: rename this argument to "outputName" */
 		const char *output_name =
-			action_get_str(action, "output_name", NULL);
+			action_get_str(action, ACTION_ARG_OUTPUT_NAME, NULL);
 		output_virtual_add(output_name,
 				/*store_wlr_output*/ NULL);
 		break;
@@ -1509,14 +1566,14 @@ run_action(struct view *view, struct action *action,
 	case ACTION_TYPE_VIRTUAL_OUTPUT_REMOVE: {
 		/* TODO: rename this argument to "outputName" */
 		const char *output_name =
-			action_get_str(action, "output_name", NULL);
+			action_get_str(action, ACTION_ARG_OUTPUT_NAME, NULL);
 		output_virtual_remove(output_name);
 		break;
 	}
 	case ACTION_TYPE_AUTO_PLACE:
 		if (view) {
 			enum lab_placement_policy policy =
-				action_get_int(action, "policy", LAB_PLACE_AUTOMATIC);
+				action_get_int(action, ACTION_ARG_POLICY, LAB_PLACE_AUTOMATIC);
 			view_place_by_policy(view,
 				/* allow_cursor */ true, policy);
 		}
@@ -1588,9 +1645,9 @@ run_action(struct view *view, struct action *action,
 		show_desktop_toggle();
 		break;
 	case ACTION_TYPE_WARP_CURSOR: {
-		const char *to = action_get_str(action, "to", "output");
-		const char *x = action_get_str(action, "x", "center");
-		const char *y = action_get_str(action, "y", "center");
+		const char *to = action_get_str(action, ACTION_ARG_TO, "output");
+		const char *x = action_get_str(action, ACTION_ARG_X, "center");
+		const char *y = action_get_str(action, ACTION_ARG_Y, "center");
 		warp_cursor(view, to, x, y);
 		break;
 	}
@@ -26,12 +26,16 @@
 
 #include "buffer.h"
 #include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 #include <drm_fourcc.h>
 #include <wlr/interfaces/wlr_buffer.h>
 #include <wlr/util/log.h>
 #include "common/box.h"
+#include "common/macros.h"
 #include "common/mem.h"
+#include "common/premultiply.h"
+#include "common/resample.h"
 
 static struct lab_data_buffer *data_buffer_from_buffer(
 	struct wlr_buffer *buffer);
@@ -42,7 +46,9 @@ data_buffer_destroy(struct wlr_buffer *wlr_buffer)
 	struct lab_data_buffer *buffer = data_buffer_from_buffer(wlr_buffer);
 	/* this also frees buffer->data if surface_owns_data == true */
 	cairo_surface_destroy(buffer->surface);
-	if (!buffer->surface_owns_data) {
+	if (buffer->shared_src) {
+		buffer_release_shared(buffer->shared_src);
+	} else if (!buffer->surface_owns_data) {
 		free(buffer->data);
 	}
 	wlr_buffer_finish(wlr_buffer);
@@ -101,6 +107,7 @@ buffer_adopt_cairo_surface(cairo_surface_t *surface)
 	buffer->logical_width = width;
 	buffer->logical_height = height;
 	buffer->surface_owns_data = true;
+	atomic_init(&buffer->shared_refs, 1);
 
 	return buffer;
 }
@@ -155,9 +162,35 @@ buffer_create_from_data(void *pixel_data, uint32_t width, uint32_t height,
 	buffer->surface = cairo_image_surface_create_for_data(
 		pixel_data, CAIRO_FORMAT_ARGB32, width, height, stride);
 	buffer->surface_owns_data = false;
+	atomic_init(&buffer->shared_refs, 1);
 	return buffer;
 }
 
+struct lab_data_buffer *
+buffer_create_shared(struct lab_data_buffer *src)
+{
+	atomic_fetch_add(&src->shared_refs, 1);
+
+	struct lab_data_buffer *buffer = buffer_create_from_data(src->data,
+		src->base.width, src->base.height, src->stride);
+	buffer->shared_src = src;
+	buffer->logical_width = src->logical_width;
+	buffer->logical_height = src->logical_height;
+
+	double x_scale, y_scale;
+	cairo_surface_get_device_scale(src->surface, &x_scale, &y_scale);
+	cairo_surface_set_device_scale(buffer->surface, x_scale, y_scale);
+	return buffer;
+}
+
+void
+buffer_release_shared(struct lab_data_buffer *buffer)
+{
+	if (atomic_fetch_sub(&buffer->shared_refs, 1) == 1) {
+		wlr_buffer_drop(&buffer->base);
+	}
+}
+
 struct lab_data_buffer *
 buffer_create_from_wlr_buffer(struct wlr_buffer *wlr_buffer)
 {
@@ -184,6 +217,51 @@ buffer_create_from_wlr_buffer(struct wlr_buffer *wlr_buffer)
 		wlr_buffer->width, wlr_buffer->height, stride);
 }
 
+void
+buffer_premultiply(struct lab_data_buffer *buffer)
+{
+	if (!buffer->straight_alpha) {
+		return;
+	}
+	uint8_t *row = buffer->data;
+	for (int y = 0; y < buffer->base.height; y++) {
+		premultiply_argb32((uint32_t *)row, buffer->base.width);
+		row += buffer->stride;
+	}
+	cairo_surface_mark_dirty(buffer->surface);
+	buffer->straight_alpha = false;
+}
+
+/*
+ * Downscale with a box filter into the pixel-aligned area of @dst_box.
+ * Returns false if the image is not shrunk in both directions, which is
+ * left to cairo.
+ */
+static bool
+downscale(struct lab_data_buffer *buffer, struct lab_data_buffer *src_buffer,
+		struct wlr_box *dst_box, double scale)
+{
+	int src_w = src_buffer->base.width;
+	int src_h = src_buffer->base.height;
+	int buf_w = buffer->base.width;
+	int buf_h = buffer->base.height;
+
+	int x = lround(dst_box->x * scale);
+	int y = lround(dst_box->y * scale);
+	int w = MIN((int)lround(dst_box->width * scale), buf_w - x);
+	int h = MIN((int)lround(dst_box->height * scale), buf_h - y);
+	if (w <= 0 || h <= 0 || w >= src_w || h >= src_h || x < 0 || y < 0) {
+		return false;
+	}
+
+	uint8_t *dst = (uint8_t *)buffer->data + (size_t)y * buffer->stride
+		+ (size_t)x * 4;
+	resample_box_argb32(src_buffer->data, src_w, src_h, src_buffer->stride,
+		(uint32_t *)dst, w, h, buffer->stride);
+	cairo_surface_mark_dirty(buffer->surface);
+	return true;
+}
+
 struct lab_data_buffer *
 buffer_resize(struct lab_data_buffer *src_buffer, int width, int height,
 		double scale)
@@ -200,7 +278,6 @@ buffer_resize(struct lab_data_buffer *src_buffer, int width, int height,
 		wlr_log(WLR_INFO, "Failed to resize buffer to %dx%d", width, height);
 		return NULL;
 	}
-	cairo_t *cairo = cairo_create(buffer->surface);
 
 	struct wlr_box container = {
 		.width = width,
@@ -208,6 +285,11 @@ buffer_resize(struct lab_data_buffer *src_buffer, int width, int height,
 	};
 
 	struct wlr_box dst_box = box_fit_within(src_w, src_h, &container);
+	if (downscale(buffer, src_buffer, &dst_box, scale)) {
+		return buffer;
+	}
+
+	cairo_t *cairo = cairo_create(buffer->surface);
 	double scene_scale = (double)dst_box.width / (double)src_w;
 	cairo_translate(cairo, dst_box.x, dst_box.y);
 	cairo_scale(cairo, scene_scale, scene_scale);
@@ -179,7 +179,7 @@ void
 paths_theme_create(struct wl_list *paths, const char *theme_name,
 		const char *filename)
 {
-	static char buf[4096] = { 0 };
+	char buf[4096] = { 0 };
 	wl_list_init(paths);
 	struct ctx ctx = {
 		.build_path_fn = build_theme_path_labwc,
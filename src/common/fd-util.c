@@ -27,15 +27,12 @@ increase_nofile_limit(void)
 	}
 }
 
+/* Runs in a vfork()ed child, so must be async-signal-safe and not log */
 void
 restore_nofile_limit(void)
 {
 	if (original_nofile_rlimit.rlim_cur == 0) {
 		return;
 	}
-
-	if (setrlimit(RLIMIT_NOFILE, &original_nofile_rlimit) != 0) {
-		wlr_log_errno(WLR_ERROR,
-			"Failed to restore max open files limit: setrlimit(NOFILE) failed");
-	}
+	setrlimit(RLIMIT_NOFILE, &original_nofile_rlimit);
 }
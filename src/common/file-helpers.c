@@ -1,6 +1,10 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
 #include "common/file-helpers.h"
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 bool
 file_exists(const char *filename)
@@ -8,3 +12,35 @@ file_exists(const char *filename)
 	struct stat st;
 	return (!stat(filename, &st));
 }
+
+bool
+file_map(const char *filename, struct mapped_file *file)
+{
+	int fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	file->data = data;
+	file->len = st.st_size;
+	return true;
+}
+
+void
+file_unmap(struct mapped_file *file)
+{
+	munmap((void *)file->data, file->len);
+	file->data = NULL;
+	file->len = 0;
+}
@@ -19,7 +19,7 @@ font_to_pango_desc(struct font *font)
 }
 
 static PangoRectangle
-font_extents(struct font *font, const char *string)
+font_extents(struct font *font, const char *string, bool use_markup)
 {
 	PangoRectangle rect = { 0 };
 	if (string_null_or_empty(string)) {
@@ -36,7 +36,11 @@ font_extents(struct font *font, const char *string)
 	PangoFontDescription *desc = font_to_pango_desc(font);
 
 	pango_layout_set_font_description(layout, desc);
-	pango_layout_set_text(layout, string, -1);
+	if (use_markup) {
+		pango_layout_set_markup(layout, string, -1);
+	} else {
+		pango_layout_set_text(layout, string, -1);
+	}
 	pango_layout_set_single_paragraph_mode(layout, TRUE);
 	pango_layout_set_width(layout, -1);
 	pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_MIDDLE);
@@ -53,22 +57,23 @@ font_extents(struct font *font, const char *string)
 int
 font_height(struct font *font)
 {
-	PangoRectangle rectangle = font_extents(font, "abcdefg");
+	PangoRectangle rectangle = font_extents(font, "abcdefg", /* use_markup */ false);
 	return rectangle.height;
 }
 
 int
 font_width(struct font *font, const char *string)
 {
-	PangoRectangle rectangle = font_extents(font, string);
+	PangoRectangle rectangle =
+		font_extents(font, string, /* use_markup */ false);
 	return rectangle.width;
 }
 
 void
 font_get_buffer_size(int max_width, const char *text, struct font *font,
-	int *width, int *height)
+	int *width, int *height, bool use_markup)
 {
-	PangoRectangle text_extents = font_extents(font, text);
+	PangoRectangle text_extents = font_extents(font, text, use_markup);
 	if (max_width > 0 && text_extents.width > max_width) {
 		text_extents.width = max_width;
 	}
@@ -87,7 +92,8 @@ font_buffer_create(struct lab_data_buffer **buffer, int max_width,
 	}
 
 	int width, computed_height;
-	font_get_buffer_size(max_width, text, font, &width, &computed_height);
+	font_get_buffer_size(max_width, text, font, &width, &computed_height,
+		use_markup);
 	if (height <= 0) {
 		height = computed_height;
 	}
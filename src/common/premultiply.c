@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "common/premultiply.h"
+
+void
+premultiply_argb32(uint32_t *pixels, size_t nr_pixels)
+{
+	/*
+	 * Red and blue are multiplied at once in the two 16-bit halves of a
+	 * word, and x / 255 is computed as (x + (x >> 8) + 1) >> 8, which is
+	 * exact for 0 <= x <= 255 * 255. Without branches and divisions the
+	 * loop is vectorized by the compiler on any architecture.
+	 */
+	for (size_t i = 0; i < nr_pixels; i++) {
+		uint32_t pixel = pixels[i];
+		uint32_t alpha = pixel >> 24;
+
+		uint32_t rb = (pixel & 0x00ff00ff) * alpha;
+		rb = ((rb + ((rb >> 8) & 0x00ff00ff) + 0x00010001) >> 8)
+			& 0x00ff00ff;
+
+		uint32_t g = ((pixel >> 8) & 0xff) * alpha;
+		g = (g + (g >> 8) + 1) & 0x0000ff00;
+
+		pixels[i] = (pixel & 0xff000000) | g | rb;
+	}
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "common/resample.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/mem.h"
+
+/* Filter weights are fixed-point with 15 fractional bits */
+#define WEIGHT_SHIFT 15
+#define WEIGHT_ONE (1 << WEIGHT_SHIFT)
+
+/*
+ * After the vertical pass, channels are reduced to 8 fractional bits so
+ * that the horizontal pass (255 << 8) * WEIGHT_ONE still fits in 32 bits.
+ */
+#define MID_SHIFT (WEIGHT_SHIFT - 8)
+#define OUT_SHIFT (WEIGHT_SHIFT + 8)
+
+/* Source pixels contributing to one destination pixel */
+struct span {
+	int start;
+	int count;
+	uint32_t *weights;
+};
+
+/*
+ * Destination pixel i covers the source interval [i * src / dst,
+ * (i + 1) * src / dst). Scaling all coordinates by dst keeps this exact in
+ * integers: source pixel j spans [j * dst, (j + 1) * dst) and destination
+ * pixel i spans [i * src, (i + 1) * src).
+ */
+static struct span *
+compute_spans(int src_size, int dst_size, uint32_t **weights)
+{
+	struct span *spans = znew_n(*spans, dst_size);
+	/* No span covers more than this many source pixels */
+	int max_count = src_size / dst_size + 2;
+	*weights = znew_n(**weights, (size_t)dst_size * max_count);
+
+	for (int i = 0; i < dst_size; i++) {
+		int64_t lo = (int64_t)i * src_size;
+		int64_t hi = lo + src_size;
+		struct span *span = &spans[i];
+		span->start = lo / dst_size;
+		span->weights = *weights + (size_t)i * max_count;
+
+		uint32_t sum = 0;
+		int largest = 0;
+		for (int j = span->start; (int64_t)j * dst_size < hi; j++) {
+			int64_t from = (int64_t)j * dst_size;
+			int64_t to = from + dst_size;
+			if (from < lo) {
+				from = lo;
+			}
+			if (to > hi) {
+				to = hi;
+			}
+			assert(span->count < max_count);
+			uint32_t weight = (to - from) * WEIGHT_ONE / src_size;
+			span->weights[span->count] = weight;
+			if (weight > span->weights[largest]) {
+				largest = span->count;
+			}
+			sum += weight;
+			span->count++;
+		}
+		/* Make the weights add up to exactly 1 despite rounding */
+		span->weights[largest] += WEIGHT_ONE - sum;
+	}
+	return spans;
+}
+
+/* Multiply-add a source row into the accumulators, vectorized by compilers */
+static void
+accumulate_row(uint32_t *restrict acc, const uint8_t *restrict row,
+		int nr_channels, uint32_t weight)
+{
+	for (int i = 0; i < nr_channels; i++) {
+		acc[i] += row[i] * weight;
+	}
+}
+
+static void
+reduce_row(uint32_t *acc, int nr_channels)
+{
+	for (int i = 0; i < nr_channels; i++) {
+		acc[i] >>= MID_SHIFT;
+	}
+}
+
+static void
+filter_row(uint8_t *restrict out, const uint32_t *restrict acc,
+		const struct span *spans, int dst_width)
+{
+	for (int x = 0; x < dst_width; x++) {
+		const struct span *span = &spans[x];
+		const uint32_t *in = &acc[span->start * 4];
+		/* All four channels at once, for SLP vectorization */
+		uint32_t sum[4] = { 0 };
+		for (int k = 0; k < span->count; k++) {
+			uint32_t weight = span->weights[k];
+			for (int c = 0; c < 4; c++) {
+				sum[c] += in[k * 4 + c] * weight;
+			}
+		}
+		for (int c = 0; c < 4; c++) {
+			out[x * 4 + c] =
+				(sum[c] + (1 << (OUT_SHIFT - 1))) >> OUT_SHIFT;
+		}
+	}
+}
+
+void
+resample_box_argb32(const uint32_t *src, int src_width, int src_height,
+		int src_stride, uint32_t *dst, int dst_width, int dst_height,
+		int dst_stride)
+{
+	assert(dst_width >= 1 && dst_width <= src_width);
+	assert(dst_height >= 1 && dst_height <= src_height);
+
+	uint32_t *x_weights, *y_weights;
+	struct span *x_spans = compute_spans(src_width, dst_width, &x_weights);
+	struct span *y_spans = compute_spans(src_height, dst_height, &y_weights);
+
+	/*
+	 * Filter vertically first: every source row is then read once, in
+	 * order, and multiplied by a single weight across its whole width.
+	 */
+	int nr_channels = src_width * 4;
+	uint32_t *acc = znew_n(*acc, nr_channels);
+	for (int y = 0; y < dst_height; y++) {
+		const struct span *span = &y_spans[y];
+		memset(acc, 0, nr_channels * sizeof(*acc));
+		for (int k = 0; k < span->count; k++) {
+			const uint8_t *row = (const uint8_t *)src
+				+ (size_t)(span->start + k) * src_stride;
+			accumulate_row(acc, row, nr_channels, span->weights[k]);
+		}
+		reduce_row(acc, nr_channels);
+		filter_row((uint8_t *)dst + (size_t)y * dst_stride, acc,
+			x_spans, dst_width);
+	}
+
+	free(acc);
+	free(x_spans);
+	free(x_weights);
+	free(y_spans);
+	free(y_weights);
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#include "common/shadow-gradient.h"
+#include <math.h>
+#include "common/macros.h"
+
+/* Standard deviation normalised against the shadow width, squared */
+#define SHADOW_VARIANCE (0.3 * 0.3)
+
+/*
+ * Colors are scaled to 0..255 with 8 fractional bits, so that multiplying
+ * by a Q15 alpha stays below 2^31 and a single shift yields the channel.
+ */
+#define COLOR_SHIFT (15 + 8)
+
+void
+shadow_gradient_profile(uint32_t *profile, int total_size)
+{
+	for (int i = 0; i < total_size; i++) {
+		double xn = (double)i / (double)total_size;
+		profile[i] = lround(exp(-(xn * xn) / SHADOW_VARIANCE)
+			* SHADOW_GRADIENT_ONE);
+	}
+}
+
+static void
+get_color_q8(uint32_t q8[4], const float color[4])
+{
+	for (int i = 0; i < 4; i++) {
+		float c = MAX(MIN(color[i], 1.0f), 0.0f);
+		q8[i] = lroundf(c * 255.0f * 256.0f);
+	}
+}
+
+static inline uint32_t
+get_pixel(const uint32_t q8[4], uint32_t alpha)
+{
+	return (q8[3] * alpha >> COLOR_SHIFT) << 24
+		| (q8[0] * alpha >> COLOR_SHIFT) << 16
+		| (q8[1] * alpha >> COLOR_SHIFT) << 8
+		| (q8[2] * alpha >> COLOR_SHIFT);
+}
+
+void
+shadow_gradient_edge(uint32_t *pixels, const uint32_t *profile,
+		int visible_size, int total_size, const float color[4])
+{
+	uint32_t q8[4];
+	get_color_q8(q8, color);
+
+	/*
+	 * The inset is added because the edge buffer does not include it
+	 * but still has to line up with the corner buffers which do.
+	 */
+	const uint32_t *p = profile + (total_size - visible_size);
+	for (int x = 0; x < visible_size; x++) {
+		pixels[x] = get_pixel(q8, p[x]);
+	}
+}
+
+void
+shadow_gradient_corner(uint32_t *pixels, size_t stride,
+		const uint32_t *profile, int visible_size, int total_size,
+		int titlebar_height, const float color[4])
+{
+	uint32_t q8[4];
+	get_color_q8(q8, color);
+
+	int inset = total_size - visible_size;
+
+	for (int y = 0; y < total_size; y++) {
+		uint32_t *row = (uint32_t *)((uint8_t *)pixels + y * stride);
+
+		/*
+		 * Erase the L-shaped region which could be visible through a
+		 * transparent window but not obscured by the titlebar. If
+		 * inset is smaller than the titlebar height then there's
+		 * nothing to do, this is handled by (inset - titlebar_height)
+		 * being negative.
+		 */
+		int clear = 0;
+		if (y < inset - titlebar_height) {
+			clear = inset;
+		} else if (y < inset) {
+			clear = MAX(inset - titlebar_height, 0);
+		}
+		for (int x = 0; x < clear; x++) {
+			row[x] = 0;
+		}
+
+		/* Outer product of the horizontal and vertical profiles */
+		uint32_t py = profile[y];
+		for (int x = clear; x < total_size; x++) {
+			uint32_t alpha = profile[x] * py >> 15;
+			row[x] = get_pixel(q8, alpha);
+		}
+	}
+}
@@ -1,27 +1,112 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#define _DEFAULT_SOURCE
 #define _POSIX_C_SOURCE 200809L
 #include "common/spawn.h"
 #include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
 #include <fcntl.h>
 #include <glib.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include <wlr/util/log.h>
 #include "common/fd-util.h"
 
+/* Values for spawn_setup.fds[] other than a file descriptor to dup2() */
+#define SPAWN_FD_INHERIT (-1)
+#define SPAWN_FD_CLOSE (-2)
+
+struct spawn_setup {
+	/* Replacements for stdin, stdout and stderr of the child */
+	int fds[3];
+	bool new_session;
+};
+
+/* Set by the vfork()ed child, which shares our memory, if execvp() fails */
+static int exec_errno;
+
+/*
+ * Runs in the vfork()ed child, which shares our memory and stack until
+ * execvp() succeeds. Only async-signal-safe functions may be called and
+ * nothing but exec_errno may be written to.
+ */
 static void
-reset_signals_and_limits(void)
+exec_child(char *const argv[], const struct spawn_setup *setup)
 {
+	/*
+	 * Handlers are reset before unblocking signals so that none of
+	 * ours runs in the child. Ignored signals (SIGPIPE) would stay
+	 * ignored across exec, so restore them too.
+	 */
+	for (int sig = 1; sig < NSIG; sig++) {
+		struct sigaction sa;
+		if (sigaction(sig, NULL, &sa) == 0 && sa.sa_handler != SIG_DFL) {
+			signal(sig, SIG_DFL);
+		}
+	}
 	restore_nofile_limit();
 
+	if (setup->new_session) {
+		setsid();
+	}
+
+	for (int i = 0; i < 3; i++) {
+		int fd = setup->fds[i];
+		if (fd == SPAWN_FD_CLOSE) {
+			close(i);
+		} else if (fd == i) {
+			/* dup2() would be a no-op and keep FD_CLOEXEC */
+			fcntl(i, F_SETFD, 0);
+		} else if (fd >= 0) {
+			dup2(fd, i);
+		}
+	}
+
 	sigset_t set;
 	sigemptyset(&set);
 	sigprocmask(SIG_SETMASK, &set, NULL);
 
-	/* Restore ignored signals */
-	signal(SIGPIPE, SIG_DFL);
+	execvp(argv[0], argv);
+	exec_errno = errno;
+	_exit(127);
+}
+
+/*
+ * fork() has to copy the page tables of the whole compositor, which takes
+ * milliseconds once GPU buffers and caches have been mapped. vfork() does
+ * not copy anything and only suspends the calling thread until the child
+ * has called execvp().
+ *
+ * Children are not double-forked; the SIGCHLD handler in src/server.c
+ * reaps them.
+ */
+static pid_t
+spawn_argv(char *const argv[], const struct spawn_setup *setup)
+{
+	/* Nothing must run a signal handler while the child uses our stack */
+	sigset_t all, old;
+	sigfillset(&all);
+	pthread_sigmask(SIG_SETMASK, &all, &old);
+
+	exec_errno = 0;
+	pid_t pid = vfork();
+	if (pid == 0) {
+		exec_child(argv, setup);
+	}
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (pid < 0) {
+		wlr_log_errno(WLR_ERROR, "unable to vfork()");
+	} else if (exec_errno) {
+		/* The child has exited and is reaped like any other */
+		wlr_log(WLR_ERROR, "unable to execute %s: %s", argv[0],
+			strerror(exec_errno));
+	}
+	return pid;
 }
 
 static bool
@@ -59,80 +144,57 @@ set_nonblock(int fd)
 	return true;
 }
 
-void
-spawn_async_no_shell(char const *command)
+static gchar **
+parse_argv(const char *command)
 {
 	GError *err = NULL;
 	gchar **argv = NULL;
 
-	assert(command);
-
 	/* Use glib's shell-parse to mimic Openbox's behaviour */
 	g_shell_parse_argv((gchar *)command, NULL, &argv, &err);
 	if (err) {
 		g_message("%s", err->message);
 		g_error_free(err);
-		return;
+		return NULL;
 	}
+	return argv;
+}
 
-	/*
-	 * Avoid zombie processes by using a double-fork, whereby the
-	 * grandchild becomes orphaned & the responsibility of the OS.
-	 */
-	pid_t child = 0, grandchild = 0;
-
-	child = fork();
-	switch (child) {
-	case -1:
-		wlr_log(WLR_ERROR, "unable to fork()");
-		goto out;
-	case 0:
-		reset_signals_and_limits();
+pid_t
+spawn_async_no_shell(char const *command)
+{
+	assert(command);
 
-		setsid();
-		grandchild = fork();
-		if (grandchild == 0) {
-			execvp(argv[0], argv);
-			_exit(0);
-		} else if (grandchild < 0) {
-			wlr_log(WLR_ERROR, "unable to fork()");
-		}
-		_exit(0);
-	default:
-		break;
+	gchar **argv = parse_argv(command);
+	if (!argv) {
+		return -1;
 	}
-	waitpid(child, NULL, 0);
-out:
+
+	struct spawn_setup setup = {
+		.fds = { SPAWN_FD_INHERIT, SPAWN_FD_INHERIT, SPAWN_FD_INHERIT },
+		.new_session = true,
+	};
+	pid_t child = spawn_argv(argv, &setup);
 	g_strfreev(argv);
+	return child;
 }
 
 void
 spawn_sync_no_shell(char const *command)
 {
-	GError *err = NULL;
-	gchar **argv = NULL;
-
 	assert(command);
 
-	g_shell_parse_argv((gchar *)command, NULL, &argv, &err);
-	if (err) {
-		g_message("%s", err->message);
-		g_error_free(err);
+	gchar **argv = parse_argv(command);
+	if (!argv) {
 		return;
 	}
 
-	pid_t child = fork();
-	switch (child) {
-	case -1:
-		wlr_log(WLR_ERROR, "unable to fork()");
-		break;
-	case 0:
-		reset_signals_and_limits();
-		execvp(argv[0], argv);
-		_exit(1);
-	default:
+	struct spawn_setup setup = {
+		.fds = { SPAWN_FD_INHERIT, SPAWN_FD_INHERIT, SPAWN_FD_INHERIT },
+	};
+	pid_t child = spawn_argv(argv, &setup);
+	if (child > 0) {
 		waitpid(child, NULL, 0);
-		break;
 	}
 	g_strfreev(argv);
 }
@@ -142,34 +204,17 @@ spawn_primary_client(const char *command)
 {
 	assert(command);
 
-	GError *err = NULL;
-	gchar **argv = NULL;
-
-	/* Use glib's shell-parse to mimic Openbox's behaviour */
-	g_shell_parse_argv((gchar *)command, NULL, &argv, &err);
-	if (err) {
-		g_message("%s", err->message);
-		g_error_free(err);
+	gchar **argv = parse_argv(command);
+	if (!argv) {
 		return -1;
 	}
 
-	pid_t child = fork();
-	switch (child) {
-	case -1:
-		wlr_log_errno(WLR_ERROR, "Failed to fork");
-		g_strfreev(argv);
-		return -1;
-	case 0:
-		/* child */
-		close(STDIN_FILENO);
-		reset_signals_and_limits();
-		execvp(argv[0], argv);
-		wlr_log_errno(WLR_ERROR, "Failed to execute primary client %s", command);
-		_exit(1);
-	default:
-		g_strfreev(argv);
-		return child;
-	}
+	struct spawn_setup setup = {
+		.fds = { SPAWN_FD_CLOSE, SPAWN_FD_INHERIT, SPAWN_FD_INHERIT },
+	};
+	pid_t child = spawn_argv(argv, &setup);
+	g_strfreev(argv);
+	return child;
 }
 
 pid_t
@@ -177,14 +222,8 @@ spawn_piped_async_no_shell(const char *command, int *pipe_fd_w)
 {
 	assert(command);
 
-	GError *err = NULL;
-	gchar **argv = NULL;
-
-	/* Use glib's shell-parse to mimic Openbox's behaviour */
-	g_shell_parse_argv((gchar *)command, NULL, &argv, &err);
-	if (err) {
-		g_message("%s", err->message);
-		g_error_free(err);
+	gchar **argv = parse_argv(command);
+	if (!argv) {
 		return -1;
 	}
 
@@ -195,61 +234,47 @@ spawn_piped_async_no_shell(const char *command, int *pipe_fd_w)
 		return -1;
 	}
 
-	pid_t child = 0;
-	child = fork();
-	if (child < 0) {
-		wlr_log(WLR_ERROR, "unable to fork() child");
-		close(pipe_rw[0]);
-		close(pipe_rw[1]);
-		g_strfreev(argv);
-		return child;
-	}
-
-	if (child == 0) {
-		/* Child */
-		reset_signals_and_limits();
+	/*
+	 * The child only keeps the copy on its stdin, and further
+	 * children must not inherit the write end either.
+	 */
+	set_cloexec(pipe_rw[0]);
+	set_cloexec(pipe_rw[1]);
 
+	/*
+	 * replace stdout and stderr with /dev/null
+	 * and stdin with the read end of the pipe
+	 */
+	int dev_null = open("/dev/null", O_WRONLY | O_CLOEXEC);
+	if (dev_null < 0) {
 		/*
-		 * replace stdout and stderr with /dev/null
-		 * and stdin with the read end of the pipe
+		 * Just close stdout and stderr and
+		 * hope $command can deal with that.
 		 */
-		close(pipe_rw[1]);
-		dup2(pipe_rw[0], STDIN_FILENO);
-		close(pipe_rw[0]);
-
-		int dev_null = open("/dev/null", O_WRONLY);
-		if (dev_null < 0) {
-			wlr_log_errno(WLR_ERROR, "opening /dev/null failed");
-			/*
-			 * Just close stdout and stderr and
-			 * hope $command can deal with that.
-			 */
-			close(STDOUT_FILENO);
-			close(STDERR_FILENO);
-		} else {
-			dup2(dev_null, STDOUT_FILENO);
-			dup2(dev_null, STDERR_FILENO);
-			close(dev_null);
-		}
-		execvp(argv[0], argv);
-		_exit(1);
+		wlr_log_errno(WLR_ERROR, "opening /dev/null failed");
+		dev_null = SPAWN_FD_CLOSE;
 	}
+	struct spawn_setup setup = {
+		.fds = { pipe_rw[0], dev_null, dev_null },
+	};
+	pid_t child = spawn_argv(argv, &setup);
 
 	/* labwc */
 	close(pipe_rw[0]);
+	if (dev_null >= 0) {
+		close(dev_null);
+	}
 	g_strfreev(argv);
+	if (child < 0) {
+		close(pipe_rw[1]);
+		return child;
+	}
 
 	/*
 	 * Prevent blocking of the labwc process when
 	 * writing more than the pipe buffer can hold.
 	 */
 	set_nonblock(pipe_rw[1]);
-
-	/*
-	 * Prevent leaking the write end of the pipe to further
-	 * children forked during the lifetime of the descriptor.
-	 */
-	set_cloexec(pipe_rw[1]);
 	*pipe_fd_w = pipe_rw[1];
 
 	return child;
@@ -266,57 +291,38 @@ spawn_piped(const char *command, int *pipe_fd)
 		return -1;
 	}
 
-	pid_t pid = fork();
-	if (pid < 0) {
-		close(pipe_rw[0]);
-		close(pipe_rw[1]);
-		wlr_log(WLR_ERROR, "unable to fork()");
-		return pid;
-	}
-
-	if (pid == 0) {
-		/* child */
-		reset_signals_and_limits();
-
-		/*
-		 * replace stdin and stderr with /dev/null
-		 * and stdout with the write end of the pipe
-		 */
-		dup2(pipe_rw[1], STDOUT_FILENO);
-		close(pipe_rw[0]);
-		close(pipe_rw[1]);
-
-		int dev_null = open("/dev/null", O_RDWR);
-		if (dev_null < 0) {
-			wlr_log_errno(WLR_ERROR, "opening /dev/null failed");
-			/*
-			 * Just close stdin and stderr and
-			 * hope $command can deal with that.
-			 */
-			close(STDIN_FILENO);
-			close(STDERR_FILENO);
-		} else {
-			dup2(dev_null, STDIN_FILENO);
-			dup2(dev_null, STDERR_FILENO);
-			close(dev_null);
-		}
+	/* See spawn_piped_async_no_shell() */
+	set_cloexec(pipe_rw[0]);
+	set_cloexec(pipe_rw[1]);
 
-		execl("/bin/sh", "sh", "-c", command, NULL);
+	/*
+	 * replace stdin and stderr with /dev/null
+	 * and stdout with the write end of the pipe
+	 */
+	int dev_null = open("/dev/null", O_RDWR | O_CLOEXEC);
+	if (dev_null < 0) {
 		/*
-		 * Our stderr points to /dev/null or is closed
-		 * at this point so logging is pretty useless.
+		 * Just close stdin and stderr and
+		 * hope $command can deal with that.
 		 */
-		_exit(1);
+		wlr_log_errno(WLR_ERROR, "opening /dev/null failed");
+		dev_null = SPAWN_FD_CLOSE;
 	}
+	struct spawn_setup setup = {
+		.fds = { dev_null, pipe_rw[1], dev_null },
+	};
+	char *const argv[] = { "/bin/sh", "-c", (char *)command, NULL };
+	pid_t pid = spawn_argv(argv, &setup);
 
 	/* labwc */
 	close(pipe_rw[1]);
-
-	/*
-	 * Prevent leaking the read end of the pipe to further
-	 * children forked during the lifetime of the descriptor.
-	 */
-	set_cloexec(pipe_rw[0]);
+	if (dev_null >= 0) {
+		close(dev_null);
+	}
+	if (pid < 0) {
+		close(pipe_rw[0]);
+		return pid;
+	}
 
 	*pipe_fd = pipe_rw[0];
 	return pid;
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include "common/thread-pool.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <wayland-server-core.h>
+#include <wlr/util/log.h>
+#include "common/list.h"
+#include "common/macros.h"
+#include "common/mem.h"
+
+/* No point in having more workers than this for our use-cases */
+#define THREAD_POOL_MAX_THREADS 8
+
+struct thread_pool_job {
+	thread_pool_func_t func;
+	thread_pool_func_t done;
+	void *data;
+	struct wl_list link; /* thread_pool.jobs or thread_pool.done_jobs */
+};
+
+struct thread_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t job_queued;
+	pthread_cond_t jobs_done;
+	struct wl_list jobs; /* thread_pool_job.link */
+	/* Number of queued plus running jobs */
+	int nr_pending;
+	bool quit;
+
+	/* Jobs whose done callback is yet to be run on the event loop */
+	struct wl_list done_jobs; /* thread_pool_job.link */
+	struct wl_event_loop *loop;
+	int done_fd;
+	struct wl_event_source *done_source;
+	struct wl_event_source *done_idle;
+
+	pthread_t *threads;
+	int nr_threads;
+};
+
+static void
+notify_done(struct thread_pool *pool)
+{
+	uint64_t one = 1;
+	if (write(pool->done_fd, &one, sizeof(one)) < 0) {
+		wlr_log_errno(WLR_ERROR, "failed to signal job completion");
+	}
+}
+
+static void
+run_done_jobs(struct thread_pool *pool)
+{
+	struct wl_list done_jobs;
+	wl_list_init(&done_jobs);
+
+	pthread_mutex_lock(&pool->lock);
+	wl_list_insert_list(&done_jobs, &pool->done_jobs);
+	wl_list_init(&pool->done_jobs);
+	pthread_mutex_unlock(&pool->lock);
+
+	struct thread_pool_job *job, *tmp;
+	wl_list_for_each_safe(job, tmp, &done_jobs, link) {
+		wl_list_remove(&job->link);
+		job->done(job->data);
+		free(job);
+	}
+}
+
+static int
+handle_done(int fd, uint32_t mask, void *data)
+{
+	struct thread_pool *pool = data;
+	uint64_t count;
+	if (read(fd, &count, sizeof(count)) < 0) {
+		return 0;
+	}
+	run_done_jobs(pool);
+	return 0;
+}
+
+static void
+handle_done_idle(void *data)
+{
+	struct thread_pool *pool = data;
+	pool->done_idle = NULL;
+	run_done_jobs(pool);
+}
+
+static void *
+worker(void *data)
+{
+	struct thread_pool *pool = data;
+
+	pthread_mutex_lock(&pool->lock);
+	while (true) {
+		while (wl_list_empty(&pool->jobs) && !pool->quit) {
+			pthread_cond_wait(&pool->job_queued, &pool->lock);
+		}
+		if (wl_list_empty(&pool->jobs)) {
+			break;
+		}
+		struct thread_pool_job *job =
+			wl_container_of(pool->jobs.next, job, link);
+		wl_list_remove(&job->link);
+		pthread_mutex_unlock(&pool->lock);
+
+		job->func(job->data);
+
+		pthread_mutex_lock(&pool->lock);
+		if (job->done) {
+			wl_list_append(&pool->done_jobs, &job->link);
+			notify_done(pool);
+		} else {
+			free(job);
+		}
+		if (--pool->nr_pending == 0) {
+			pthread_cond_broadcast(&pool->jobs_done);
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+struct thread_pool *
+thread_pool_create(int nr_threads, struct wl_event_loop *loop)
+{
+	if (nr_threads <= 0) {
+		nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	nr_threads = MAX(MIN(nr_threads, THREAD_POOL_MAX_THREADS), 1);
+
+	struct thread_pool *pool = znew(*pool);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->job_queued, NULL);
+	pthread_cond_init(&pool->jobs_done, NULL);
+	wl_list_init(&pool->jobs);
+	wl_list_init(&pool->done_jobs);
+	pool->done_fd = -1;
+
+	pool->loop = loop;
+	if (loop) {
+		pool->done_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (pool->done_fd < 0) {
+			wlr_log_errno(WLR_ERROR, "failed to create eventfd");
+		} else {
+			pool->done_source = wl_event_loop_add_fd(loop,
+				pool->done_fd, WL_EVENT_READABLE, handle_done, pool);
+		}
+	}
+
+	pool->threads = znew_n(*pool->threads, nr_threads);
+	for (int i = 0; i < nr_threads; i++) {
+		if (pthread_create(&pool->threads[i], NULL, worker, pool)) {
+			wlr_log(WLR_ERROR, "failed to create worker thread");
+			break;
+		}
+		pool->nr_threads++;
+	}
+	return pool;
+}
+
+static void
+submit(struct thread_pool *pool, thread_pool_func_t func,
+		thread_pool_func_t done, void *data)
+{
+	struct thread_pool_job *job = znew(*job);
+	job->func = func;
+	job->done = done;
+	job->data = data;
+
+	pthread_mutex_lock(&pool->lock);
+	wl_list_append(&pool->jobs, &job->link);
+	pool->nr_pending++;
+	pthread_cond_signal(&pool->job_queued);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void
+thread_pool_submit(struct thread_pool *pool, thread_pool_func_t func,
+		void *data)
+{
+	if (!pool->nr_threads) {
+		func(data);
+		return;
+	}
+	submit(pool, func, NULL, data);
+}
+
+void
+thread_pool_submit_async(struct thread_pool *pool, thread_pool_func_t func,
+		thread_pool_func_t done, void *data)
+{
+	assert(pool->loop && done);
+	if (pool->nr_threads && pool->done_source) {
+		submit(pool, func, done, data);
+		return;
+	}
+
+	/* Run @func right away but still defer @done to the event loop */
+	func(data);
+	struct thread_pool_job *job = znew(*job);
+	job->done = done;
+	job->data = data;
+	pthread_mutex_lock(&pool->lock);
+	wl_list_append(&pool->done_jobs, &job->link);
+	pthread_mutex_unlock(&pool->lock);
+	if (!pool->done_idle) {
+		pool->done_idle = wl_event_loop_add_idle(pool->loop,
+			handle_done_idle, pool);
+	}
+}
+
+void
+thread_pool_wait(struct thread_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	while (pool->nr_pending > 0) {
+		pthread_cond_wait(&pool->jobs_done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void
+thread_pool_destroy(struct thread_pool *pool)
+{
+	if (!pool) {
+		return;
+	}
+
+	/* Workers drain the queue before they exit */
+	pthread_mutex_lock(&pool->lock);
+	pool->quit = true;
+	pthread_cond_broadcast(&pool->job_queued);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (int i = 0; i < pool->nr_threads; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	/* Let callers release whatever the finished jobs hold on to */
+	run_done_jobs(pool);
+	if (pool->done_idle) {
+		wl_event_source_remove(pool->done_idle);
+	}
+	if (pool->done_source) {
+		wl_event_source_remove(pool->done_source);
+	}
+	if (pool->done_fd >= 0) {
+		close(pool->done_fd);
+	}
+
+	pthread_cond_destroy(&pool->jobs_done);
+	pthread_cond_destroy(&pool->job_queued);
+	pthread_mutex_destroy(&pool->lock);
+	free(pool->threads);
+	free(pool);
+}
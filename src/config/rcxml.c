@@ -2,6 +2,7 @@
 #define _POSIX_C_SOURCE 200809L
 #include "config/rcxml.h"
 #include <assert.h>
+#include <dirent.h>
 #include <glib.h>
 #include <libxml/parser.h>
 #include <stdbool.h>
@@ -9,11 +10,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/stat.h>
 #include <wlr/util/box.h>
 #include <wlr/util/log.h>
 #include "action.h"
 #include "common/buf.h"
 #include "common/dir.h"
+#include "common/hash.h"
 #include "common/list.h"
 #include "common/macros.h"
 #include "common/mem.h"
@@ -495,36 +498,36 @@ parse_action_args(xmlNode *node, struct action *action)
 	LAB_XML_FOR_EACH(node, child, key, content) {
 		if (!strcasecmp(key, "query")) {
 			struct wl_list *querylist =
-				action_get_querylist(action, "query");
+				action_get_querylist(action, ACTION_ARG_QUERY);
 			if (!querylist) {
-				action_arg_add_querylist(action, "query");
-				querylist = action_get_querylist(action, "query");
+				action_arg_add_querylist(action, ACTION_ARG_QUERY);
+				querylist = action_get_querylist(action, ACTION_ARG_QUERY);
 			}
 			struct view_query *query = view_query_create();
 			fill_action_query(action, child, query);
 			wl_list_append(querylist, &query->link);
 		} else if (!strcasecmp(key, "then")) {
 			struct wl_list *actions =
-				action_get_actionlist(action, "then");
+				action_get_actionlist(action, ACTION_ARG_THEN);
 			if (!actions) {
-				action_arg_add_actionlist(action, "then");
-				actions = action_get_actionlist(action, "then");
+				action_arg_add_actionlist(action, ACTION_ARG_THEN);
+				actions = action_get_actionlist(action, ACTION_ARG_THEN);
 			}
 			append_parsed_actions(child, actions);
 		} else if (!strcasecmp(key, "else")) {
 			struct wl_list *actions =
-				action_get_actionlist(action, "else");
+				action_get_actionlist(action, ACTION_ARG_ELSE);
 			if (!actions) {
-				action_arg_add_actionlist(action, "else");
-				actions = action_get_actionlist(action, "else");
+				action_arg_add_actionlist(action, ACTION_ARG_ELSE);
+				actions = action_get_actionlist(action, ACTION_ARG_ELSE);
 			}
 			append_parsed_actions(child, actions);
 		} else if (!strcasecmp(key, "none")) {
 			struct wl_list *actions =
-				action_get_actionlist(action, "none");
+				action_get_actionlist(action, ACTION_ARG_NONE);
 			if (!actions) {
-				action_arg_add_actionlist(action, "none");
-				actions = action_get_actionlist(action, "none");
+				action_arg_add_actionlist(action, ACTION_ARG_NONE);
+				actions = action_get_actionlist(action, ACTION_ARG_NONE);
 			}
 			append_parsed_actions(child, actions);
 		} else if (!strcasecmp(key, "name")) {
@@ -1431,6 +1434,8 @@ entry(xmlNode *node, char *nodename, char *content)
 		rc.menu_ignore_button_release_period = atoi(content);
 	} else if (!strcasecmp(nodename, "showIcons.menu")) {
 		set_bool(content, &rc.menu_show_icons);
+	} else if (!strcasecmp(nodename, "releaseDelay.menu")) {
+		rc.menu_release_delay = atoi(content);
 	} else if (!strcasecmp(nodename, "width.magnifier")) {
 		rc.mag_width = atoi(content);
 	} else if (!strcasecmp(nodename, "height.magnifier")) {
@@ -1473,22 +1478,197 @@ traverse(xmlNode *node)
 	}
 }
 
+/*
+ * Maps children of top-level elements to the domain they belong to. The
+ * first match wins and a NULL child matches all children of the element.
+ */
+static const struct {
+	const char *element;
+	const char *child;
+	enum config_domain domain;
+} config_domains[] = {
+	{ "theme", "font", CONFIG_DOMAIN_FONTS },
+	{ "theme", "icon", CONFIG_DOMAIN_ICON_THEME },
+	{ "theme", NULL, CONFIG_DOMAIN_THEME },
+	{ "keyboard", "keybind", CONFIG_DOMAIN_KEYBINDS },
+	{ "keyboard", "default", CONFIG_DOMAIN_KEYBINDS },
+	{ "keyboard", NULL, CONFIG_DOMAIN_INPUT },
+	{ "mouse", NULL, CONFIG_DOMAIN_MOUSEBINDS },
+	{ "libinput", NULL, CONFIG_DOMAIN_INPUT },
+	{ "touch", NULL, CONFIG_DOMAIN_INPUT },
+	{ "tablet", NULL, CONFIG_DOMAIN_INPUT },
+	{ "tabletTool", NULL, CONFIG_DOMAIN_INPUT },
+	{ "windowRules", NULL, CONFIG_DOMAIN_WINDOW_RULES },
+	{ "regions", NULL, CONFIG_DOMAIN_REGIONS },
+	{ "desktops", NULL, CONFIG_DOMAIN_WORKSPACES },
+	{ "menu", NULL, CONFIG_DOMAIN_MENUS },
+};
+
+static enum config_domain
+get_config_domain(const char *element, const char *child)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(config_domains); i++) {
+		if (!strcasecmp(config_domains[i].element, element)
+				&& (!config_domains[i].child
+				|| !strcasecmp(config_domains[i].child, child))) {
+			return config_domains[i].domain;
+		}
+	}
+	return CONFIG_DOMAIN_CORE;
+}
+
+/* Add the serialized children of each top-level element to their domain */
+static void
+fingerprint_xml(xmlNode *root, uint64_t *fingerprints)
+{
+	xmlBuffer *buf = xmlBufferCreate();
+	for (xmlNode *element = root->children; element; element = element->next) {
+		if (element->type != XML_ELEMENT_NODE) {
+			continue;
+		}
+		const char *element_name = (const char *)element->name;
+		for (xmlNode *child = element->children; child; child = child->next) {
+			if (child->type != XML_ELEMENT_NODE) {
+				continue;
+			}
+			enum config_domain domain = get_config_domain(
+				element_name, (const char *)child->name);
+			xmlBufferEmpty(buf);
+			xmlNodeDump(buf, child->doc, child, 0, 0);
+
+			uint64_t *hash = &fingerprints[domain];
+			*hash = hash_add_str(*hash, element_name);
+			*hash = hash_add(*hash, xmlBufferContent(buf),
+				xmlBufferLength(buf));
+		}
+	}
+	xmlBufferFree(buf);
+}
+
+static uint64_t
+hash_file_stat(uint64_t hash, const char *path)
+{
+	struct stat st;
+	if (stat(path, &st)) {
+		return hash;
+	}
+	hash = hash_add_str(hash, path);
+	hash = hash_add(hash, &st.st_ino, sizeof(st.st_ino));
+	hash = hash_add(hash, &st.st_size, sizeof(st.st_size));
+	return hash_add(hash, &st.st_mtim, sizeof(st.st_mtim));
+}
+
+static uint64_t
+hash_config_files(uint64_t hash, const char *filename)
+{
+	struct wl_list paths;
+	paths_config_create(&paths, filename);
+	struct path *path;
+	wl_list_for_each(path, &paths, link) {
+		hash = hash_file_stat(hash, path->string);
+	}
+	paths_destroy(&paths);
+	return hash;
+}
+
+/*
+ * Rather than tracking which themerc and button images are read, cover
+ * everything in the directories that may contain the theme
+ */
+static uint64_t
+hash_theme_dirs(uint64_t hash, const char *theme_name)
+{
+	struct wl_list paths;
+	paths_theme_create(&paths, theme_name, "themerc");
+
+	/* Summed up so that the order of directory entries does not matter */
+	uint64_t sum = 0;
+	struct path *path;
+	wl_list_for_each(path, &paths, link) {
+		char *dir = xstrdup(path->string);
+		char *slash = strrchr(dir, '/');
+		if (slash) {
+			*slash = '\0';
+		}
+		DIR *d = opendir(dir);
+		struct dirent *entry;
+		while (d && (entry = readdir(d))) {
+			char *file = strdup_printf("%s/%s", dir, entry->d_name);
+			sum += hash_file_stat(HASH_INIT, file);
+			free(file);
+		}
+		if (d) {
+			closedir(d);
+		}
+		free(dir);
+	}
+	paths_destroy(&paths);
+	return hash_add(hash, &sum, sizeof(sum));
+}
+
+/* Inputs of the domains which are not part of rc.xml */
+static void
+fingerprint_external_inputs(void)
+{
+	uint64_t *hash = &rc.fingerprints[CONFIG_DOMAIN_THEME];
+	if (rc.theme_name) {
+		*hash = hash_theme_dirs(*hash, rc.theme_name);
+	}
+	*hash = hash_config_files(*hash, "themerc-override");
+
+	hash = &rc.fingerprints[CONFIG_DOMAIN_MENUS];
+	*hash = hash_config_files(*hash, "menu.xml");
+
+	/* Keymaps and cursors are configured via the environment file */
+	static const char *const input_env_vars[] = {
+		"XKB_DEFAULT_RULES",
+		"XKB_DEFAULT_MODEL",
+		"XKB_DEFAULT_LAYOUT",
+		"XKB_DEFAULT_VARIANT",
+		"XKB_DEFAULT_OPTIONS",
+		"XCURSOR_THEME",
+		"XCURSOR_SIZE",
+	};
+	hash = &rc.fingerprints[CONFIG_DOMAIN_INPUT];
+	for (size_t i = 0; i < ARRAY_SIZE(input_env_vars); i++) {
+		*hash = hash_add_str(*hash, getenv(input_env_vars[i]));
+	}
+}
+
+struct rcxml_file {
+	char *path;
+	/* NULL if the file is not well-formed */
+	xmlDoc *doc;
+	struct wl_list link; /* rcxml_source.files */
+};
+
+struct rcxml_source {
+	struct wl_list files; /* rcxml_file.link, in the order to apply them */
+	uint64_t fingerprints[CONFIG_DOMAIN_COUNT];
+	/* Path of the first file which could not be parsed */
+	const char *error;
+};
+
 static void
-rcxml_parse_xml(struct buf *b)
+rcxml_source_add_file(struct rcxml_source *source, const char *path,
+		struct buf *b)
 {
+	struct rcxml_file *file = znew(*file);
+	file->path = xstrdup(path);
+	wl_list_append(&source->files, &file->link);
+
 	int options = 0;
-	xmlDoc *d = xmlReadMemory(b->data, b->len, NULL, NULL, options);
-	if (!d) {
-		nag_log(WLR_ERROR, "error parsing config file");
+	file->doc = xmlReadMemory(b->data, b->len, NULL, NULL, options);
+	if (!file->doc) {
+		if (!source->error) {
+			source->error = file->path;
+		}
 		return;
 	}
-	xmlNode *root = xmlDocGetRootElement(d);
+	xmlNode *root = xmlDocGetRootElement(file->doc);
 
 	lab_xml_expand_dotted_attributes(root);
-	traverse(root);
-
-	xmlFreeDoc(d);
-	xmlCleanupParser();
+	fingerprint_xml(root, source->fingerprints);
 }
 
 static void
@@ -1601,6 +1781,7 @@ rcxml_init(void)
 
 	rc.menu_ignore_button_release_period = 250;
 	rc.menu_show_icons = true;
+	rc.menu_release_delay = 30000;
 
 	rc.mag_width = 400;
 	rc.mag_height = 400;
@@ -2003,10 +2184,14 @@ validate(void)
 	}
 }
 
-void
-rcxml_read(const char *filename)
+struct rcxml_source *
+rcxml_source_load(const char *filename, bool merge_config)
 {
-	rcxml_init();
+	struct rcxml_source *source = znew(*source);
+	wl_list_init(&source->files);
+	for (size_t i = 0; i < ARRAY_SIZE(source->fingerprints); i++) {
+		source->fingerprints[i] = HASH_INIT;
+	}
 
 	struct wl_list paths;
 
@@ -2021,13 +2206,12 @@ rcxml_read(const char *filename)
 	}
 
 	/* Reading file into buffer before parsing - better for unit tests */
-	bool should_merge_config = rc.merge_config;
 	struct wl_list *(*iter)(struct wl_list *list);
-	iter = should_merge_config ? paths_get_prev : paths_get_next;
+	iter = merge_config ? paths_get_prev : paths_get_next;
 
 	/*
 	 * This is the equivalent of a wl_list_for_each() which optionally
-	 * iterates in reverse depending on 'should_merge_config'
+	 * iterates in reverse depending on 'merge_config'
 	 *
 	 * If not merging, we iterate forwards and break after the first
 	 * iteration.
@@ -2042,17 +2226,67 @@ rcxml_read(const char *filename)
 			continue;
 		}
 
-		nag_log(WLR_INFO, "read config file %s", path->string);
-
-		rcxml_parse_xml(&b);
+		rcxml_source_add_file(source, path->string, &b);
 		buf_reset(&b);
-		if (!should_merge_config) {
+		if (!merge_config) {
 			break;
 		}
 	};
 	paths_destroy(&paths);
+	return source;
+}
+
+const char *
+rcxml_source_get_error(struct rcxml_source *source)
+{
+	return source->error;
+}
+
+void
+rcxml_source_destroy(struct rcxml_source *source)
+{
+	if (!source) {
+		return;
+	}
+	struct rcxml_file *file, *tmp;
+	wl_list_for_each_safe(file, tmp, &source->files, link) {
+		wl_list_remove(&file->link);
+		if (file->doc) {
+			xmlFreeDoc(file->doc);
+		}
+		free(file->path);
+		free(file);
+	}
+	free(source);
+}
+
+void
+rcxml_read_source(struct rcxml_source *source)
+{
+	rcxml_init();
+	memcpy(rc.fingerprints, source->fingerprints, sizeof(rc.fingerprints));
+
+	struct rcxml_file *file;
+	wl_list_for_each(file, &source->files, link) {
+		nag_log(WLR_INFO, "read config file %s", file->path);
+		if (!file->doc) {
+			nag_log(WLR_ERROR, "error parsing config file");
+			continue;
+		}
+		traverse(xmlDocGetRootElement(file->doc));
+	}
 	post_processing();
 	validate();
+	fingerprint_external_inputs();
+}
+
+void
+rcxml_read(const char *filename)
+{
+	struct rcxml_source *source =
+		rcxml_source_load(filename, rc.merge_config);
+	rcxml_read_source(source);
+	rcxml_source_destroy(source);
 }
 
 void
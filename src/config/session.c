@@ -14,11 +14,14 @@
 #include "common/buf.h"
 #include "common/dir.h"
 #include "common/file-helpers.h"
+#include "common/macros.h"
 #include "common/parse-bool.h"
 #include "common/spawn.h"
 #include "common/string-helpers.h"
+#include "common/time.h"
 #include "config/rcxml.h"
 #include "labwc.h"
+#include "startup-timeline.h"
 
 #if WLR_HAS_DRM_BACKEND
 	#include <wlr/backend/drm.h>
@@ -38,6 +41,24 @@ static const char * const env_vars[] = {
 };
 
 #define LAB_ENV_VAR_MAX_SIZE 1024
+
+/* Autostart does not wait any longer for the activation environment */
+#define ACTIVATION_ENV_TIMEOUT_MS 5000
+
+/*
+ * At startup, the activation environment is updated by child processes
+ * which are not waited for on the main thread. Autostart and the startup
+ * command are run once all of them have exited.
+ */
+static struct {
+	/* dbus and systemd, each for env_vars and DISPLAY */
+	pid_t pids[4];
+	int nr_pending;
+	double start_ms;
+	struct wl_event_source *timeout;
+	const char *startup_cmd;
+} activation;
+
 static void
 process_line(char *line)
 {
@@ -213,18 +234,45 @@ should_update_activation(void)
 	return have_drm;
 }
 
+static void
+add_pending_activation(pid_t pid)
+{
+	if (pid <= 0) {
+		return;
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(activation.pids); i++) {
+		if (!activation.pids[i]) {
+			activation.pids[i] = pid;
+			activation.nr_pending++;
+			return;
+		}
+	}
+	assert(false && "too many activation environment updates");
+}
+
+static void
+run_update(const char *cmd, bool initialize)
+{
+	/* The event loop does not run anymore when shutting down */
+	if (initialize) {
+		add_pending_activation(spawn_async_no_shell(cmd));
+	} else {
+		spawn_sync_no_shell(cmd);
+	}
+}
+
 static void
 execute_update(const char *env_keys, const char *env_unset_keys, bool initialize)
 {
 	char *cmd =
 		strdup_printf("dbus-update-activation-environment %s",
 			initialize ? env_keys : env_unset_keys);
-	spawn_sync_no_shell(cmd);
+	run_update(cmd, initialize);
 	free(cmd);
 
 	cmd = strdup_printf("systemctl --user %s %s",
 		initialize ? "import-environment" : "unset-environment", env_keys);
-	spawn_sync_no_shell(cmd);
+	run_update(cmd, initialize);
 	free(cmd);
 }
 
@@ -330,17 +378,91 @@ session_run_script(const char *script)
 	paths_destroy(&paths);
 }
 
+static void
+run_autostart(void)
+{
+	session_run_script("autostart");
+	if (activation.startup_cmd) {
+		spawn_async_no_shell(activation.startup_cmd);
+	}
+	startup_timeline_autostart_done();
+}
+
+static void
+finish_activation(bool timed_out)
+{
+	double elapsed_ms = get_time_ms() - activation.start_ms;
+	if (timed_out) {
+		wlr_log(WLR_ERROR, "activation environment not updated after "
+			"%.0f ms, running autostart anyway", elapsed_ms);
+	} else {
+		wlr_log(WLR_INFO, "activation environment updated in %.1f ms",
+			elapsed_ms);
+	}
+
+	/* Children still running are reaped as usual */
+	memset(activation.pids, 0, sizeof(activation.pids));
+	activation.nr_pending = 0;
+	wl_event_source_remove(activation.timeout);
+	activation.timeout = NULL;
+	startup_timeline_mark("activation env");
+
+	run_autostart();
+}
+
+static int
+handle_activation_timeout(void *data)
+{
+	finish_activation(/* timed_out */ true);
+	return 0;
+}
+
+bool
+session_check_pid(pid_t pid, int exit_code)
+{
+	for (size_t i = 0; pid > 0 && i < ARRAY_SIZE(activation.pids); i++) {
+		if (activation.pids[i] != pid) {
+			continue;
+		}
+		/* Failures are expected if dbus or systemd are not used */
+		wlr_log(WLR_DEBUG, "activation environment update %ld exited "
+			"with %d", (long)pid, exit_code);
+		activation.pids[i] = 0;
+		if (--activation.nr_pending == 0) {
+			finish_activation(/* timed_out */ false);
+		}
+		return true;
+	}
+	return false;
+}
+
 void
-session_autostart_init(void)
+session_autostart_init(const char *startup_cmd)
 {
+	activation.startup_cmd = startup_cmd;
+	activation.start_ms = get_time_ms();
+
 	/* Update dbus and systemd user environment, each may fail gracefully */
 	update_activation_env(/* initialize */ true);
-	session_run_script("autostart");
+	if (!activation.nr_pending) {
+		run_autostart();
+		return;
+	}
+
+	activation.timeout = wl_event_loop_add_timer(server.wl_event_loop,
+		handle_activation_timeout, NULL);
+	wl_event_source_timer_update(activation.timeout,
+		ACTIVATION_ENV_TIMEOUT_MS);
 }
 
 void
 session_shutdown(void)
 {
+	if (activation.timeout) {
+		wl_event_source_remove(activation.timeout);
+		activation.timeout = NULL;
+	}
+
 	session_run_script("shutdown");
 
 	/* Clear the dbus and systemd user environment, each may fail gracefully */
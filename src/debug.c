@@ -6,6 +6,7 @@
 #include "common/lab-scene-rect.h"
 #include "common/scene-helpers.h"
 #include "common/string-helpers.h"
+#include "desktop-entry.h"
 #include "input/ime.h"
 #include "labwc.h"
 #include "node.h"
@@ -261,6 +262,10 @@ debug_dump_scene(void)
 	printf("\n");
 	dump_tree(&server.scene->tree.node, 0, 0, 0);
 	printf("\n");
+#if HAVE_LIBSFDO
+	desktop_entry_print_stats();
+	printf("\n");
+#endif
 
 	/*
 	 * Reset last_view so we don't access a
@@ -1,28 +1,195 @@
 // SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
 #include "desktop-entry.h"
+#include <assert.h>
+#include <dirent.h>
+#include <glib.h>
 #include <locale.h>
+#include <pthread.h>
 #include <sfdo-desktop.h>
 #include <sfdo-icon.h>
 #include <sfdo-basedir.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#if HAVE_INOTIFY
+#include <sys/inotify.h>
+#endif
+#include <unistd.h>
 #include <wlr/util/log.h>
+#include "common/buf.h"
+#include "common/macros.h"
 #include "common/mem.h"
 #include "common/string-helpers.h"
+#include "common/thread-pool.h"
+#include "common/time.h"
 #include "config/rcxml.h"
 #include "img/img.h"
 #include "labwc.h"
 
 static const char *debug_libsfdo;
 
+/*
+ * Icons are loaded from worker threads (see scaled-icon-buffer.c), so all
+ * access to server.sfdo and the libsfdo objects it holds must be done with
+ * this lock held. Loading the image files themselves is done without it.
+ */
+static pthread_mutex_t sfdo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* What a (re-)load of the database is expected to change */
+enum db_change {
+	DB_CHANGE_APPS = 1 << 0,
+	DB_CHANGE_ICONS = 1 << 1,
+	DB_CHANGE_ALL = DB_CHANGE_APPS | DB_CHANGE_ICONS,
+};
+
+/*
+ * Resolved icons keyed by "<type>:<size>:<scale>:<name>", where type is 'i'
+ * for icon names and 'a' for app_ids, and size/scale are the values passed
+ * to libsfdo. Entries with a NULL img record failed lookups so that those
+ * are not repeated either. Callers get copies of the cached images, which
+ * share the decoded image data.
+ *
+ * The cache is cleared whenever the icon theme is (re-)loaded. Lookups
+ * which started before that do not add their result, see generation.
+ */
+struct icon_cache_entry {
+	struct lab_img *img;
+};
+
+static struct {
+	pthread_mutex_t lock;
+	GHashTable *entries; /* char *key -> struct icon_cache_entry */
+	unsigned int generation;
+	unsigned int hits;
+	unsigned int misses;
+} icon_cache = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void
+icon_cache_entry_destroy(void *data)
+{
+	struct icon_cache_entry *entry = data;
+	lab_img_destroy(entry->img);
+	free(entry);
+}
+
+/*
+ * Return true if @key was found, in which case @img is set to a copy of
+ * the cached image or NULL for a negative entry.
+ */
+static bool
+icon_cache_lookup(const char *key, struct lab_img **img,
+		unsigned int *generation)
+{
+	pthread_mutex_lock(&icon_cache.lock);
+	struct icon_cache_entry *entry = icon_cache.entries
+		? g_hash_table_lookup(icon_cache.entries, key) : NULL;
+	if (entry) {
+		*img = entry->img ? lab_img_copy(entry->img) : NULL;
+		icon_cache.hits++;
+	} else {
+		icon_cache.misses++;
+	}
+	*generation = icon_cache.generation;
+	pthread_mutex_unlock(&icon_cache.lock);
+	return entry;
+}
+
+/* Takes ownership of @key */
+static void
+icon_cache_insert(char *key, struct lab_img *img, unsigned int generation)
+{
+	pthread_mutex_lock(&icon_cache.lock);
+	if (generation != icon_cache.generation || (icon_cache.entries
+			&& g_hash_table_contains(icon_cache.entries, key))) {
+		pthread_mutex_unlock(&icon_cache.lock);
+		free(key);
+		return;
+	}
+	if (!icon_cache.entries) {
+		icon_cache.entries = g_hash_table_new_full(g_str_hash,
+			g_str_equal, free, icon_cache_entry_destroy);
+	}
+	struct icon_cache_entry *entry = znew(*entry);
+	entry->img = img ? lab_img_copy(img) : NULL;
+	g_hash_table_insert(icon_cache.entries, key, entry);
+	pthread_mutex_unlock(&icon_cache.lock);
+}
+
+static gboolean
+is_app_id_entry(gpointer key, gpointer value, gpointer user_data)
+{
+	return ((const char *)key)[0] == 'a';
+}
+
+/*
+ * Remove entries which may be outdated by @changes. If only desktop
+ * entries have changed, icons looked up by name are still valid.
+ */
+static void
+icon_cache_invalidate(enum db_change changes)
+{
+	pthread_mutex_lock(&icon_cache.lock);
+	icon_cache.generation++;
+	if (icon_cache.entries) {
+		wlr_log(WLR_DEBUG, "invalidating icon cache (%u entries, %u hits, "
+			"%u misses)", g_hash_table_size(icon_cache.entries),
+			icon_cache.hits, icon_cache.misses);
+		if (changes & DB_CHANGE_ICONS) {
+			g_hash_table_destroy(icon_cache.entries);
+			icon_cache.entries = NULL;
+		} else {
+			g_hash_table_foreach_remove(icon_cache.entries,
+				is_app_id_entry, NULL);
+		}
+	}
+	pthread_mutex_unlock(&icon_cache.lock);
+}
+
+/*
+ * Index of the desktop entry database for fuzzy app_id matching, built once
+ * per database load. All names are ASCII case-folded.
+ */
+struct fuzzy_match {
+	/* First entry whose desktop ID basename or StartupWMClass matches */
+	size_t first;
+	bool first_by_wm_class;
+	/* First entry whose desktop ID basename matches, or SIZE_MAX */
+	size_t first_basename;
+};
+
+struct fuzzy_name {
+	char *basename;
+	size_t index;
+};
+
+struct fuzzy_index {
+	struct sfdo_desktop_entry **entries;
+	size_t nr_entries;
+	/* basename or StartupWMClass -> struct fuzzy_match */
+	GHashTable *names;
+	/* basenames sorted for prefix searches */
+	struct fuzzy_name *sorted;
+	/* memoized results: app_id -> struct sfdo_desktop_entry (or NULL) */
+	GHashTable *app_ids;
+};
+
 struct sfdo {
 	struct sfdo_desktop_ctx *desktop_ctx;
 	struct sfdo_icon_ctx *icon_ctx;
 	struct sfdo_desktop_db *desktop_db;
 	struct sfdo_icon_theme *icon_theme;
+	struct fuzzy_index index;
 };
 
+static void fuzzy_index_build(struct fuzzy_index *index,
+	struct sfdo_desktop_db *db);
+static void fuzzy_index_finish(struct fuzzy_index *index);
+
 static void
 log_handler(enum sfdo_log_level level, const char *fmt, va_list args, void *tag)
 {
@@ -54,12 +221,25 @@ log_handler(enum sfdo_log_level level, const char *fmt, va_list args, void *tag)
 	_wlr_vlog((enum wlr_log_importance)level, fmt, args);
 }
 
-void
-desktop_entry_init(void)
+static void
+sfdo_destroy(struct sfdo *sfdo)
 {
-	struct sfdo *sfdo = znew(*sfdo);
+	if (!sfdo) {
+		return;
+	}
+	fuzzy_index_finish(&sfdo->index);
+	sfdo_icon_theme_destroy(sfdo->icon_theme);
+	sfdo_desktop_db_destroy(sfdo->desktop_db);
+	sfdo_icon_ctx_destroy(sfdo->icon_ctx);
+	sfdo_desktop_ctx_destroy(sfdo->desktop_ctx);
+	free(sfdo);
+}
 
-	debug_libsfdo = getenv("LABWC_DEBUG_LIBSFDO");
+/* Runs on a worker thread, so must not access rc or server */
+static struct sfdo *
+sfdo_load(const char *icon_theme_name, const char *locale)
+{
+	struct sfdo *sfdo = znew(*sfdo);
 
 	struct sfdo_basedir_ctx *basedir_ctx = sfdo_basedir_ctx_create();
 	if (!basedir_ctx) {
@@ -82,11 +262,6 @@ desktop_entry_init(void)
 	sfdo_icon_ctx_set_log_handler(
 		sfdo->icon_ctx, level, log_handler, "sfdo-icon");
 
-	char *locale = NULL;
-#if HAVE_NLS
-	locale = setlocale(LC_ALL, "");
-#endif
-
 	sfdo->desktop_db = sfdo_desktop_db_load(sfdo->desktop_ctx, locale);
 	if (!sfdo->desktop_db) {
 		goto err_desktop_db;
@@ -108,7 +283,7 @@ desktop_entry_init(void)
 
 	sfdo->icon_theme = sfdo_icon_theme_load(
 		sfdo->icon_ctx,
-		rc.icon_theme_name, load_options);
+		icon_theme_name, load_options);
 	if (!sfdo->icon_theme) {
 		/*
 		 * sfdo_icon_theme_load() falls back to hicolor theme with
@@ -117,7 +292,7 @@ desktop_entry_init(void)
 		 * So manually call sfdo_icon_theme_load() again here.
 		 */
 		wlr_log(WLR_ERROR, "Failed to load icon theme %s, falling back to 'hicolor'",
-			rc.icon_theme_name);
+			icon_theme_name);
 
 		if (!debug_libsfdo) {
 			wlr_log(WLR_ERROR, "Further information is available by setting "
@@ -134,8 +309,8 @@ desktop_entry_init(void)
 	/* basedir_ctx is not referenced by other objects */
 	sfdo_basedir_ctx_destroy(basedir_ctx);
 
-	server.sfdo = sfdo;
-	return;
+	fuzzy_index_build(&sfdo->index, sfdo->desktop_db);
+	return sfdo;
 
 err_icon_theme:
 	sfdo_desktop_db_destroy(sfdo->desktop_db);
@@ -152,22 +327,401 @@ err_basedir_ctx:
 		wlr_log(WLR_ERROR, "Further information is available by setting "
 			"the LABWC_DEBUG_LIBSFDO=1 env var before starting labwc");
 	}
+	return NULL;
 }
 
-void
-desktop_entry_finish(void)
+/*
+ * Loading the desktop entry database and the icon theme can take a while on
+ * systems with many applications, so it is done on a worker thread. Until
+ * it has finished, the previously loaded database (if any) remains in use
+ * and icons which cannot be found yet are left empty. Listeners added with
+ * desktop_entry_add_ready_listener() are notified once the new database has
+ * been swapped in so that they can refresh.
+ */
+struct load_job {
+	/* Input */
+	char *icon_theme_name;
+	char *locale;
+	enum db_change changes;
+	/* Output */
+	struct sfdo *sfdo;
+	double duration_ms;
+};
+
+static struct {
+	struct thread_pool *pool;
+	struct load_job *pending;
+	/* Reload requested while a load was in progress */
+	enum db_change queued_changes;
+	bool finishing;
+	/* Inputs of the last load, to skip unnecessary reloads */
+	char *fingerprint;
+	struct wl_signal ready;
+} loader;
+
+/*
+ * Everything the database depends on: the icon theme name, the XDG
+ * base directories (including $HOME which their defaults are based on)
+ * and the locale used for translated names
+ */
+static char *
+get_fingerprint(void)
 {
-	struct sfdo *sfdo = server.sfdo;
-	if (!sfdo) {
+	static const char *const vars[] = {
+		"HOME", "XDG_DATA_HOME", "XDG_DATA_DIRS", "LANG", "LC_ALL",
+	};
+	struct buf buf = BUF_INIT;
+	buf_add(&buf, rc.icon_theme_name ? rc.icon_theme_name : "");
+	for (size_t i = 0; i < ARRAY_SIZE(vars); i++) {
+		const char *value = getenv(vars[i]);
+		buf_add_fmt(&buf, "\n%s", value ? value : "");
+	}
+	return buf.data;
+}
+
+static void
+run_load_job(void *data)
+{
+	struct load_job *job = data;
+	double start_ms = get_time_ms();
+	job->sfdo = sfdo_load(job->icon_theme_name, job->locale);
+	job->duration_ms = get_time_ms() - start_ms;
+}
+
+static void start_load(enum db_change changes);
+
+#if HAVE_INOTIFY
+/*
+ * Newly installed or removed applications and icon themes are picked up
+ * by watching the directories libsfdo reads from. Bursts of changes (e.g.
+ * from package installs) are collected for a while before reloading.
+ *
+ * inotify is not recursive. Changes deep inside an icon theme are noticed
+ * through the theme's icon-theme.cache and index.theme, which are updated
+ * by package managers, so only the top level of each theme is watched.
+ */
+#define WATCH_DEBOUNCE_MS 2000
+
+struct watch {
+	int wd;
+	enum db_change change;
+};
+
+static struct {
+	int fd;
+	struct wl_event_source *source;
+	struct wl_event_source *debounce;
+	struct wl_array watches; /* struct watch */
+	enum db_change changes;
+} watcher = {
+	.fd = -1,
+};
+
+static enum db_change
+get_watch_change(int wd)
+{
+	struct watch *watch;
+	wl_array_for_each(watch, &watcher.watches) {
+		if (watch->wd == wd) {
+			return watch->change;
+		}
+	}
+	return 0;
+}
+
+static int
+handle_watch_event(int fd, uint32_t mask, void *data)
+{
+	/* The union makes the buffer suitably aligned for the events */
+	union {
+		struct inotify_event event;
+		char buf[4096];
+	} u;
+	ssize_t len;
+	while ((len = read(fd, u.buf, sizeof(u.buf))) > 0) {
+		const char *p = u.buf;
+		while (p < u.buf + len) {
+			const struct inotify_event *event = (const void *)p;
+			if (event->mask & IN_Q_OVERFLOW) {
+				watcher.changes |= DB_CHANGE_ALL;
+			} else {
+				watcher.changes |= get_watch_change(event->wd);
+			}
+			p += sizeof(*event) + event->len;
+		}
+	}
+	if (watcher.changes) {
+		wl_event_source_timer_update(watcher.debounce,
+			WATCH_DEBOUNCE_MS);
+	}
+	return 0;
+}
+
+static int
+handle_debounce(void *data)
+{
+	wlr_log(WLR_DEBUG, "%s%s changed, reloading",
+		watcher.changes & DB_CHANGE_APPS ? "[applications]" : "",
+		watcher.changes & DB_CHANGE_ICONS ? "[icons]" : "");
+	start_load(watcher.changes);
+	watcher.changes = 0;
+	return 0;
+}
+
+static void
+add_watch(const char *path, enum db_change change)
+{
+	int wd = inotify_add_watch(watcher.fd, path, IN_CREATE | IN_DELETE
+		| IN_MOVE | IN_CLOSE_WRITE | IN_ONLYDIR);
+	if (wd < 0) {
+		/* Most of the directories usually don't exist */
 		return;
 	}
+	struct watch *watch = wl_array_add(&watcher.watches, sizeof(*watch));
+	watch->wd = wd;
+	watch->change = change;
+}
 
-	sfdo_icon_theme_destroy(sfdo->icon_theme);
-	sfdo_desktop_db_destroy(sfdo->desktop_db);
-	sfdo_icon_ctx_destroy(sfdo->icon_ctx);
-	sfdo_desktop_ctx_destroy(sfdo->desktop_ctx);
-	free(sfdo);
+static void
+add_icon_watches(const char *icons_dir)
+{
+	add_watch(icons_dir, DB_CHANGE_ICONS);
+
+	DIR *dir = opendir(icons_dir);
+	if (!dir) {
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir))) {
+		if (entry->d_name[0] == '.') {
+			continue;
+		}
+		/* IN_ONLYDIR skips anything that is not a theme directory */
+		char *path = strdup_printf("%s/%s", icons_dir, entry->d_name);
+		add_watch(path, DB_CHANGE_ICONS);
+		free(path);
+	}
+	closedir(dir);
+}
+
+static void
+add_data_dir_watches(const char *data_dir)
+{
+	char *path = strdup_printf("%s/applications", data_dir);
+	add_watch(path, DB_CHANGE_APPS);
+	free(path);
+
+	path = strdup_printf("%s/icons", data_dir);
+	add_icon_watches(path);
+	free(path);
+}
+
+/* Watch the same directories as libsfdo reads from */
+static void
+watcher_update(void)
+{
+	if (watcher.fd < 0) {
+		return;
+	}
+
+	struct watch *watch;
+	wl_array_for_each(watch, &watcher.watches) {
+		inotify_rm_watch(watcher.fd, watch->wd);
+	}
+	wl_array_release(&watcher.watches);
+	wl_array_init(&watcher.watches);
+
+	const char *home = getenv("HOME");
+	const char *data_home = getenv("XDG_DATA_HOME");
+	if (!string_null_or_empty(data_home)) {
+		add_data_dir_watches(data_home);
+	} else if (home) {
+		char *path = strdup_printf("%s/.local/share", home);
+		add_data_dir_watches(path);
+		free(path);
+	}
+
+	const char *data_dirs = getenv("XDG_DATA_DIRS");
+	if (string_null_or_empty(data_dirs)) {
+		data_dirs = "/usr/local/share:/usr/share";
+	}
+	gchar **dirs = g_strsplit(data_dirs, ":", -1);
+	for (gchar **dir = dirs; *dir; dir++) {
+		if (**dir) {
+			add_data_dir_watches(*dir);
+		}
+	}
+	g_strfreev(dirs);
+
+	if (home) {
+		char *path = strdup_printf("%s/.icons", home);
+		add_icon_watches(path);
+		free(path);
+	}
+	add_watch("/usr/share/pixmaps", DB_CHANGE_ICONS);
+
+	wlr_log(WLR_DEBUG, "watching %zu directories for desktop entries and icons",
+		watcher.watches.size / sizeof(struct watch));
+}
+
+static void
+watcher_init(void)
+{
+	wl_array_init(&watcher.watches);
+	watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (watcher.fd < 0) {
+		wlr_log_errno(WLR_INFO, "cannot watch for new applications");
+		return;
+	}
+	watcher.source = wl_event_loop_add_fd(server.wl_event_loop,
+		watcher.fd, WL_EVENT_READABLE, handle_watch_event, NULL);
+	watcher.debounce = wl_event_loop_add_timer(server.wl_event_loop,
+		handle_debounce, NULL);
+}
+
+static void
+watcher_finish(void)
+{
+	if (watcher.debounce) {
+		wl_event_source_remove(watcher.debounce);
+		watcher.debounce = NULL;
+	}
+	if (watcher.source) {
+		wl_event_source_remove(watcher.source);
+		watcher.source = NULL;
+	}
+	if (watcher.fd >= 0) {
+		close(watcher.fd);
+		watcher.fd = -1;
+	}
+	wl_array_release(&watcher.watches);
+	wl_array_init(&watcher.watches);
+	watcher.changes = 0;
+}
+#else
+static void watcher_init(void) {}
+static void watcher_update(void) {}
+static void watcher_finish(void) {}
+#endif /* HAVE_INOTIFY */
+
+static void
+handle_load_done(void *data)
+{
+	struct load_job *job = data;
+	assert(job == loader.pending);
+	loader.pending = NULL;
+
+	if (loader.finishing || loader.queued_changes) {
+		/* The result is already outdated */
+		sfdo_destroy(job->sfdo);
+	} else if (job->sfdo) {
+		wlr_log(WLR_INFO, "loaded desktop entries and icon theme in %.1f ms",
+			job->duration_ms);
+
+		pthread_mutex_lock(&sfdo_lock);
+		struct sfdo *old = server.sfdo;
+		server.sfdo = job->sfdo;
+		pthread_mutex_unlock(&sfdo_lock);
+
+		icon_cache_invalidate(job->changes);
+		sfdo_destroy(old);
+		wl_signal_emit_mutable(&loader.ready, NULL);
+	}
+
+	if (loader.finishing) {
+		goto out;
+	}
+	if (loader.queued_changes) {
+		/* Also re-do what the discarded load was for */
+		enum db_change changes = loader.queued_changes | job->changes;
+		loader.queued_changes = 0;
+		start_load(changes);
+	} else {
+		/* Directories may have been added or removed */
+		watcher_update();
+	}
+out:
+	free(job->icon_theme_name);
+	free(job->locale);
+	free(job);
+}
+
+static void
+start_load(enum db_change changes)
+{
+	if (loader.pending) {
+		loader.queued_changes |= changes;
+		return;
+	}
+
+	free(loader.fingerprint);
+	loader.fingerprint = get_fingerprint();
+
+	struct load_job *job = znew(*job);
+	job->icon_theme_name = rc.icon_theme_name
+		? xstrdup(rc.icon_theme_name) : NULL;
+
+	/* setlocale() is not thread-safe, so query it here */
+	const char *locale = NULL;
+#if HAVE_NLS
+	locale = setlocale(LC_ALL, "");
+#endif
+	job->locale = locale ? xstrdup(locale) : NULL;
+	job->changes = changes;
+
+	loader.pending = job;
+	thread_pool_submit_async(loader.pool, run_load_job, handle_load_done, job);
+}
+
+void
+desktop_entry_init(void)
+{
+	debug_libsfdo = getenv("LABWC_DEBUG_LIBSFDO");
+
+	wl_signal_init(&loader.ready);
+	loader.finishing = false;
+	loader.pool = thread_pool_create(1, server.wl_event_loop);
+	watcher_init();
+	start_load(DB_CHANGE_ALL);
+}
+
+void
+desktop_entry_reconfigure(void)
+{
+	char *fingerprint = get_fingerprint();
+	bool changed = !str_equal(fingerprint, loader.fingerprint);
+	free(fingerprint);
+
+	if (changed) {
+		wlr_log(WLR_DEBUG, "icon theme or data dirs changed, reloading");
+		start_load(DB_CHANGE_ALL);
+	}
+}
+
+void
+desktop_entry_add_ready_listener(struct wl_listener *listener)
+{
+	wl_signal_add(&loader.ready, listener);
+}
+
+void
+desktop_entry_finish(void)
+{
+	watcher_finish();
+
+	/* Wait for a pending load, whose result is then discarded */
+	loader.finishing = true;
+	thread_pool_destroy(loader.pool);
+	loader.pool = NULL;
+	zfree(loader.fingerprint);
+
+	pthread_mutex_lock(&sfdo_lock);
+	struct sfdo *sfdo = server.sfdo;
 	server.sfdo = NULL;
+	pthread_mutex_unlock(&sfdo_lock);
+
+	icon_cache_invalidate(DB_CHANGE_ALL);
+	sfdo_destroy(sfdo);
 }
 
 struct icon_ctx {
@@ -246,89 +800,200 @@ err:
 	return -1;
 }
 
-/*
- * Looks up an application desktop entry using fuzzy matching
- * (e.g. "thunderbird" matches "org.mozilla.Thunderbird.desktop"
- * and "XTerm" matches "xterm.desktop"). This is not per any spec
- * but is needed to find icons for existing applications.
- *
- * The second loop tries to match more partial strings, for
- * example "gimp-2.0" would match "org.something.gimp.desktop".
- */
-static struct sfdo_desktop_entry *
-get_db_entry_by_id_fuzzy(struct sfdo_desktop_db *db, const char *app_id)
+static const char *
+get_basename(const char *desktop_id)
+{
+	/* Get portion of desktop ID after last '.' */
+	const char *dot = strrchr(desktop_id, '.');
+	return dot ? (dot + 1) : desktop_id;
+}
+
+static void
+index_add_name(GHashTable *names, const char *name, size_t index,
+		bool by_wm_class)
 {
-	size_t n_entries;
-	struct sfdo_desktop_entry **entries = sfdo_desktop_db_get_entries(db, &n_entries);
+	char *folded = g_ascii_strdown(name, -1);
+	struct fuzzy_match *match = g_hash_table_lookup(names, folded);
+	if (match) {
+		g_free(folded);
+	} else {
+		match = znew(*match);
+		match->first = index;
+		match->first_by_wm_class = by_wm_class;
+		match->first_basename = SIZE_MAX;
+		g_hash_table_insert(names, folded, match);
+	}
+	if (!by_wm_class && match->first_basename == SIZE_MAX) {
+		match->first_basename = index;
+	}
+}
 
-	/* Would match "org.foobar.xterm" when given app-id "XTerm" */
-	for (size_t i = 0; i < n_entries; i++) {
-		struct sfdo_desktop_entry *entry = entries[i];
-		const char *desktop_id = sfdo_desktop_entry_get_id(entry, NULL);
-		/* Get portion of desktop ID after last '.' */
-		const char *dot = strrchr(desktop_id, '.');
-		const char *desktop_id_base = dot ? (dot + 1) : desktop_id;
-
-		if (!strcasecmp(app_id, desktop_id_base)) {
-			wlr_log(WLR_DEBUG, "'%s' to '%s.desktop' via case-insensitive match",
-				app_id, desktop_id);
-			return entry;
-		}
+static int
+compare_fuzzy_names(const void *a, const void *b)
+{
+	const struct fuzzy_name *name_a = a;
+	const struct fuzzy_name *name_b = b;
+	int ret = strcmp(name_a->basename, name_b->basename);
+	if (ret) {
+		return ret;
+	}
+	return name_a->index < name_b->index ? -1 : 1;
+}
+
+static void
+fuzzy_index_build(struct fuzzy_index *index, struct sfdo_desktop_db *db)
+{
+	index->entries = sfdo_desktop_db_get_entries(db, &index->nr_entries);
+	index->names = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, free);
+	index->sorted = znew_n(*index->sorted, index->nr_entries);
+	index->app_ids = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, NULL);
+
+	/* Entries are added in order so that the first match is kept */
+	for (size_t i = 0; i < index->nr_entries; i++) {
+		struct sfdo_desktop_entry *entry = index->entries[i];
+		const char *basename =
+			get_basename(sfdo_desktop_entry_get_id(entry, NULL));
+		index_add_name(index->names, basename, i, false);
+		index->sorted[i] = (struct fuzzy_name){
+			.basename = g_ascii_strdown(basename, -1),
+			.index = i,
+		};
 
 		/* sfdo_desktop_entry_get_startup_wm_class() asserts against APPLICATION */
 		if (sfdo_desktop_entry_get_type(entry) != SFDO_DESKTOP_ENTRY_APPLICATION) {
 			continue;
 		}
-
-		/* Try desktop entry's StartupWMClass also */
 		const char *wm_class =
 			sfdo_desktop_entry_get_startup_wm_class(entry, NULL);
-		if (wm_class && !strcasecmp(app_id, wm_class)) {
-			wlr_log(WLR_DEBUG, "'%s' to '%s.desktop' via StartupWMClass",
-				app_id, desktop_id);
-			return entry;
+		if (wm_class) {
+			index_add_name(index->names, wm_class, i, true);
 		}
 	}
+	qsort(index->sorted, index->nr_entries, sizeof(*index->sorted),
+		compare_fuzzy_names);
+}
 
-	/* Would match "org.foobar.xterm-unicode" when given app-id "XTerm" */
-	const int app_id_len = strlen(app_id);
-	for (size_t i = 0; i < n_entries; i++) {
-		struct sfdo_desktop_entry *entry = entries[i];
-		const char *desktop_id = sfdo_desktop_entry_get_id(entry, NULL);
-		const char *dot = strrchr(desktop_id, '.');
-		const char *desktop_id_base = dot ? (dot + 1) : desktop_id;
-		const int dlen = strlen(desktop_id_base);
-		const int cmp_len = MIN(app_id_len, dlen);
-		if (cmp_len < 3) {
-			/*
-			 * Without this check, app-id "foot" would match
-			 * "something.f" and any app-id would match "R.E.P.O."
-			 */
-			continue;
+static void
+fuzzy_index_finish(struct fuzzy_index *index)
+{
+	for (size_t i = 0; i < index->nr_entries; i++) {
+		g_free(index->sorted[i].basename);
+	}
+	free(index->sorted);
+	g_hash_table_destroy(index->names);
+	g_hash_table_destroy(index->app_ids);
+	*index = (struct fuzzy_index){0};
+}
+
+/* Return the index of the first basename starting with @prefix */
+static size_t
+find_first_with_prefix(struct fuzzy_index *index, const char *prefix)
+{
+	size_t len = strlen(prefix);
+	size_t lo = 0, hi = index->nr_entries;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (strcmp(index->sorted[mid].basename, prefix) < 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
 		}
-		if (!strncasecmp(app_id, desktop_id_base, cmp_len)) {
-			wlr_log(WLR_DEBUG, "'%s' to '%s.desktop' via partial match",
-				app_id, desktop_id);
-			return entry;
+	}
+
+	size_t first = SIZE_MAX;
+	for (size_t i = lo; i < index->nr_entries; i++) {
+		if (strncmp(index->sorted[i].basename, prefix, len)) {
+			break;
 		}
+		first = MIN(first, index->sorted[i].index);
 	}
+	return first;
+}
 
-	return NULL;
+/*
+ * Looks up an application desktop entry using fuzzy matching
+ * (e.g. "thunderbird" matches "org.mozilla.Thunderbird.desktop"
+ * and "XTerm" matches "xterm.desktop"). This is not per any spec
+ * but is needed to find icons for existing applications.
+ *
+ * If there is no such match, partial strings are tried, for
+ * example "gimp-2.0" would match "org.something.gimp.desktop".
+ *
+ * In both cases the first matching entry of the database is returned,
+ * as if all entries were compared one after another.
+ */
+static struct sfdo_desktop_entry *
+get_db_entry_by_id_fuzzy(struct fuzzy_index *index, const char *app_id)
+{
+	char *folded = g_ascii_strdown(app_id, -1);
+	struct sfdo_desktop_entry *entry = NULL;
+
+	/* Would match "org.foobar.xterm" when given app-id "XTerm" */
+	struct fuzzy_match *match = g_hash_table_lookup(index->names, folded);
+	if (match) {
+		entry = index->entries[match->first];
+		wlr_log(WLR_DEBUG, match->first_by_wm_class
+			? "'%s' to '%s.desktop' via StartupWMClass"
+			: "'%s' to '%s.desktop' via case-insensitive match",
+			app_id, sfdo_desktop_entry_get_id(entry, NULL));
+		goto out;
+	}
+
+	/*
+	 * Would match "org.foobar.xterm-unicode" when given app-id "XTerm",
+	 * and "org.foobar.gimp" when given "gimp-2.0". At least 3 characters
+	 * must match, otherwise app-id "foot" would match "something.f" and
+	 * any app-id would match "R.E.P.O."
+	 */
+	size_t len = strlen(folded);
+	if (len < 3) {
+		goto out;
+	}
+	/* Basenames starting with the app-id */
+	size_t first = find_first_with_prefix(index, folded);
+	/* Basenames the app-id starts with */
+	for (size_t i = 3; i < len; i++) {
+		char c = folded[i];
+		folded[i] = '\0';
+		match = g_hash_table_lookup(index->names, folded);
+		folded[i] = c;
+		if (match && match->first_basename != SIZE_MAX) {
+			first = MIN(first, match->first_basename);
+		}
+	}
+	if (first != SIZE_MAX) {
+		entry = index->entries[first];
+		wlr_log(WLR_DEBUG, "'%s' to '%s.desktop' via partial match",
+			app_id, sfdo_desktop_entry_get_id(entry, NULL));
+	}
+out:
+	g_free(folded);
+	return entry;
 }
 
 static struct sfdo_desktop_entry *
 get_desktop_entry(struct sfdo *sfdo, const char *app_id)
 {
+	gpointer memoized;
+	if (g_hash_table_lookup_extended(sfdo->index.app_ids, app_id,
+			NULL, &memoized)) {
+		return memoized;
+	}
+
 	struct sfdo_desktop_entry *entry = sfdo_desktop_db_get_entry_by_id(
 		sfdo->desktop_db, app_id, SFDO_NT);
 	if (entry) {
 		wlr_log(WLR_DEBUG, "matched '%s.desktop' via exact match", app_id);
-		return entry;
+		goto out;
 	}
-	entry = get_db_entry_by_id_fuzzy(sfdo->desktop_db, app_id);
+	entry = get_db_entry_by_id_fuzzy(&sfdo->index, app_id);
 	if (!entry) {
 		wlr_log(WLR_DEBUG, "failed to find .desktop file for '%s'", app_id);
 	}
+out:
+	g_hash_table_insert(sfdo->index.app_ids, g_strdup(app_id), entry);
 	return entry;
 }
 
@@ -347,32 +1012,22 @@ convert_img_type(enum sfdo_icon_file_format fmt)
 	}
 }
 
-struct lab_img *
-desktop_entry_load_icon(const char *icon_name, int size, float scale)
+static struct lab_img *
+load_icon(const char *icon_name, int lookup_size, int lookup_scale)
 {
-	/* static analyzer isn't able to detect the NULL check in string_null_or_empty() */
-	if (string_null_or_empty(icon_name) || !icon_name) {
-		return NULL;
-	}
-
-	struct sfdo *sfdo = server.sfdo;
-	if (!sfdo) {
-		return NULL;
-	}
-
-	/*
-	 * libsfdo doesn't support loading icons for fractional scales,
-	 * so round down and increase the icon size to compensate.
-	 */
-	int lookup_scale = MAX((int)scale, 1);
-	int lookup_size = lroundf(size * scale / lookup_scale);
-
 	struct icon_ctx ctx = {0};
 	int ret;
 	if (icon_name[0] == '/') {
 		ret = process_abs_name(&ctx, icon_name);
 	} else {
-		ret = process_rel_name(&ctx, icon_name, sfdo, lookup_size, lookup_scale);
+		pthread_mutex_lock(&sfdo_lock);
+		if (server.sfdo) {
+			ret = process_rel_name(&ctx, icon_name, server.sfdo,
+				lookup_size, lookup_scale);
+		} else {
+			ret = -1;
+		}
+		pthread_mutex_unlock(&sfdo_lock);
 	}
 	if (ret < 0) {
 		wlr_log(WLR_INFO, "failed to load icon file %s", icon_name);
@@ -386,54 +1041,141 @@ desktop_entry_load_icon(const char *icon_name, int size, float scale)
 	return img;
 }
 
+static struct lab_img *
+load_icon_from_app_id(const char *app_id, int size, float scale)
+{
+	/* The entry may be gone once the lock is released, so copy the name */
+	char *icon_name = NULL;
+	pthread_mutex_lock(&sfdo_lock);
+	if (server.sfdo) {
+		struct sfdo_desktop_entry *entry =
+			get_desktop_entry(server.sfdo, app_id);
+		if (entry) {
+			const char *name = sfdo_desktop_entry_get_icon(entry, NULL);
+			icon_name = name ? xstrdup(name) : NULL;
+		}
+	}
+	pthread_mutex_unlock(&sfdo_lock);
+
+	struct lab_img *img = desktop_entry_load_icon(icon_name, size, scale);
+	free(icon_name);
+	if (!img) {
+		/* Icon not defined in .desktop file or could not be loaded */
+		img = desktop_entry_load_icon(app_id, size, scale);
+	}
+	return img;
+}
+
+/*
+ * libsfdo doesn't support loading icons for fractional scales,
+ * so round down and increase the icon size to compensate.
+ */
+static void
+get_lookup_size(int size, float scale, int *lookup_size, int *lookup_scale)
+{
+	*lookup_scale = MAX((int)scale, 1);
+	*lookup_size = lroundf(size * scale / *lookup_scale);
+}
+
+static bool
+have_icon_theme(void)
+{
+	pthread_mutex_lock(&sfdo_lock);
+	bool ret = server.sfdo;
+	pthread_mutex_unlock(&sfdo_lock);
+	return ret;
+}
+
 struct lab_img *
-desktop_entry_load_icon_from_app_id(const char *app_id, int size, float scale)
+desktop_entry_load_icon(const char *icon_name, int size, float scale)
 {
-	if (string_null_or_empty(app_id)) {
+	/* static analyzer isn't able to detect the NULL check in string_null_or_empty() */
+	if (string_null_or_empty(icon_name) || !icon_name) {
 		return NULL;
 	}
-
-	struct sfdo *sfdo = server.sfdo;
-	if (!sfdo) {
+	/* Don't cache negative results while there is no icon theme */
+	if (!have_icon_theme()) {
 		return NULL;
 	}
 
-	const char *icon_name = NULL;
-	struct sfdo_desktop_entry *entry = get_desktop_entry(sfdo, app_id);
-	if (entry) {
-		icon_name = sfdo_desktop_entry_get_icon(entry, NULL);
-	}
+	int lookup_size, lookup_scale;
+	get_lookup_size(size, scale, &lookup_size, &lookup_scale);
 
-	struct lab_img *img = desktop_entry_load_icon(icon_name, size, scale);
-	if (!img) {
-		/* Icon not defined in .desktop file or could not be loaded */
-		img = desktop_entry_load_icon(app_id, size, scale);
+	struct lab_img *img = NULL;
+	unsigned int generation;
+	char *key = strdup_printf("i:%d:%d:%s", lookup_size, lookup_scale,
+		icon_name);
+	if (icon_cache_lookup(key, &img, &generation)) {
+		free(key);
+		return img;
 	}
+
+	img = load_icon(icon_name, lookup_size, lookup_scale);
+	icon_cache_insert(key, img, generation);
 	return img;
 }
 
-const char *
-desktop_entry_name_lookup(const char *app_id)
+struct lab_img *
+desktop_entry_load_icon_from_app_id(const char *app_id, int size, float scale)
 {
 	if (string_null_or_empty(app_id)) {
 		return NULL;
 	}
-
-	struct sfdo *sfdo = server.sfdo;
-	if (!sfdo) {
+	if (!have_icon_theme()) {
 		return NULL;
 	}
 
-	struct sfdo_desktop_entry *entry = get_desktop_entry(sfdo, app_id);
-	if (!entry) {
-		return NULL;
+	int lookup_size, lookup_scale;
+	get_lookup_size(size, scale, &lookup_size, &lookup_scale);
+
+	struct lab_img *img = NULL;
+	unsigned int generation;
+	char *key = strdup_printf("a:%d:%d:%s", lookup_size, lookup_scale,
+		app_id);
+	if (icon_cache_lookup(key, &img, &generation)) {
+		free(key);
+		return img;
 	}
 
-	size_t len;
-	const char *name = sfdo_desktop_entry_get_name(entry, &len);
-	if (!len) {
+	img = load_icon_from_app_id(app_id, size, scale);
+	icon_cache_insert(key, img, generation);
+	return img;
+}
+
+void
+desktop_entry_print_stats(void)
+{
+	pthread_mutex_lock(&icon_cache.lock);
+	printf("icon cache: %u entries, %u hits, %u misses\n",
+		icon_cache.entries ? g_hash_table_size(icon_cache.entries) : 0,
+		icon_cache.hits, icon_cache.misses);
+	pthread_mutex_unlock(&icon_cache.lock);
+}
+
+const char *
+desktop_entry_name_lookup(const char *app_id)
+{
+	if (string_null_or_empty(app_id)) {
 		return NULL;
 	}
 
+	/*
+	 * This is only called from the main thread, which is also the only
+	 * one to destroy the database, so the name stays valid after the
+	 * lock has been released.
+	 */
+	const char *name = NULL;
+	pthread_mutex_lock(&sfdo_lock);
+	struct sfdo_desktop_entry *entry =
+		server.sfdo ? get_desktop_entry(server.sfdo, app_id) : NULL;
+	if (entry) {
+		size_t len;
+		name = sfdo_desktop_entry_get_name(entry, &len);
+		if (!len) {
+			name = NULL;
+		}
+	}
+	pthread_mutex_unlock(&sfdo_lock);
+
 	return name;
 }
@@ -3,6 +3,9 @@
 #include <assert.h>
 #include <wlr/types/wlr_ext_foreign_toplevel_list_v1.h>
 #include "common/macros.h"
+#include "common/mem.h"
+#include "common/string-helpers.h"
+#include "foreign-toplevel/foreign.h"
 #include "labwc.h"
 #include "view.h"
 
@@ -20,23 +23,62 @@ handle_handle_destroy(struct wl_listener *listener, void *data)
 	wl_list_remove(&ext_toplevel->on_view.new_app_id.link);
 	wl_list_remove(&ext_toplevel->on_view.new_title.link);
 
+	if (ext_toplevel->flush_idle) {
+		wl_event_source_remove(ext_toplevel->flush_idle);
+		ext_toplevel->flush_idle = NULL;
+	}
+	zfree(ext_toplevel->sent.title);
+	zfree(ext_toplevel->sent.app_id);
+
 	ext_toplevel->handle = NULL;
 }
 
+/*
+ * Title and app_id are always sent together, followed by a done event,
+ * so they are only sent if either differs from what clients have.
+ */
+static void
+handle_flush_idle(void *data)
+{
+	struct ext_foreign_toplevel *ext_toplevel = data;
+	struct view *view = ext_toplevel->view;
+	ext_toplevel->flush_idle = NULL;
+
+	int nr_sent = 0;
+	if (!str_equal(ext_toplevel->sent.title, view->title)
+			|| !str_equal(ext_toplevel->sent.app_id, view->app_id)) {
+		struct wlr_ext_foreign_toplevel_handle_v1_state state = {
+			.title = view->title,
+			.app_id = view->app_id,
+		};
+		wlr_ext_foreign_toplevel_handle_v1_update_state(
+			ext_toplevel->handle, &state);
+		xstrdup_replace(ext_toplevel->sent.title, view->title);
+		xstrdup_replace(ext_toplevel->sent.app_id, view->app_id);
+		nr_sent = 1;
+	}
+	foreign_toplevel_count_updates(ext_toplevel->nr_updates, nr_sent);
+	ext_toplevel->nr_updates = 0;
+}
+
+static void
+mark_dirty(struct ext_foreign_toplevel *ext_toplevel)
+{
+	assert(ext_toplevel->handle);
+	ext_toplevel->nr_updates++;
+	if (!ext_toplevel->flush_idle) {
+		ext_toplevel->flush_idle = wl_event_loop_add_idle(
+			server.wl_event_loop, handle_flush_idle, ext_toplevel);
+	}
+}
+
 /* Compositor signals */
 static void
 handle_new_app_id(struct wl_listener *listener, void *data)
 {
 	struct ext_foreign_toplevel *ext_toplevel =
 		wl_container_of(listener, ext_toplevel, on_view.new_app_id);
-	assert(ext_toplevel->handle);
-
-	struct wlr_ext_foreign_toplevel_handle_v1_state state = {
-		.title = ext_toplevel->view->title,
-		.app_id = ext_toplevel->view->app_id,
-	};
-	wlr_ext_foreign_toplevel_handle_v1_update_state(ext_toplevel->handle,
-		&state);
+	mark_dirty(ext_toplevel);
 }
 
 static void
@@ -44,14 +86,7 @@ handle_new_title(struct wl_listener *listener, void *data)
 {
 	struct ext_foreign_toplevel *ext_toplevel =
 		wl_container_of(listener, ext_toplevel, on_view.new_title);
-	assert(ext_toplevel->handle);
-
-	struct wlr_ext_foreign_toplevel_handle_v1_state state = {
-		.title = ext_toplevel->view->title,
-		.app_id = ext_toplevel->view->app_id,
-	};
-	wlr_ext_foreign_toplevel_handle_v1_update_state(ext_toplevel->handle,
-		&state);
+	mark_dirty(ext_toplevel);
 }
 
 /* Internal API */
@@ -77,6 +112,8 @@ ext_foreign_toplevel_init(struct ext_foreign_toplevel *ext_toplevel,
 
 	/* In support for ext-toplevel-capture */
 	ext_toplevel->handle->data = view;
+	ext_toplevel->sent.title = xstrdup(view->title);
+	ext_toplevel->sent.app_id = xstrdup(view->app_id);
 
 	/* Client side requests */
 	ext_toplevel->on.handle_destroy.notify = handle_handle_destroy;
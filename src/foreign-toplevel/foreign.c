@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-only
 #include "foreign-toplevel/foreign.h"
 #include <assert.h>
+#include <wlr/util/log.h>
 #include "common/mem.h"
 #include "foreign-toplevel/ext-foreign.h"
 #include "foreign-toplevel/wlr-foreign.h"
@@ -14,6 +15,15 @@ struct foreign_toplevel {
 	/* TODO: add struct xdg_x11_mapped_toplevel at some point */
 };
 
+/* Log the totals whenever this many more updates have been counted */
+#define STATS_LOG_INTERVAL 1000
+
+static struct {
+	unsigned long nr_updates;
+	unsigned long nr_sent;
+	unsigned long next_log;
+} stats;
+
 struct foreign_toplevel *
 foreign_toplevel_create(struct view *view)
 {
@@ -42,3 +52,16 @@ foreign_toplevel_destroy(struct foreign_toplevel *toplevel)
 	ext_foreign_toplevel_finish(&toplevel->ext_toplevel);
 	free(toplevel);
 }
+
+void
+foreign_toplevel_count_updates(int nr_updates, int nr_sent)
+{
+	stats.nr_updates += nr_updates;
+	stats.nr_sent += nr_sent;
+	if (stats.nr_updates >= stats.next_log) {
+		wlr_log(WLR_DEBUG, "foreign-toplevel: sent %lu of %lu updates "
+			"(%lu coalesced or unchanged)", stats.nr_sent,
+			stats.nr_updates, stats.nr_updates - stats.nr_sent);
+		stats.next_log = stats.nr_updates + STATS_LOG_INTERVAL;
+	}
+}
@@ -3,6 +3,9 @@
 #include <assert.h>
 #include <wlr/types/wlr_foreign_toplevel_management_v1.h>
 #include "common/macros.h"
+#include "common/mem.h"
+#include "common/string-helpers.h"
+#include "foreign-toplevel/foreign.h"
 #include "labwc.h"
 #include "output.h"
 #include "view.h"
@@ -82,19 +85,125 @@ handle_handle_destroy(struct wl_listener *listener, void *data)
 	wl_list_remove(&wlr_toplevel->on_view.fullscreened.link);
 	wl_list_remove(&wlr_toplevel->on_view.activated.link);
 
+	if (wlr_toplevel->flush_idle) {
+		wl_event_source_remove(wlr_toplevel->flush_idle);
+		wlr_toplevel->flush_idle = NULL;
+	}
+	zfree(wlr_toplevel->sent.title);
+	zfree(wlr_toplevel->sent.app_id);
+
 	wlr_toplevel->handle = NULL;
 }
 
+/*
+ * Send the accumulated changes, skipping values that clients already
+ * have. wlroots follows up with a single done event per handle.
+ * Returns the number of changes sent.
+ */
+static int
+flush(struct wlr_foreign_toplevel *wlr_toplevel)
+{
+	struct view *view = wlr_toplevel->view;
+	struct wlr_foreign_toplevel_handle_v1 *handle = wlr_toplevel->handle;
+	uint32_t dirty = wlr_toplevel->dirty;
+	int nr_sent = 0;
+
+	if ((dirty & FOREIGN_DIRTY_APP_ID)
+			&& !str_equal(wlr_toplevel->sent.app_id, view->app_id)) {
+		wlr_foreign_toplevel_handle_v1_set_app_id(handle, view->app_id);
+		xstrdup_replace(wlr_toplevel->sent.app_id, view->app_id);
+		nr_sent++;
+	}
+	if ((dirty & FOREIGN_DIRTY_TITLE)
+			&& !str_equal(wlr_toplevel->sent.title, view->title)) {
+		wlr_foreign_toplevel_handle_v1_set_title(handle, view->title);
+		xstrdup_replace(wlr_toplevel->sent.title, view->title);
+		nr_sent++;
+	}
+	if (dirty & FOREIGN_DIRTY_OUTPUTS) {
+		/*
+		 * Loop over all outputs and notify foreign_toplevel clients
+		 * about changes. wlr_foreign_toplevel_handle_v1_output_xxx()
+		 * keeps track of the active outputs internally and merges the
+		 * events. It also listens to output destroy events so its fine
+		 * to just relay the current state and let wlr_foreign_toplevel
+		 * handle the rest.
+		 */
+		struct output *output;
+		wl_list_for_each(output, &server.outputs, link) {
+			if (view_on_output(view, output)) {
+				wlr_foreign_toplevel_handle_v1_output_enter(
+					handle, output->wlr_output);
+			} else {
+				wlr_foreign_toplevel_handle_v1_output_leave(
+					handle, output->wlr_output);
+			}
+		}
+		nr_sent++;
+	}
+
+	bool maximized = view->maximized == VIEW_AXIS_BOTH;
+	if ((dirty & FOREIGN_DIRTY_MAXIMIZED)
+			&& maximized != wlr_toplevel->sent.maximized) {
+		wlr_foreign_toplevel_handle_v1_set_maximized(handle, maximized);
+		wlr_toplevel->sent.maximized = maximized;
+		nr_sent++;
+	}
+	if ((dirty & FOREIGN_DIRTY_MINIMIZED)
+			&& view->minimized != wlr_toplevel->sent.minimized) {
+		wlr_foreign_toplevel_handle_v1_set_minimized(handle,
+			view->minimized);
+		wlr_toplevel->sent.minimized = view->minimized;
+		nr_sent++;
+	}
+	if ((dirty & FOREIGN_DIRTY_FULLSCREEN)
+			&& view->fullscreen != wlr_toplevel->sent.fullscreen) {
+		wlr_foreign_toplevel_handle_v1_set_fullscreen(handle,
+			view->fullscreen);
+		wlr_toplevel->sent.fullscreen = view->fullscreen;
+		nr_sent++;
+	}
+	if ((dirty & FOREIGN_DIRTY_ACTIVATED)
+			&& wlr_toplevel->activated != wlr_toplevel->sent.activated) {
+		wlr_foreign_toplevel_handle_v1_set_activated(handle,
+			wlr_toplevel->activated);
+		wlr_toplevel->sent.activated = wlr_toplevel->activated;
+		nr_sent++;
+	}
+
+	wlr_toplevel->dirty = 0;
+	return nr_sent;
+}
+
+static void
+handle_flush_idle(void *data)
+{
+	struct wlr_foreign_toplevel *wlr_toplevel = data;
+	wlr_toplevel->flush_idle = NULL;
+	int nr_sent = flush(wlr_toplevel);
+	foreign_toplevel_count_updates(wlr_toplevel->nr_updates, nr_sent);
+	wlr_toplevel->nr_updates = 0;
+}
+
+static void
+mark_dirty(struct wlr_foreign_toplevel *wlr_toplevel, uint32_t dirty)
+{
+	assert(wlr_toplevel->handle);
+	wlr_toplevel->dirty |= dirty;
+	wlr_toplevel->nr_updates++;
+	if (!wlr_toplevel->flush_idle) {
+		wlr_toplevel->flush_idle = wl_event_loop_add_idle(
+			server.wl_event_loop, handle_flush_idle, wlr_toplevel);
+	}
+}
+
 /* Compositor signals */
 static void
 handle_new_app_id(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.new_app_id);
-	assert(wlr_toplevel->handle);
-
-	wlr_foreign_toplevel_handle_v1_set_app_id(wlr_toplevel->handle,
-		wlr_toplevel->view->app_id);
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_APP_ID);
 }
 
 static void
@@ -102,10 +211,7 @@ handle_new_title(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.new_title);
-	assert(wlr_toplevel->handle);
-
-	wlr_foreign_toplevel_handle_v1_set_title(wlr_toplevel->handle,
-		wlr_toplevel->view->title);
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_TITLE);
 }
 
 static void
@@ -113,25 +219,7 @@ handle_new_outputs(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.new_outputs);
-	assert(wlr_toplevel->handle);
-
-	/*
-	 * Loop over all outputs and notify foreign_toplevel clients about changes.
-	 * wlr_foreign_toplevel_handle_v1_output_xxx() keeps track of the active
-	 * outputs internally and merges the events. It also listens to output
-	 * destroy events so its fine to just relay the current state and let
-	 * wlr_foreign_toplevel handle the rest.
-	 */
-	struct output *output;
-	wl_list_for_each(output, &server.outputs, link) {
-		if (view_on_output(wlr_toplevel->view, output)) {
-			wlr_foreign_toplevel_handle_v1_output_enter(
-				wlr_toplevel->handle, output->wlr_output);
-		} else {
-			wlr_foreign_toplevel_handle_v1_output_leave(
-				wlr_toplevel->handle, output->wlr_output);
-		}
-	}
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_OUTPUTS);
 }
 
 static void
@@ -139,10 +227,7 @@ handle_maximized(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.maximized);
-	assert(wlr_toplevel->handle);
-
-	wlr_foreign_toplevel_handle_v1_set_maximized(wlr_toplevel->handle,
-		wlr_toplevel->view->maximized == VIEW_AXIS_BOTH);
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_MAXIMIZED);
 }
 
 static void
@@ -150,10 +235,7 @@ handle_minimized(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.minimized);
-	assert(wlr_toplevel->handle);
-
-	wlr_foreign_toplevel_handle_v1_set_minimized(wlr_toplevel->handle,
-		wlr_toplevel->view->minimized);
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_MINIMIZED);
 }
 
 static void
@@ -161,10 +243,7 @@ handle_fullscreened(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.fullscreened);
-	assert(wlr_toplevel->handle);
-
-	wlr_foreign_toplevel_handle_v1_set_fullscreen(wlr_toplevel->handle,
-		wlr_toplevel->view->fullscreen);
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_FULLSCREEN);
 }
 
 static void
@@ -172,11 +251,10 @@ handle_activated(struct wl_listener *listener, void *data)
 {
 	struct wlr_foreign_toplevel *wlr_toplevel =
 		wl_container_of(listener, wlr_toplevel, on_view.activated);
-	assert(wlr_toplevel->handle);
 
 	bool *activated = data;
-	wlr_foreign_toplevel_handle_v1_set_activated(wlr_toplevel->handle,
-		*activated);
+	wlr_toplevel->activated = *activated;
+	mark_dirty(wlr_toplevel, FOREIGN_DIRTY_ACTIVATED);
 }
 
 /* Internal API */
@@ -195,15 +273,13 @@ wlr_foreign_toplevel_init(struct wlr_foreign_toplevel *wlr_toplevel,
 		return;
 	}
 
-	/* These states may be set before the initial map */
-	handle_new_app_id(&wlr_toplevel->on_view.new_app_id, NULL);
-	handle_new_title(&wlr_toplevel->on_view.new_title, NULL);
-	handle_new_outputs(&wlr_toplevel->on_view.new_outputs, NULL);
-	handle_maximized(&wlr_toplevel->on_view.maximized, NULL);
-	handle_minimized(&wlr_toplevel->on_view.minimized, NULL);
-	handle_fullscreened(&wlr_toplevel->on_view.fullscreened, NULL);
-	handle_activated(&wlr_toplevel->on_view.activated,
-		&(bool){view == server.active_view});
+	/*
+	 * These states may be set before the initial map. The handle
+	 * starts out with all of them unset, so send them right away.
+	 */
+	wlr_toplevel->activated = view == server.active_view;
+	wlr_toplevel->dirty = FOREIGN_DIRTY_ALL;
+	flush(wlr_toplevel);
 
 	/* Client side requests */
 	CONNECT_SIGNAL(wlr_toplevel->handle, &wlr_toplevel->on, request_maximize);
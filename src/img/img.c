@@ -2,6 +2,9 @@
 
 #include "img/img.h"
 #include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
 #include "buffer.h"
 #include "config.h"
 #include "common/box.h"
@@ -18,24 +21,77 @@
 #include "labwc.h"
 #include "theme.h"
 
+#define IMG_RESIZED_CACHE_SIZE 4
+
 struct lab_img_data {
 	enum lab_img_type type;
-	/* lab_img_data is refcounted to be shared by multiple lab_imgs */
-	int refcount;
+	/*
+	 * lab_img_data is refcounted to be shared by multiple lab_imgs,
+	 * possibly across threads (see desktop-entry.c icon cache)
+	 */
+	atomic_int refcount;
 
 	/* Handler for the loaded image file */
 	struct lab_data_buffer *buffer; /* for PNG/XBM/XPM image */
 #if HAVE_RSVG
 	RsvgHandle *svg; /* for SVG image */
 #endif
+
+	/*
+	 * Recently resized copies of @buffer. The same image is often
+	 * rendered at one size several times, e.g. for each button state
+	 * or for icons shown in several places. They are shared with the
+	 * buffers returned by lab_img_render() via buffer_create_shared().
+	 */
+	pthread_mutex_t resized_lock;
+	struct resized_buffer {
+		int width;
+		int height;
+		double scale;
+		struct lab_data_buffer *buffer;
+	} resized[IMG_RESIZED_CACHE_SIZE];
+	int next_resized;
 };
 
+#if HAVE_RSVG
+static pthread_mutex_t svg_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static struct lab_img_data *
+create_img_data(enum lab_img_type type)
+{
+	struct lab_img_data *img_data = znew(*img_data);
+	img_data->type = type;
+	pthread_mutex_init(&img_data->resized_lock, NULL);
+	return img_data;
+}
+
+static void
+destroy_img_data(struct lab_img_data *img_data)
+{
+	if (img_data->buffer) {
+		wlr_buffer_drop(&img_data->buffer->base);
+	}
+#if HAVE_RSVG
+	if (img_data->svg) {
+		g_object_unref(img_data->svg);
+	}
+#endif
+	for (int i = 0; i < IMG_RESIZED_CACHE_SIZE; i++) {
+		if (img_data->resized[i].buffer) {
+			buffer_release_shared(img_data->resized[i].buffer);
+		}
+	}
+	pthread_mutex_destroy(&img_data->resized_lock);
+	free(img_data);
+}
+
 static struct lab_img *
 create_img(struct lab_img_data *img_data)
 {
 	struct lab_img *img = znew(*img);
 	img->data = img_data;
-	img_data->refcount++;
+	atomic_fetch_add(&img_data->refcount, 1);
 	wl_array_init(&img->modifiers);
 	return img;
 }
@@ -47,8 +103,7 @@ lab_img_load(enum lab_img_type type, const char *path, float *xbm_color)
 		return NULL;
 	}
 
-	struct lab_img_data *img_data = znew(*img_data);
-	img_data->type = type;
+	struct lab_img_data *img_data = create_img_data(type);
 
 	switch (type) {
 	case LAB_IMG_PNG:
@@ -76,7 +131,7 @@ lab_img_load(enum lab_img_type type, const char *path, float *xbm_color)
 	if (img_is_loaded) {
 		return create_img(img_data);
 	} else {
-		free(img_data);
+		destroy_img_data(img_data);
 		return NULL;
 	}
 }
@@ -89,8 +144,7 @@ lab_img_load_from_bitmap(const char *bitmap, float *rgba)
 		return NULL;
 	}
 
-	struct lab_img_data *img_data = znew(*img_data);
-	img_data->type = LAB_IMG_XBM;
+	struct lab_img_data *img_data = create_img_data(LAB_IMG_XBM);
 	img_data->buffer = buffer;
 
 	return create_img(img_data);
@@ -111,6 +165,85 @@ lab_img_add_modifier(struct lab_img *img, lab_img_modifier_func_t modifier)
 	*mod = modifier;
 }
 
+/* Copy a buffer from buffer_create_cairo() with the same arguments */
+static struct lab_data_buffer *
+copy_resized(struct lab_data_buffer *src, int width, int height, double scale)
+{
+	struct lab_data_buffer *buffer =
+		buffer_create_cairo(width, height, scale);
+	if (buffer) {
+		assert(buffer->stride == src->stride
+			&& buffer->base.height == src->base.height);
+		memcpy(buffer->data, src->data,
+			src->stride * src->base.height);
+		cairo_surface_mark_dirty(buffer->surface);
+	}
+	return buffer;
+}
+
+/*
+ * Resize the image buffer, or reuse a previous result for the same size.
+ *
+ * Cached buffers are never drawn to. Unless @writable is set, the returned
+ * buffer shares the pixel data of the cached one; otherwise it is a copy
+ * which may be drawn to, e.g. by modifiers.
+ */
+static struct lab_data_buffer *
+resize_buffer(struct lab_img_data *img_data, int width, int height,
+		double scale, bool writable)
+{
+	struct lab_data_buffer *buffer = NULL;
+
+	pthread_mutex_lock(&img_data->resized_lock);
+	for (int i = 0; i < IMG_RESIZED_CACHE_SIZE; i++) {
+		struct resized_buffer *resized = &img_data->resized[i];
+		if (resized->buffer && resized->width == width
+				&& resized->height == height
+				&& resized->scale == scale) {
+			buffer = writable
+				? copy_resized(resized->buffer, width, height,
+					scale)
+				: buffer_create_shared(resized->buffer);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&img_data->resized_lock);
+	if (buffer) {
+		return buffer;
+	}
+
+	/* Resize without holding the lock, it is the expensive part */
+	struct lab_data_buffer *cached =
+		buffer_resize(img_data->buffer, width, height, scale);
+	if (!cached) {
+		return NULL;
+	}
+	buffer = writable ? copy_resized(cached, width, height, scale)
+		: buffer_create_shared(cached);
+	if (!buffer) {
+		buffer_release_shared(cached);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&img_data->resized_lock);
+	struct resized_buffer *resized =
+		&img_data->resized[img_data->next_resized];
+	img_data->next_resized =
+		(img_data->next_resized + 1) % IMG_RESIZED_CACHE_SIZE;
+	if (resized->buffer) {
+		buffer_release_shared(resized->buffer);
+	}
+	*resized = (struct resized_buffer){
+		.width = width,
+		.height = height,
+		.scale = scale,
+		.buffer = cached,
+	};
+	pthread_mutex_unlock(&img_data->resized_lock);
+
+	return buffer;
+}
+
 struct lab_data_buffer *
 lab_img_render(struct lab_img *img, int width, int height, double scale)
 {
@@ -121,11 +254,15 @@ lab_img_render(struct lab_img *img, int width, int height, double scale)
 	case LAB_IMG_PNG:
 	case LAB_IMG_XBM:
 	case LAB_IMG_XPM:
-		buffer = buffer_resize(img->data->buffer, width, height, scale);
+		buffer = resize_buffer(img->data, width, height, scale,
+			/* writable */ img->modifiers.size > 0);
 		break;
 #if HAVE_RSVG
 	case LAB_IMG_SVG:
+		/* RsvgHandle must not be used by several threads at once */
+		pthread_mutex_lock(&svg_lock);
 		buffer = img_svg_render(img->data->svg, width, height, scale);
+		pthread_mutex_unlock(&svg_lock);
 		break;
 #endif
 	default:
@@ -158,17 +295,8 @@ lab_img_destroy(struct lab_img *img)
 		return;
 	}
 
-	img->data->refcount--;
-	if (img->data->refcount == 0) {
-		if (img->data->buffer) {
-			wlr_buffer_drop(&img->data->buffer->base);
-		}
-#if HAVE_RSVG
-		if (img->data->svg) {
-			g_object_unref(img->data->svg);
-		}
-#endif
-		free(img->data);
+	if (atomic_fetch_sub(&img->data->refcount, 1) == 1) {
+		destroy_img_data(img->data);
 	}
 
 	wl_array_release(&img->modifiers);
@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Decode xbm images
+ *
+ * Copyright Johan Malm 2020-2023
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "img/xbm-decode.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/mem.h"
+
+/* Openbox themes use tiny bitmaps, this only guards against garbage */
+#define XBM_MAX_SIZE 1024
+
+#define MAX_TOKEN_SIZE (256)
+
+enum token_type {
+	TOKEN_NONE = 0,
+	TOKEN_IDENT,
+	TOKEN_INT,
+	TOKEN_SPECIAL,
+};
+
+struct token {
+	enum token_type type;
+	/* NUL-terminated copy, truncated to MAX_TOKEN_SIZE - 1 chars */
+	char name[MAX_TOKEN_SIZE];
+};
+
+struct lexer {
+	const char *pos;
+	const char *end;
+};
+
+static bool
+is_ident_char(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+		|| (c >= '0' && c <= '9') || c == '_' || c == '#';
+}
+
+static bool
+is_number_char(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f')
+		|| (c >= 'A' && c <= 'F') || c == 'x';
+}
+
+static void
+read_token(struct lexer *lexer, struct token *token, bool (*accept)(char))
+{
+	size_t len = 0;
+	do {
+		if (len < MAX_TOKEN_SIZE - 1) {
+			token->name[len++] = *lexer->pos;
+		}
+		lexer->pos++;
+	} while (lexer->pos < lexer->end && accept(*lexer->pos));
+	token->name[len] = '\0';
+}
+
+/* Return the next token; anything but identifiers, numbers and '{' is skipped */
+static void
+next_token(struct lexer *lexer, struct token *token)
+{
+	for (; lexer->pos < lexer->end; lexer->pos++) {
+		char c = *lexer->pos;
+		if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+				|| c == '_' || c == '#') {
+			token->type = TOKEN_IDENT;
+			read_token(lexer, token, is_ident_char);
+			return;
+		}
+		if (c >= '0' && c <= '9') {
+			token->type = TOKEN_INT;
+			read_token(lexer, token, is_number_char);
+			return;
+		}
+		if (c == '{') {
+			token->type = TOKEN_SPECIAL;
+			token->name[0] = c;
+			token->name[1] = '\0';
+			lexer->pos++;
+			return;
+		}
+	}
+	token->type = TOKEN_NONE;
+	token->name[0] = '\0';
+}
+
+/*
+ * Decode bytes, starting with @token, straight into the pixels. Each row
+ * is padded to a whole number of bytes with the least significant bit
+ * first. Data ending prematurely leaves the remaining pixels transparent.
+ */
+static void
+read_bits(struct lexer *lexer, struct token *token, uint32_t *pixels,
+		int width, int height, uint32_t color)
+{
+	for (int row = 0; row < height; row++) {
+		uint32_t *dst = pixels + (size_t)row * width;
+		for (int col = 0; col < width; col += 8) {
+			if (token->type != TOKEN_INT) {
+				return;
+			}
+			int byte = (int)strtol(token->name, NULL, 0);
+			for (int bit = 0; bit < 8 && col + bit < width; bit++) {
+				if (byte & (1 << bit)) {
+					dst[col + bit] = color;
+				}
+			}
+			next_token(lexer, token);
+		}
+	}
+}
+
+uint32_t *
+xbm_decode(const char *data, size_t len, uint32_t color, int *width,
+		int *height)
+{
+	struct lexer lexer = { .pos = data, .end = data + len };
+	struct token token;
+	int w = 0, h = 0;
+
+	/*
+	 * The "#define <name>_width" and "_height" values are followed by the
+	 * byte array, which starts with the first number after both of them.
+	 */
+	for (next_token(&lexer, &token); token.type; next_token(&lexer, &token)) {
+		if (w && h) {
+			if (token.type == TOKEN_INT) {
+				break;
+			}
+			continue;
+		}
+		int *value = NULL;
+		if (strstr(token.name, "width")) {
+			value = &w;
+		} else if (strstr(token.name, "height")) {
+			value = &h;
+		}
+		if (value) {
+			next_token(&lexer, &token);
+			*value = atoi(token.name);
+		}
+	}
+	if (token.type != TOKEN_INT || w <= 0 || h <= 0
+			|| w > XBM_MAX_SIZE || h > XBM_MAX_SIZE) {
+		return NULL;
+	}
+
+	uint32_t *pixels = znew_n(*pixels, (size_t)w * h);
+	read_bits(&lexer, &token, pixels, w, h, color);
+	*width = w;
+	*height = h;
+	return pixels;
+}
@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: LGPL-2.0-or-later
+/*
+ * XPM image decoder adapted from gdk-pixbuf
+ *
+ * Copyright (C) 1999 Mark Crichton
+ * Copyright (C) 1999 The Free Software Foundation
+ *
+ * Authors: Mark Crichton <crichton@gimp.org>
+ *          Federico Mena-Quintero <federico@gimp.org>
+ *
+ * Adapted for labwc by John Lindgren, 2024
+ */
+
+#include "img/xpm-decode.h"
+#include <glib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/util/log.h>
+#include "common/graphic-helpers.h"
+#include "common/hash.h"
+#include "common/macros.h"
+#include "common/mem.h"
+
+/* Limits (width, height, colors) modified for labwc */
+#define XPM_MAX_SIZE 1024
+#define XPM_MAX_COLORS 1024
+#define XPM_MAX_CPP 31
+
+/* Longest header or color definition that is looked at */
+#define XPM_MAX_LINE 256
+
+struct parser {
+	const char *pos;
+	const char *end;
+};
+
+/* Open-addressing hash table from pixel chars to colors */
+struct color_table {
+	struct color_entry {
+		const char *chars; /* NULL if unused */
+		uint32_t argb;
+	} *entries;
+	size_t mask;
+	int cpp;
+};
+
+static inline uint32_t
+make_argb(uint8_t a, uint8_t r, uint8_t g, uint8_t b)
+{
+	return ((uint32_t)a << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+static bool
+parse_color(const char *spec, uint32_t *argb)
+{
+	if (spec[0] != '#') {
+		return lookup_named_color(spec, argb);
+	}
+
+	int red, green, blue;
+	switch (strlen(spec + 1)) {
+	case 3:
+		if (sscanf(spec + 1, "%1x%1x%1x", &red, &green, &blue) != 3) {
+			return false;
+		}
+		*argb = make_argb(255, (red * 255) / 15, (green * 255) / 15,
+			(blue * 255) / 15);
+		return true;
+	case 6:
+		if (sscanf(spec + 1, "%2x%2x%2x", &red, &green, &blue) != 3) {
+			return false;
+		}
+		*argb = make_argb(255, red, green, blue);
+		return true;
+	case 9:
+		if (sscanf(spec + 1, "%3x%3x%3x", &red, &green, &blue) != 3) {
+			return false;
+		}
+		*argb = make_argb(255, (red * 255) / 4095, (green * 255) / 4095,
+			(blue * 255) / 4095);
+		return true;
+	case 12:
+		if (sscanf(spec + 1, "%4x%4x%4x", &red, &green, &blue) != 3) {
+			return false;
+		}
+		*argb = make_argb(255, (red * 255) / 65535,
+			(green * 255) / 65535, (blue * 255) / 65535);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static uint32_t
+xpm_extract_color(const char *buffer)
+{
+	const char *p = buffer;
+	int new_key = 0;
+	int key = 0;
+	int current_key = 1;
+	char word[129], color[129], current_color[129];
+	char *r;
+
+	word[0] = '\0';
+	color[0] = '\0';
+	current_color[0] = '\0';
+	while (true) {
+		/* skip whitespace */
+		for (; *p != '\0' && g_ascii_isspace(*p); p++) {
+			/* nothing */
+		}
+		/* copy word */
+		for (r = word; *p != '\0' && !g_ascii_isspace(*p)
+				&& r - word < (int)sizeof(word) - 1;
+				p++, r++) {
+			*r = *p;
+		}
+		*r = '\0';
+		if (*word == '\0') {
+			if (color[0] == '\0') { /* incomplete colormap entry */
+				return 0;
+			} else { /* end of entry, still store the last color */
+				new_key = 1;
+			}
+		} else if (key > 0 && color[0] == '\0') {
+			/* next word must be a color name part */
+			new_key = 0;
+		} else {
+			if (strcmp(word, "c") == 0) {
+				new_key = 5;
+			} else if (strcmp(word, "g") == 0) {
+				new_key = 4;
+			} else if (strcmp(word, "g4") == 0) {
+				new_key = 3;
+			} else if (strcmp(word, "m") == 0) {
+				new_key = 2;
+			} else if (strcmp(word, "s") == 0) {
+				new_key = 1;
+			} else {
+				new_key = 0;
+			}
+		}
+		if (new_key == 0) {	/* word is a color name part */
+			if (key == 0) { /* key expected */
+				return 0;
+			}
+			/* accumulate color name */
+			int len = strlen(color);
+			if (len && len < (int)sizeof(color) - 1) {
+				color[len++] = ' ';
+			}
+			g_strlcpy(color + len, word, sizeof(color) - len);
+		} else { /* word is a key */
+			if (key > current_key) {
+				current_key = key;
+				g_strlcpy(current_color, color, sizeof(current_color));
+			}
+			color[0] = '\0';
+			key = new_key;
+			if (*p == '\0') {
+				break;
+			}
+		}
+	}
+
+	uint32_t argb;
+	if (current_key > 1 && (g_ascii_strcasecmp(current_color, "None") != 0)
+			&& parse_color(current_color, &argb)) {
+		return argb;
+	} else {
+		return 0;
+	}
+}
+
+static bool
+is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r'
+		|| c == '\f' || c == '\v';
+}
+
+/* Find the whitespace-separated word "XPM", as in the magic comment */
+static bool
+seek_magic(struct parser *p)
+{
+	while (p->pos < p->end) {
+		while (p->pos < p->end && is_space(*p->pos)) {
+			p->pos++;
+		}
+		const char *word = p->pos;
+		while (p->pos < p->end && !is_space(*p->pos)) {
+			p->pos++;
+		}
+		if (p->pos - word == 3 && !memcmp(word, "XPM", 3)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Advance past the next @c outside of C comments */
+static bool
+seek_char(struct parser *p, char c)
+{
+	while (p->pos < p->end) {
+		char b = *p->pos++;
+		if (b == c) {
+			return true;
+		}
+		if (b != '/' || p->pos == p->end || *p->pos != '*') {
+			continue;
+		}
+		/* Skip comment, the opening '*' does not count for closing it */
+		p->pos++;
+		const char *close = NULL;
+		for (const char *s = p->pos; s + 1 < p->end; s++) {
+			if (s[0] == '*' && s[1] == '/') {
+				close = s;
+				break;
+			}
+		}
+		if (!close) {
+			return false;
+		}
+		p->pos = close + 2;
+	}
+	return false;
+}
+
+/* Return the contents of the next string literal without copying them */
+static bool
+next_string(struct parser *p, const char **str, size_t *len)
+{
+	if (!seek_char(p, '"')) {
+		return false;
+	}
+	const char *quote = memchr(p->pos, '"', p->end - p->pos);
+	if (!quote) {
+		return false;
+	}
+	*str = p->pos;
+	*len = quote - p->pos;
+	p->pos = quote + 1;
+	return true;
+}
+
+/* Copy a string into a NUL-terminated buffer, truncating if necessary */
+static void
+copy_string(char *dst, size_t size, const char *str, size_t len)
+{
+	len = MIN(len, size - 1);
+	memcpy(dst, str, len);
+	dst[len] = '\0';
+}
+
+static struct color_entry *
+color_table_find(struct color_table *table, const char *chars)
+{
+	size_t i = hash_add(HASH_INIT, chars, table->cpp) & table->mask;
+	while (table->entries[i].chars
+			&& memcmp(table->entries[i].chars, chars, table->cpp)) {
+		i = (i + 1) & table->mask;
+	}
+	return &table->entries[i];
+}
+
+static bool
+read_colors(struct parser *p, struct color_table *table, int nr_colors,
+		uint32_t *fallback)
+{
+	size_t size = 1;
+	while (size < (size_t)nr_colors * 2) {
+		size *= 2;
+	}
+	table->entries = znew_n(*table->entries, size);
+	table->mask = size - 1;
+
+	for (int i = 0; i < nr_colors; i++) {
+		const char *str;
+		size_t len;
+		if (!next_string(p, &str, &len)) {
+			wlr_log(WLR_DEBUG, "Cannot read XPM colormap");
+			return false;
+		}
+		uint32_t argb = 0;
+		if (len >= (size_t)table->cpp) {
+			char spec[XPM_MAX_LINE];
+			copy_string(spec, sizeof(spec), str + table->cpp,
+				len - table->cpp);
+			argb = xpm_extract_color(spec);
+
+			/* Later definitions of the same chars win */
+			struct color_entry *entry = color_table_find(table, str);
+			entry->chars = str;
+			entry->argb = argb;
+		}
+		if (i == 0) {
+			*fallback = argb;
+		}
+	}
+	return true;
+}
+
+static bool
+read_pixels(struct parser *p, struct color_table *table, uint32_t fallback,
+		uint32_t *pixels, int width, int height)
+{
+	int cpp = table->cpp;
+	size_t row_len = (size_t)width * cpp;
+	const char *last_chars = NULL;
+	uint32_t last_argb = 0;
+
+	for (int y = 0; y < height; y++) {
+		const char *str;
+		size_t len;
+		if (!next_string(p, &str, &len) || len < row_len) {
+			/* Advertised width doesn't match pixels */
+			wlr_log(WLR_DEBUG, "Dimensions do not match data");
+			return false;
+		}
+		uint32_t *row = pixels + (size_t)y * width;
+		for (int x = 0; x < width; x++, str += cpp) {
+			/* Neighboring pixels mostly have the same color */
+			if (!last_chars || memcmp(str, last_chars, cpp)) {
+				struct color_entry *entry =
+					color_table_find(table, str);
+				/* Bad XPM...punt */
+				last_argb = entry->chars ? entry->argb : fallback;
+				last_chars = str;
+			}
+			row[x] = last_argb;
+		}
+	}
+	return true;
+}
+
+uint32_t *
+xpm_decode(const char *data, size_t len, int *width, int *height)
+{
+	struct parser p = { .pos = data, .end = data + len };
+	const char *str;
+	size_t str_len;
+	if (!seek_magic(&p) || !seek_char(&p, '{')
+			|| !next_string(&p, &str, &str_len)) {
+		wlr_log(WLR_DEBUG, "No XPM header found");
+		return NULL;
+	}
+
+	char header[XPM_MAX_LINE];
+	copy_string(header, sizeof(header), str, str_len);
+	int w, h, n_col, cpp, x_hot, y_hot;
+	int items = sscanf(header, "%d %d %d %d %d %d", &w, &h, &n_col, &cpp,
+		&x_hot, &y_hot);
+
+	if (items != 4 && items != 6) {
+		wlr_log(WLR_DEBUG, "Invalid XPM header");
+		return NULL;
+	}
+	if (w <= 0 || h <= 0 || w > XPM_MAX_SIZE || h > XPM_MAX_SIZE) {
+		wlr_log(WLR_DEBUG, "XPM file has invalid size %dx%d", w, h);
+		return NULL;
+	}
+	if (cpp <= 0 || cpp > XPM_MAX_CPP) {
+		wlr_log(WLR_DEBUG, "XPM has invalid number of chars per pixel");
+		return NULL;
+	}
+	if (n_col <= 0 || n_col > XPM_MAX_COLORS) {
+		wlr_log(WLR_DEBUG, "XPM file has invalid number of colors");
+		return NULL;
+	}
+
+	struct color_table table = { .cpp = cpp };
+	uint32_t fallback = 0;
+	uint32_t *pixels = NULL;
+	if (!read_colors(&p, &table, n_col, &fallback)) {
+		goto out;
+	}
+	pixels = znew_n(*pixels, (size_t)w * h);
+	if (!read_pixels(&p, &table, fallback, pixels, w, h)) {
+		zfree(pixels);
+		goto out;
+	}
+	*width = w;
+	*height = h;
+out:
+	free(table.entries);
+	return pixels;
+}
@@ -1377,6 +1377,13 @@ process_cursor_axis(enum wl_pointer_axis orientation,
 	struct scroll_info info = compare_delta(delta, delta_discrete,
 		&server.seat.accumulated_scrolls[orientation]);
 
+	if (ctx.type == LAB_NODE_MENUITEM
+			&& orientation == WL_POINTER_AXIS_VERTICAL_SCROLL
+			&& menu_process_cursor_axis(ctx.node,
+				info.run_action ? info.direction : 0)) {
+		return false;
+	}
+
 	if (orientation == WL_POINTER_AXIS_HORIZONTAL_SCROLL) {
 		if (info.direction < 0) {
 			direction = LAB_DIRECTION_LEFT;
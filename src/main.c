@@ -13,6 +13,7 @@
 #include "config/rcxml.h"
 #include "config/session.h"
 #include "labwc.h"
+#include "startup-timeline.h"
 #include "theme.h"
 #include "translate.h"
 #include "menu/menu.h"
@@ -159,15 +160,16 @@ idle_callback(void *data)
 		}
 	}
 
-	session_autostart_init();
-	if (ctx->startup_cmd) {
-		spawn_async_no_shell(ctx->startup_cmd);
-	}
+	/* Runs the startup command after autostart */
+	startup_timeline_mark("event loop");
+	session_autostart_init(ctx->startup_cmd);
 }
 
 int
 main(int argc, char *argv[])
 {
+	startup_timeline_init();
+
 	char *startup_cmd = NULL;
 	char *primary_client = NULL;
 	enum wlr_log_importance verbosity = WLR_ERROR;
@@ -234,6 +236,7 @@ main(int argc, char *argv[])
 	die_on_no_fonts();
 
 	session_environment_init();
+	startup_timeline_mark("environment");
 
 #if HAVE_NLS
 	/* Initialize locale after setting env vars */
@@ -243,6 +246,7 @@ main(int argc, char *argv[])
 #endif
 
 	rcxml_read(rc.config_file);
+	startup_timeline_mark("rc.xml");
 
 	/*
 	 * Set environment variable LABWC_PID to the pid of the compositor
@@ -277,12 +281,15 @@ main(int argc, char *argv[])
 
 	server_init();
 	server_start();
+	startup_timeline_mark("backend start");
 
 	struct theme theme = { 0 };
 	theme_init(&theme, rc.theme_name);
 	rc.theme = &theme;
+	startup_timeline_mark("theme");
 
 	menu_init();
+	startup_timeline_mark("menu");
 
 	/* Delay startup of applications until the event loop is ready */
 	struct idle_ctx idle_ctx = {
@@ -23,6 +23,7 @@
 #include "common/scene-helpers.h"
 #include "common/spawn.h"
 #include "common/string-helpers.h"
+#include "common/time.h"
 #include "common/xml.h"
 #include "config/rcxml.h"
 #include "labwc.h"
@@ -40,8 +41,15 @@
 
 #define ICON_SIZE (rc.theme->menu_item_height - 2 * rc.theme->menu_items_padding_y)
 
+/* Number of items scrolled per mouse wheel step */
+#define MENU_SCROLL_STEP 3
+
 static bool waiting_for_pipe_menu;
+/* Set while the output of a pipemenu is being parsed */
+static bool parsing_pipe_menu;
 static struct menuitem *selected_item;
+/* Releases the scenes of closed menus after rc.menu_release_delay */
+static struct wl_event_source *release_timer;
 
 struct menu_pipe_context {
 	struct wlr_box anchor_rect;
@@ -51,6 +59,8 @@ struct menu_pipe_context {
 	struct wl_event_source *event_timeout;
 	pid_t pid;
 	int pipe_fd;
+	/* Only refresh the cache, do not open the menu when done */
+	bool background;
 };
 
 /* TODO: split this whole file into parser.c and actions.c*/
@@ -82,7 +92,8 @@ menu_create(struct menu *parent, const char *id,
 	menu->id = xstrdup(id);
 	menu->label = xstrdup(label ? label : id);
 	menu->parent = parent;
-	menu->is_pipemenu_child = waiting_for_pipe_menu;
+	menu->is_pipemenu_child = parsing_pipe_menu;
+	menu->pipe_cache.output = BUF_INIT;
 	return menu;
 }
 
@@ -223,7 +234,6 @@ item_create(struct menu *menu, const char *text, const char *icon_name, bool sho
 	assert(menu);
 	assert(text);
 
-	struct theme *theme = rc.theme;
 	struct menuitem *menuitem = znew(*menuitem);
 	menuitem->parent = menu;
 	menuitem->selectable = true;
@@ -239,11 +249,8 @@ item_create(struct menu *menu, const char *text, const char *icon_name, bool sho
 	}
 #endif
 
-	menuitem->native_width = font_width(&rc.font_menuitem, text);
-	if (menuitem->arrow) {
-		menuitem->native_width += font_width(&rc.font_menuitem, menuitem->arrow)
-					+ theme->menu_items_padding_x;
-	}
+	/* Measured by item_measure() once the menu is first shown */
+	menuitem->native_width = -1;
 
 	wl_list_append(&menu->menuitems, &menuitem->link);
 	wl_list_init(&menuitem->actions);
@@ -267,8 +274,7 @@ item_create_scene_for_state(struct menuitem *item, float *text_color,
 	}
 
 	int bg_width = menu->size.width - 2 * theme->menu_border_width;
-	int arrow_width = item->arrow ?
-		font_width(&rc.font_menuitem, item->arrow) + theme->menu_items_padding_x : 0;
+	int arrow_width = item->arrow ? menu->arrow_width : 0;
 	int label_max_width = bg_width - 2 * theme->menu_items_padding_x
 		- arrow_width - icon_width;
 
@@ -326,7 +332,7 @@ item_create_scene_for_state(struct menuitem *item, float *text_color,
 }
 
 static void
-item_create_scene(struct menuitem *menuitem, int *item_y)
+item_create_scene(struct menuitem *menuitem)
 {
 	assert(menuitem);
 	assert(menuitem->type == LAB_MENU_ITEM);
@@ -347,11 +353,6 @@ item_create_scene(struct menuitem *menuitem, int *item_y)
 		theme->menu_items_active_bg_color);
 	/* Hide selected state */
 	wlr_scene_node_set_enabled(&menuitem->selected_tree->node, false);
-
-	/* Position the item in relation to its menu */
-	wlr_scene_node_set_position(&menuitem->tree->node,
-		theme->menu_border_width, *item_y);
-	*item_y += theme->menu_item_height;
 }
 
 static struct menuitem *
@@ -366,8 +367,8 @@ separator_create(struct menu *menu, const char *label)
 		: LAB_MENU_TITLE;
 	if (menuitem->type == LAB_MENU_TITLE) {
 		menuitem->text = xstrdup(label);
-		menuitem->native_width = font_width(&rc.font_menuheader, label);
 	}
+	menuitem->native_width = -1;
 
 	wl_list_append(&menu->menuitems, &menuitem->link);
 	wl_list_init(&menuitem->actions);
@@ -375,7 +376,7 @@ separator_create(struct menu *menu, const char *label)
 }
 
 static void
-separator_create_scene(struct menuitem *menuitem, int *item_y)
+separator_create_scene(struct menuitem *menuitem)
 {
 	assert(menuitem);
 	assert(menuitem->type == LAB_MENU_SEPARATOR_LINE);
@@ -390,14 +391,13 @@ separator_create_scene(struct menuitem *menuitem, int *item_y)
 	/* Tree to hold background and line buffer */
 	menuitem->normal_tree = lab_wlr_scene_tree_create(menuitem->tree);
 
-	int bg_height = theme->menu_separator_line_thickness
-		+ 2 * theme->menu_separator_padding_height;
+	int bg_height = menuitem->height;
 	int bg_width = menu->size.width - 2 * theme->menu_border_width;
 	int line_width = bg_width - 2 * theme->menu_separator_padding_width;
 
 	if (line_width <= 0) {
 		wlr_log(WLR_ERROR, "not enough space for menu separator");
-		goto error;
+		return;
 	}
 
 	/* Item background nodes */
@@ -414,14 +414,10 @@ separator_create_scene(struct menuitem *menuitem, int *item_y)
 	wlr_scene_node_set_position(&line_rect->node,
 		theme->menu_separator_padding_width,
 		theme->menu_separator_padding_height);
-error:
-	wlr_scene_node_set_position(&menuitem->tree->node,
-		theme->menu_border_width, *item_y);
-	*item_y += bg_height;
 }
 
 static void
-title_create_scene(struct menuitem *menuitem, int *item_y)
+title_create_scene(struct menuitem *menuitem)
 {
 	assert(menuitem);
 	assert(menuitem->type == LAB_MENU_TITLE);
@@ -443,7 +439,7 @@ title_create_scene(struct menuitem *menuitem, int *item_y)
 
 	if (text_width <= 0) {
 		wlr_log(WLR_ERROR, "not enough space for menu title");
-		goto error;
+		return;
 	}
 
 	/* Background */
@@ -474,46 +470,120 @@ title_create_scene(struct menuitem *menuitem, int *item_y)
 	int title_y = (theme->menu_header_height - title_font_buffer->height) / 2;
 	wlr_scene_node_set_position(&title_font_buffer->scene_buffer->node,
 		title_x, title_y);
-error:
-	wlr_scene_node_set_position(&menuitem->tree->node,
-		theme->menu_border_width, *item_y);
-	*item_y += theme->menu_header_height;
 }
 
 static void item_destroy(struct menuitem *item);
 
 static void
-reset_menu(struct menu *menu)
+item_destroy_scene(struct menuitem *item)
 {
-	struct menuitem *item, *next;
-	wl_list_for_each_safe(item, next, &menu->menuitems, link) {
-		item_destroy(item);
+	if (item->tree) {
+		wlr_scene_node_destroy(&item->tree->node);
 	}
+	item->tree = NULL;
+	item->normal_tree = NULL;
+	item->selected_tree = NULL;
+}
+
+static void
+menu_destroy_scene(struct menu *menu)
+{
+	struct menuitem *item;
+	wl_list_for_each(item, &menu->menuitems, link) {
+		item_destroy_scene(item);
+	}
+	/*
+	 * Destroying the root node will destroy everything,
+	 * including node descriptors and scaled_font_buffers.
+	 */
 	if (menu->scene_tree) {
 		wlr_scene_node_destroy(&menu->scene_tree->node);
 		menu->scene_tree = NULL;
 	}
+	menu->bg_rect = NULL;
+}
+
+static void
+reset_menu(struct menu *menu)
+{
+	menu_destroy_scene(menu);
+	struct menuitem *item, *next;
+	wl_list_for_each_safe(item, next, &menu->menuitems, link) {
+		item_destroy(item);
+	}
 	/* TODO: also reset other fields? */
 }
 
+/* Measure the label exactly like scaled_font_buffer does to render it */
+static int
+item_label_width(struct menuitem *item)
+{
+	int width, height;
+	font_get_buffer_size(/* max_width */ 0, item->text, &rc.font_menuitem,
+		&width, &height, item->use_markup);
+	return width;
+}
+
+/*
+ * Text is measured here rather than when parsing menu.xml because large
+ * generated menus contain many submenus which are never opened.
+ */
 static void
-menu_create_scene(struct menu *menu)
+item_measure(struct menuitem *item)
 {
-	struct menuitem *item;
 	struct theme *theme = rc.theme;
 
-	assert(!menu->scene_tree);
+	switch (item->type) {
+	case LAB_MENU_ITEM:
+		item->height = theme->menu_item_height;
+		if (item->native_width < 0) {
+			item->native_width = item_label_width(item);
+		}
+		break;
+	case LAB_MENU_SEPARATOR_LINE:
+		item->height = theme->menu_separator_line_thickness
+			+ 2 * theme->menu_separator_padding_height;
+		item->native_width = 0;
+		break;
+	case LAB_MENU_TITLE:
+		item->height = theme->menu_header_height;
+		if (item->native_width < 0) {
+			item->native_width =
+				font_width(&rc.font_menuheader, item->text);
+		}
+		break;
+	}
+}
 
-	menu->scene_tree = lab_wlr_scene_tree_create(server.menu_tree);
-	wlr_scene_node_set_enabled(&menu->scene_tree->node, false);
+static void
+menu_layout(struct menu *menu)
+{
+	struct menuitem *item;
+	struct theme *theme = rc.theme;
+
+	/* All submenu arrows are the same, so measure them once */
+	menu->arrow_width = 0;
+	wl_list_for_each(item, &menu->menuitems, link) {
+		if (item->arrow) {
+			menu->arrow_width = font_width(&rc.font_menuitem,
+				item->arrow) + theme->menu_items_padding_x;
+			break;
+		}
+	}
 
 	/* Menu width is the maximum item width, capped by menu.width.{min,max} */
 	menu->size.width = 0;
+	int item_y = theme->menu_border_width;
 	wl_list_for_each(item, &menu->menuitems, link) {
+		item_measure(item);
 		int width = item->native_width
+			+ (item->arrow ? menu->arrow_width : 0)
 			+ 2 * theme->menu_items_padding_x
 			+ 2 * theme->menu_border_width;
 		menu->size.width = MAX(menu->size.width, width);
+
+		item->y = item_y;
+		item_y += item->height;
 	}
 
 	if (menu->has_icons) {
@@ -522,34 +592,125 @@ menu_create_scene(struct menu *menu)
 	menu->size.width = MAX(menu->size.width, theme->menu_min_width);
 	menu->size.width = MIN(menu->size.width, theme->menu_max_width);
 
-	/* Update all items for the new size */
-	int item_y = theme->menu_border_width;
+	menu->content_height = item_y + theme->menu_border_width;
+	menu->size.height = menu->content_height;
+}
+
+static void
+item_set_selected(struct menuitem *item, bool selected)
+{
+	/* Items scrolled out of view have no scene */
+	if (!item->tree) {
+		return;
+	}
+	wlr_scene_node_set_enabled(&item->normal_tree->node, !selected);
+	wlr_scene_node_set_enabled(&item->selected_tree->node, selected);
+}
+
+/* Only items which are entirely within the visible part have a scene */
+static bool
+item_is_visible(struct menuitem *item)
+{
+	struct menu *menu = item->parent;
+	int border = rc.theme->menu_border_width;
+	int y = item->y - menu->scroll;
+	return y >= border && y + item->height <= menu->size.height - border;
+}
+
+static void
+menu_update_visible_items(struct menu *menu)
+{
+	struct menuitem *item;
 	wl_list_for_each(item, &menu->menuitems, link) {
-		assert(!item->tree);
-		switch (item->type) {
-		case LAB_MENU_ITEM:
-			item_create_scene(item, &item_y);
-			break;
-		case LAB_MENU_SEPARATOR_LINE:
-			separator_create_scene(item, &item_y);
-			break;
-		case LAB_MENU_TITLE:
-			title_create_scene(item, &item_y);
-			break;
+		if (!item_is_visible(item)) {
+			item_destroy_scene(item);
+			continue;
 		}
+		if (!item->tree) {
+			switch (item->type) {
+			case LAB_MENU_ITEM:
+				item_create_scene(item);
+				break;
+			case LAB_MENU_SEPARATOR_LINE:
+				separator_create_scene(item);
+				break;
+			case LAB_MENU_TITLE:
+				title_create_scene(item);
+				break;
+			}
+			if (item == menu->selection.item) {
+				item_set_selected(item, true);
+			}
+		}
+		/* Position the item in relation to its menu */
+		wlr_scene_node_set_position(&item->tree->node,
+			rc.theme->menu_border_width, item->y - menu->scroll);
+	}
+}
+
+static void
+menu_scroll_to(struct menu *menu, int scroll)
+{
+	scroll = MIN(scroll, menu->content_height - menu->size.height);
+	menu->scroll = MAX(scroll, 0);
+	menu_update_visible_items(menu);
+}
+
+static void
+menu_scroll_to_item(struct menu *menu, struct menuitem *item)
+{
+	int border = rc.theme->menu_border_width;
+	int scroll = menu->scroll;
+	if (item->y - border < scroll) {
+		scroll = item->y - border;
+	} else if (item->y + item->height + border > scroll + menu->size.height) {
+		scroll = item->y + item->height + border - menu->size.height;
+	}
+	if (scroll != menu->scroll) {
+		menu_scroll_to(menu, scroll);
 	}
-	menu->size.height = item_y + theme->menu_border_width;
+}
+
+static void
+menu_set_height(struct menu *menu, int height)
+{
+	height = MIN(height, menu->content_height);
+	if (height == menu->size.height) {
+		return;
+	}
+	menu->size.height = height;
+	lab_scene_rect_set_size(menu->bg_rect, menu->size.width, height);
+}
+
+/*
+ * Item scenes are not created here but by menu_update_visible_items() once
+ * the menu height is known, so that menus taller than the output only
+ * render the visible slice.
+ */
+static void
+menu_create_scene(struct menu *menu)
+{
+	struct theme *theme = rc.theme;
+
+	assert(!menu->scene_tree);
+
+	menu->scene_tree = lab_wlr_scene_tree_create(server.menu_tree);
+	wlr_scene_node_set_enabled(&menu->scene_tree->node, false);
+
+	menu_layout(menu);
+	menu->scroll = 0;
 
 	struct lab_scene_rect_options opts = {
 		.border_colors = (float *[1]) {theme->menu_border_color},
 		.nr_borders = 1,
 		.border_width = theme->menu_border_width,
+		/* Fills the gap below the last visible item when scrolled */
+		.bg_color = theme->menu_items_bg_color,
 		.width = menu->size.width,
 		.height = menu->size.height,
 	};
-	struct lab_scene_rect *bg_rect =
-		lab_scene_rect_create(menu->scene_tree, &opts);
-	wlr_scene_node_lower_to_bottom(&bg_rect->tree->node);
+	menu->bg_rect = lab_scene_rect_create(menu->scene_tree, &opts);
+	wlr_scene_node_lower_to_bottom(&menu->bg_rect->tree->node);
 }
 
 /*
@@ -609,6 +770,7 @@ fill_menu(struct menu *parent, xmlNode *n)
 	char *label = (char *)xmlGetProp(n, (const xmlChar *)"label");
 	char *icon_name = (char *)xmlGetProp(n, (const xmlChar *)"icon");
 	char *execute = (char *)xmlGetProp(n, (const xmlChar *)"execute");
+	char *cache = (char *)xmlGetProp(n, (const xmlChar *)"cache");
 	char *id = (char *)xmlGetProp(n, (const xmlChar *)"id");
 
 	if (!id) {
@@ -621,6 +783,9 @@ fill_menu(struct menu *parent, xmlNode *n)
 
 		struct menu *pipemenu = menu_create(parent, id, label);
 		pipemenu->execute = xstrdup(execute);
+		if (cache) {
+			pipemenu->pipe_cache.ttl = MAX(atoi(cache), 0) * 1000;
+		}
 		if (!parent) {
 			/*
 			 * A pipemenu may not have its parent like:
@@ -680,7 +845,7 @@ fill_menu(struct menu *parent, xmlNode *n)
 		 * pipemenu opening the "root-menu" or similar.
 		 */
 
-		if (waiting_for_pipe_menu) {
+		if (parsing_pipe_menu) {
 			wlr_log(WLR_ERROR,
 				"cannot link to static menu from pipemenu");
 			goto error;
@@ -710,6 +875,7 @@ error:
 	xmlFree(label);
 	xmlFree(icon_name);
 	xmlFree(execute);
+	xmlFree(cache);
 	xmlFree(id);
 }
 
@@ -763,7 +929,6 @@ parse_buf(struct menu *parent, struct buf *buf)
 	fill_menu_children(parent, root);
 
 	xmlFreeDoc(d);
-	xmlCleanupParser();
 	return true;
 }
 
@@ -807,7 +972,7 @@ get_item_anchor_rect(struct theme *theme, struct menuitem *item)
 	int overlap_y = theme->menu_overlap_y - theme->menu_border_width;
 	return (struct wlr_box) {
 		.x = menu_x + overlap_x,
-		.y = menu_y + item->tree->node.y + overlap_y,
+		.y = menu_y + item->y - menu->scroll + overlap_y,
 		.width = menu->size.width - 2 * overlap_x,
 		.height = theme->menu_item_height - 2 * overlap_y,
 	};
@@ -825,6 +990,9 @@ menu_reposition(struct menu *menu, struct wlr_box anchor_rect)
 	}
 	struct wlr_box usable = output_usable_area_in_layout_coords(output);
 
+	/* Menus taller than the output are scrolled */
+	menu_set_height(menu, usable.height);
+
 	/* Policy for menu placement */
 	struct wlr_xdg_positioner_rules rules = {0};
 	rules.size.width = menu->size.width;
@@ -887,6 +1055,79 @@ item_add_action(struct menuitem *item, const char *action_name)
 	return action;
 }
 
+/* Detach the items of @menu so that reuse_items() can pick from them */
+static void
+take_items(struct menu *menu, struct wl_list *old)
+{
+	wl_list_init(old);
+	wl_list_insert_list(old, &menu->menuitems);
+	wl_list_init(&menu->menuitems);
+	menu->has_icons = false;
+}
+
+static bool
+item_has_same_scene(struct menuitem *a, struct menuitem *b)
+{
+	/* Items of destroyed views have their actions removed */
+	return a->type == b->type
+		&& a->client_list_view == b->client_list_view
+		&& wl_list_empty(&a->actions) == wl_list_empty(&b->actions)
+		&& a->use_markup == b->use_markup
+		&& !a->arrow == !b->arrow
+		&& str_equal(a->text, b->text)
+		&& str_equal(a->icon_name, b->icon_name);
+}
+
+/*
+ * Replace the newly created items of @menu by identical ones from @old so
+ * that their scene nodes and rendered buffers are kept. The new actions
+ * are moved over as they may differ even if the label is the same. Items
+ * left in @old are destroyed.
+ */
+static void
+reuse_items(struct menu *menu, struct wl_list *old, bool had_icons)
+{
+	struct menuitem *item, *tmp, *match;
+	wl_list_for_each_safe(item, tmp, &menu->menuitems, link) {
+		/* Items are mostly in the same order, so this is usually O(1) */
+		bool found = false;
+		wl_list_for_each(match, old, link) {
+			if (item_has_same_scene(item, match)) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) {
+			continue;
+		}
+		wl_list_remove(&match->link);
+		wl_list_insert(&item->link, &match->link);
+		action_list_free(&match->actions);
+		wl_list_insert_list(&match->actions, &item->actions);
+		wl_list_init(&item->actions);
+		item_destroy(item);
+	}
+	wl_list_for_each_safe(item, tmp, old, link) {
+		item_destroy(item);
+	}
+
+	if (!menu->scene_tree) {
+		/* Laid out by menu_create_scene() when opened */
+		return;
+	}
+
+	/* Items are rendered for the menu width and icon column */
+	int width = menu->size.width;
+	menu_layout(menu);
+	if (menu->size.width != width || menu->has_icons != had_icons) {
+		wl_list_for_each(item, &menu->menuitems, link) {
+			item_destroy_scene(item);
+		}
+	}
+	lab_scene_rect_set_size(menu->bg_rect, menu->size.width,
+		menu->size.height);
+}
+
 /*
  * This is client-send-to-menu
  * an internal menu similar to root-menu and client-menu
@@ -901,7 +1142,9 @@ update_client_send_to_menu(void)
 	struct menu *menu = menu_get_by_id("client-send-to-menu");
 	assert(menu);
 
-	reset_menu(menu);
+	struct wl_list old;
+	bool had_icons = menu->has_icons;
+	take_items(menu, &old);
 
 	struct workspace *workspace;
 
@@ -920,7 +1163,7 @@ update_client_send_to_menu(void)
 			NULL, /*show arrow*/ false);
 
 		struct action *action = item_add_action(item, "SendToDesktop");
-		action_arg_add_str(action, "to", workspace->name);
+		action_arg_add_str(action, ACTION_ARG_TO, workspace->name);
 
 		buf_clear(&buf);
 	}
@@ -931,7 +1174,7 @@ update_client_send_to_menu(void)
 		_("Always on Visible Workspace"), NULL, false);
 	item_add_action(item, "ToggleOmnipresent");
 
-	menu_create_scene(menu);
+	reuse_items(menu, &old, had_icons);
 }
 
 /*
@@ -948,7 +1191,9 @@ update_client_list_combined_menu(void)
 	struct menu *menu = menu_get_by_id("client-list-combined-menu");
 	assert(menu);
 
-	reset_menu(menu);
+	struct wl_list old;
+	bool had_icons = menu->has_icons;
+	take_items(menu, &old);
 
 	struct menuitem *item;
 	struct workspace *workspace;
@@ -961,37 +1206,36 @@ update_client_list_combined_menu(void)
 		separator_create(menu, buffer.data);
 		buf_clear(&buffer);
 
-		wl_list_for_each(view, &server.views, link) {
-			if (view->workspace == workspace) {
-				if (!view->foreign_toplevel
-						|| string_null_or_empty(view->title)) {
-					continue;
-				}
+		wl_list_for_each(view, &workspace->views, workspace_link) {
+			if (!view->foreign_toplevel
+					|| string_null_or_empty(view->title)) {
+				continue;
+			}
 
-				if (view == server.active_view) {
-					buf_add(&buffer, "*");
-				}
-				if (view->minimized) {
-					buf_add_fmt(&buffer, "(%s)", view->title);
-				} else {
-					buf_add(&buffer, view->title);
-				}
-				item = item_create(menu, buffer.data, NULL,
-					/*show arrow*/ false);
-				item->client_list_view = view;
-				item_add_action(item, "Focus");
-				item_add_action(item, "Raise");
-				buf_clear(&buffer);
-				menu->has_icons = true;
+			if (view == server.active_view) {
+				buf_add(&buffer, "*");
 			}
+			if (view->minimized) {
+				buf_add_fmt(&buffer, "(%s)", view->title);
+			} else {
+				buf_add(&buffer, view->title);
+			}
+			item = item_create(menu, buffer.data, NULL,
+				/*show arrow*/ false);
+			item->client_list_view = view;
+			item_add_action(item, "Focus");
+			item_add_action(item, "Raise");
+			buf_clear(&buffer);
+			menu->has_icons = true;
 		}
 		item = item_create(menu, _("Go there..."), NULL,
 			/*show arrow*/ false);
 		struct action *action = item_add_action(item, "GoToDesktop");
-		action_arg_add_str(action, "to", workspace->name);
+		action_arg_add_str(action, ACTION_ARG_TO, workspace->name);
 	}
 	buf_reset(&buffer);
-	menu_create_scene(menu);
+
+	reuse_items(menu, &old, had_icons);
 }
 
 static void
@@ -1006,7 +1250,7 @@ init_rootmenu(void)
 
 		item = item_create(menu, _("Terminal"), NULL, false);
 		struct action *action = item_add_action(item, "Execute");
-		action_arg_add_str(action, "command", "lab-sensible-terminal");
+		action_arg_add_str(action, ACTION_ARG_COMMAND, "lab-sensible-terminal");
 
 		separator_create(menu, NULL);
 
@@ -1052,10 +1296,34 @@ init_windowmenu(void)
 	}
 }
 
+static int
+handle_release_timer(void *data)
+{
+	if (server.menu_current) {
+		return 0;
+	}
+	struct menu *menu;
+	wl_list_for_each(menu, &server.menus, link) {
+		menu_destroy_scene(menu);
+	}
+	return 0;
+}
+
+static void
+schedule_scene_release(void)
+{
+	if (rc.menu_release_delay) {
+		wl_event_source_timer_update(release_timer,
+			rc.menu_release_delay);
+	}
+}
+
 void
 menu_init(void)
 {
 	wl_list_init(&server.menus);
+	release_timer = wl_event_loop_add_timer(server.wl_event_loop,
+		handle_release_timer, NULL);
 
 	/* Just create placeholder. Contents will be created when launched */
 	menu_create(NULL, "client-list-combined-menu", _("Windows"));
@@ -1116,13 +1384,8 @@ menu_free(struct menu *menu)
 		assert(!menu->pipe_ctx);
 	}
 
-	/*
-	 * Destroying the root node will destroy everything,
-	 * including node descriptors and scaled_font_buffers.
-	 */
-	if (menu->scene_tree) {
-		wlr_scene_node_destroy(&menu->scene_tree->node);
-	}
+	menu_destroy_scene(menu);
+	buf_reset(&menu->pipe_cache.output);
 	wl_list_remove(&menu->link);
 	zfree(menu->id);
 	zfree(menu->label);
@@ -1138,6 +1401,10 @@ menu_finish(void)
 	wl_list_for_each_safe(menu, tmp_menu, &server.menus, link) {
 		menu_free(menu);
 	}
+	if (release_timer) {
+		wl_event_source_remove(release_timer);
+		release_timer = NULL;
+	}
 }
 
 void
@@ -1174,15 +1441,11 @@ menu_set_selection(struct menu *menu, struct menuitem *item)
 {
 	/* Clear old selection */
 	if (menu->selection.item) {
-		wlr_scene_node_set_enabled(
-			&menu->selection.item->normal_tree->node, true);
-		wlr_scene_node_set_enabled(
-			&menu->selection.item->selected_tree->node, false);
+		item_set_selected(menu->selection.item, false);
 	}
 	/* Set new selection */
 	if (item) {
-		wlr_scene_node_set_enabled(&item->normal_tree->node, false);
-		wlr_scene_node_set_enabled(&item->selected_tree->node, true);
+		item_set_selected(item, true);
 	}
 	menu->selection.item = item;
 }
@@ -1228,7 +1491,8 @@ _close(struct menu *menu)
 		_close(menu->selection.menu);
 		menu->selection.menu = NULL;
 	}
-	if (menu->pipe_ctx) {
+	/* Let cache refreshes finish even though the menu is closed */
+	if (menu->pipe_ctx && !menu->pipe_ctx->background) {
 		pipemenu_ctx_destroy(menu->pipe_ctx);
 		assert(!menu->pipe_ctx);
 	}
@@ -1258,10 +1522,14 @@ open_menu(struct menu *menu, struct wlr_box anchor_rect)
 		assert(menu->scene_tree);
 	}
 	menu_reposition(menu, anchor_rect);
+	menu_scroll_to(menu, 0);
 	wlr_scene_node_set_enabled(&menu->scene_tree->node, true);
+
+	prefetch_pipemenus(menu);
 }
 
 static void open_pipemenu_async(struct menu *pipemenu, struct wlr_box anchor_rect);
+static void prefetch_pipemenus(struct menu *menu);
 
 void
 menu_open_root(struct menu *menu, int x, int y)
@@ -1274,6 +1542,9 @@ menu_open_root(struct menu *menu, int x, int y)
 
 	assert(!server.menu_current);
 
+	/* Keep the scenes around while the menu is in use */
+	wl_event_source_timer_update(release_timer, 0);
+
 	struct wlr_box anchor_rect = {.x = x, .y = y};
 	if (menu->execute) {
 		open_pipemenu_async(menu, anchor_rect);
@@ -1287,17 +1558,45 @@ menu_open_root(struct menu *menu, int x, int y)
 		LAB_INPUT_STATE_MENU, LAB_CURSOR_DEFAULT);
 }
 
+/* Returns the age of the cached output in ms or -1 if there is none */
+static double
+pipemenu_cache_age(struct menu *pipemenu)
+{
+	if (!pipemenu->pipe_cache.ttl || !pipemenu->pipe_cache.output.len) {
+		return -1;
+	}
+	return get_time_ms() - pipemenu->pipe_cache.updated;
+}
+
 static void
-create_pipe_menu(struct menu_pipe_context *ctx)
+pipemenu_cache_store(struct menu *pipemenu, struct buf *output)
 {
-	if (!parse_buf(ctx->pipemenu, &ctx->buf)) {
+	if (!pipemenu->pipe_cache.ttl) {
 		return;
 	}
+	buf_move(&pipemenu->pipe_cache.output, output);
+	pipemenu->pipe_cache.updated = get_time_ms();
+	wlr_log(WLR_DEBUG, "[pipemenu %s] cached %d bytes for %d ms",
+		pipemenu->id, pipemenu->pipe_cache.output.len,
+		pipemenu->pipe_cache.ttl);
+}
+
+/* Parses the output of a pipemenu command and opens the new submenu tree */
+static bool
+open_pipemenu_from_buf(struct menu *pipemenu, struct buf *buf,
+		struct wlr_box anchor_rect)
+{
+	parsing_pipe_menu = true;
+	bool ok = parse_buf(pipemenu, buf);
+	parsing_pipe_menu = false;
+	if (!ok) {
+		return false;
+	}
 	/* TODO: apply validate() only for generated pipemenus */
 	validate();
 
-	/* Finally open the new submenu tree */
-	open_menu(ctx->pipemenu, ctx->anchor_rect);
+	open_menu(pipemenu, anchor_rect);
+	return true;
 }
 
 static void
@@ -1310,8 +1609,10 @@ pipemenu_ctx_destroy(struct menu_pipe_context *ctx)
 	if (ctx->pipemenu) {
 		ctx->pipemenu->pipe_ctx = NULL;
 	}
+	if (!ctx->background) {
+		waiting_for_pipe_menu = false;
+	}
 	free(ctx);
-	waiting_for_pipe_menu = false;
 }
 
 static int
@@ -1366,7 +1667,11 @@ handle_pipemenu_readable(int fd, uint32_t mask, void *_ctx)
 		goto clean_up;
 	}
 
-	create_pipe_menu(ctx);
+	if (ctx->background
+			|| open_pipemenu_from_buf(ctx->pipemenu, &ctx->buf,
+				ctx->anchor_rect)) {
+		pipemenu_cache_store(ctx->pipemenu, &ctx->buf);
+	}
 
 clean_up:
 	pipemenu_ctx_destroy(ctx);
@@ -1374,10 +1679,10 @@ clean_up:
 }
 
 static void
-open_pipemenu_async(struct menu *pipemenu, struct wlr_box anchor_rect)
+spawn_pipemenu(struct menu *pipemenu, struct wlr_box anchor_rect,
+		bool background)
 {
 	assert(!pipemenu->pipe_ctx);
-	assert(!pipemenu->scene_tree);
 
 	int pipe_fd = 0;
 	pid_t pid = spawn_piped(pipemenu->execute, &pipe_fd);
@@ -1387,13 +1692,16 @@ open_pipemenu_async(struct menu *pipemenu, struct wlr_box anchor_rect)
 		return;
 	}
 
-	waiting_for_pipe_menu = true;
+	if (!background) {
+		waiting_for_pipe_menu = true;
+	}
 	struct menu_pipe_context *ctx = znew(*ctx);
 	ctx->pid = pid;
 	ctx->pipe_fd = pipe_fd;
 	ctx->buf = BUF_INIT;
 	ctx->anchor_rect = anchor_rect;
 	ctx->pipemenu = pipemenu;
+	ctx->background = background;
 	pipemenu->pipe_ctx = ctx;
 
 	ctx->event_read = wl_event_loop_add_fd(server.wl_event_loop,
@@ -1403,8 +1711,71 @@ open_pipemenu_async(struct menu *pipemenu, struct wlr_box anchor_rect)
 		handle_pipemenu_timeout, ctx);
 	wl_event_source_timer_update(ctx->event_timeout, PIPEMENU_TIMEOUT_IN_MS);
 
-	wlr_log(WLR_DEBUG, "[pipemenu %ld] executed: %s",
-		(long)ctx->pid, ctx->pipemenu->execute);
+	wlr_log(WLR_DEBUG, "[pipemenu %ld] executed%s: %s", (long)ctx->pid,
+		background ? " in background" : "", ctx->pipemenu->execute);
+}
+
+static void
+open_pipemenu_async(struct menu *pipemenu, struct wlr_box anchor_rect)
+{
+	assert(!pipemenu->scene_tree);
+
+	/*
+	 * Show cached output right away, even if it has expired, and only
+	 * refresh it in the background (stale-while-revalidate)
+	 */
+	double age = pipemenu_cache_age(pipemenu);
+	if (age >= 0) {
+		bool stale = age > pipemenu->pipe_cache.ttl;
+		wlr_log(WLR_DEBUG, "[pipemenu %s] cache %s (age %.0f ms)",
+			pipemenu->id, stale ? "stale" : "hit", age);
+		if (open_pipemenu_from_buf(pipemenu, &pipemenu->pipe_cache.output,
+				anchor_rect)) {
+			if (stale && !pipemenu->pipe_ctx) {
+				spawn_pipemenu(pipemenu, anchor_rect,
+					/* background */ true);
+			}
+			return;
+		}
+		buf_reset(&pipemenu->pipe_cache.output);
+	} else if (pipemenu->pipe_cache.ttl) {
+		wlr_log(WLR_DEBUG, "[pipemenu %s] cache miss", pipemenu->id);
+	}
+
+	struct menu_pipe_context *ctx = pipemenu->pipe_ctx;
+	if (ctx) {
+		/* A prefetch is already running, open the menu once it is done */
+		assert(ctx->background);
+		ctx->background = false;
+		ctx->anchor_rect = anchor_rect;
+		waiting_for_pipe_menu = true;
+		return;
+	}
+	spawn_pipemenu(pipemenu, anchor_rect, /* background */ false);
+}
+
+/*
+ * Run the commands of cached pipemenus which are likely to be opened next,
+ * i.e. those linked from a menu that has just been shown
+ */
+static void
+prefetch_pipemenus(struct menu *menu)
+{
+	struct menuitem *item;
+	wl_list_for_each(item, &menu->menuitems, link) {
+		struct menu *pipemenu = item->submenu;
+		if (!pipemenu || !pipemenu->execute || !pipemenu->pipe_cache.ttl
+				|| pipemenu->pipe_ctx || pipemenu->scene_tree) {
+			continue;
+		}
+		double age = pipemenu_cache_age(pipemenu);
+		if (age >= 0 && age <= pipemenu->pipe_cache.ttl) {
+			continue;
+		}
+		wlr_log(WLR_DEBUG, "[pipemenu %s] prefetching", pipemenu->id);
+		spawn_pipemenu(pipemenu, (struct wlr_box){0},
+			/* background */ true);
+	}
 }
 
 static void
@@ -1427,6 +1798,7 @@ menu_process_item_selection(struct menuitem *item)
 	}
 
 	/* We are on an item that has new focus */
+	menu_scroll_to_item(item->parent, item);
 	menu_set_selection(item->parent, item);
 	if (item->parent->selection.menu) {
 		/* Close old submenu tree */
@@ -1533,6 +1905,7 @@ menu_execute_item(struct menuitem *item)
 	}
 
 	reset_pipemenus();
+	schedule_scene_release();
 	return true;
 }
 
@@ -1658,6 +2031,31 @@ menu_process_cursor_motion(struct wlr_scene_node *node)
 	menu_process_item_selection(item);
 }
 
+bool
+menu_process_cursor_axis(struct wlr_scene_node *node, int steps)
+{
+	assert(node && node->data);
+	struct menu *menu = node_menuitem_from_node(node)->parent;
+	if (menu->content_height <= menu->size.height) {
+		return false;
+	}
+	if (!steps) {
+		return true;
+	}
+
+	/* The submenu would otherwise be left next to a moved item */
+	if (menu->selection.menu) {
+		menu_close(menu->selection.menu);
+		menu->selection.menu = NULL;
+	}
+	menu_set_selection(menu, NULL);
+	selected_item = NULL;
+
+	menu_scroll_to(menu, menu->scroll
+		+ steps * MENU_SCROLL_STEP * rc.theme->menu_item_height);
+	return true;
+}
+
 void
 menu_close_root(void)
 {
@@ -1667,6 +2065,7 @@ menu_close_root(void)
 	menu_close(server.menu_current);
 	server.menu_current = NULL;
 	reset_pipemenus();
+	schedule_scene_release();
 	seat_focus_override_end(&server.seat, /*restore_focus*/ true);
 }
 
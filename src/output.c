@@ -36,6 +36,7 @@
 #include "output-virtual.h"
 #include "regions.h"
 #include "session-lock.h"
+#include "startup-timeline.h"
 #include "view.h"
 #include "xwayland.h"
 
@@ -318,9 +319,9 @@ handle_output_destroy(struct wl_listener *listener, void *data)
 	wlr_scene_node_destroy(&output->layer_popup_tree->node);
 	wlr_scene_node_destroy(&output->cycle_osd_tree->node);
 	wlr_scene_node_destroy(&output->session_lock_tree->node);
-	if (output->workspace_osd) {
-		wlr_scene_node_destroy(&output->workspace_osd->node);
-		output->workspace_osd = NULL;
+	if (output->workspace_osd.tree) {
+		wlr_scene_node_destroy(&output->workspace_osd.tree->node);
+		output->workspace_osd.tree = NULL;
 	}
 
 	struct view *view;
@@ -581,6 +582,7 @@ configure_new_output(struct output *output)
 	 * layout above.
 	 */
 	lab_wlr_scene_output_commit(output->scene_output, &output->pending);
+	startup_timeline_watch_output(wlr_output);
 
 	/*
 	 * Collect the effective resolution after the final commit.
@@ -135,7 +135,7 @@ _scaled_font_buffer_update(struct scaled_font_buffer *self, const char *text,
 	/* Calculate the size of font buffer and request re-rendering */
 	int computed_height;
 	font_get_buffer_size(self->max_width, self->text, &self->font,
-		&self->width, &computed_height);
+		&self->width, &computed_height, self->use_markup);
 	self->height = (self->fixed_height > 0) ?
 		self->fixed_height : computed_height;
 	scaled_buffer_request_update(self->scaled_buffer,
@@ -7,10 +7,12 @@
 #include "buffer.h"
 #include "common/mem.h"
 #include "common/string-helpers.h"
+#include "common/thread-pool.h"
 #include "config.h"
 #include "config/rcxml.h"
 #include "desktop-entry.h"
 #include "img/img.h"
+#include "labwc.h"
 #include "node.h"
 #include "scaled-buffer/scaled-buffer.h"
 #include "view.h"
@@ -18,6 +20,45 @@
 
 #if HAVE_LIBSFDO
 
+/* Icon loading is mostly I/O bound, a couple of workers are enough */
+#define ICON_LOADER_THREADS 2
+
+/*
+ * Looking up icons in the icon theme and .desktop files and rendering large
+ * SVGs can take tens of milliseconds, so icons are loaded on a worker thread
+ * and the buffer is left empty until then.
+ *
+ * An icon_request holds copies of everything needed to load the icon so
+ * that the worker does not touch any state owned by the main thread.
+ * Requests are deduplicated: all scaled_icon_buffers which would show the
+ * same icon at the same scale (e.g. windows with the same app_id) wait for
+ * a single request.
+ */
+struct icon_request {
+	/* Input */
+	char *icon_name;
+	char *view_app_id;
+	char *view_icon_name;
+	bool view_icon_prefer_client;
+	struct lab_data_buffer *client_buffer; /* locked */
+	char *fallback_icon_name;
+	int width;
+	int height;
+	double scale;
+
+	/* Output */
+	struct lab_data_buffer *buffer;
+	bool done;
+
+	struct wl_list waiters; /* scaled_icon_buffer.request_link */
+	struct wl_list link; /* pending_requests */
+};
+
+static struct thread_pool *loader;
+static struct wl_list pending_requests = WL_LIST_INIT(&pending_requests);
+static struct wl_list all_icon_buffers = WL_LIST_INIT(&all_icon_buffers);
+static struct wl_listener on_desktop_entry_ready;
+
 static struct lab_data_buffer *
 choose_best_icon_buffer(struct scaled_icon_buffer *self, int icon_size, double scale)
 {
@@ -40,6 +81,10 @@ choose_best_icon_buffer(struct scaled_icon_buffer *self, int icon_size, double s
 			best_buffer = *buffer;
 		}
 	}
+	/* X11 icons are only converted once they are actually used */
+	if (best_buffer) {
+		buffer_premultiply(best_buffer);
+	}
 	return best_buffer;
 }
 
@@ -57,18 +102,19 @@ img_to_buffer(struct lab_img *img, int width, int height, double scale)
  * X11 apps can provide icon buffers via _NET_WM_ICON property.
  */
 static struct lab_data_buffer *
-load_client_icon(struct scaled_icon_buffer *self, int icon_size, double scale)
+load_client_icon(struct icon_request *req, int icon_size)
 {
-	struct lab_img *img = desktop_entry_load_icon(self->view_icon_name, icon_size, scale);
+	struct lab_img *img = desktop_entry_load_icon(req->view_icon_name,
+		icon_size, req->scale);
 	if (img) {
 		wlr_log(WLR_DEBUG, "loaded icon from client icon name");
-		return img_to_buffer(img, self->width, self->height, scale);
+		return img_to_buffer(img, req->width, req->height, req->scale);
 	}
 
-	struct lab_data_buffer *buffer = choose_best_icon_buffer(self, icon_size, scale);
-	if (buffer) {
+	if (req->client_buffer) {
 		wlr_log(WLR_DEBUG, "loaded icon from client buffer");
-		return buffer_resize(buffer, self->width, self->height, scale);
+		return buffer_resize(req->client_buffer, req->width,
+			req->height, req->scale);
 	}
 
 	return NULL;
@@ -80,67 +126,220 @@ load_client_icon(struct scaled_icon_buffer *self, int icon_size, double scale)
  * based on the icon theme specified in rc.xml.
  */
 static struct lab_data_buffer *
-load_server_icon(struct scaled_icon_buffer *self, int icon_size, double scale)
+load_server_icon(struct icon_request *req, int icon_size)
 {
 	struct lab_img *img = desktop_entry_load_icon_from_app_id(
-		self->view_app_id, icon_size, scale);
+		req->view_app_id, icon_size, req->scale);
 	if (img) {
 		wlr_log(WLR_DEBUG, "loaded icon by app_id");
-		return img_to_buffer(img, self->width, self->height, scale);
+		return img_to_buffer(img, req->width, req->height, req->scale);
 	}
 
 	return NULL;
 }
 
-#endif /* HAVE_LIBSFDO */
-
 static struct lab_data_buffer *
-_create_buffer(struct scaled_buffer *scaled_buffer, double scale)
+load_icon(struct icon_request *req)
 {
-#if HAVE_LIBSFDO
-	struct scaled_icon_buffer *self = scaled_buffer->data;
-	int icon_size = MIN(self->width, self->height);
+	int icon_size = MIN(req->width, req->height);
 	struct lab_img *img = NULL;
 	struct lab_data_buffer *buffer = NULL;
 
-	if (self->icon_name) {
+	if (req->icon_name) {
 		/* generic icon (e.g. menu icons) */
-		img = desktop_entry_load_icon(self->icon_name,
-			icon_size, scale);
+		img = desktop_entry_load_icon(req->icon_name,
+			icon_size, req->scale);
 		if (img) {
 			wlr_log(WLR_DEBUG, "loaded icon by icon name");
-			return img_to_buffer(img, self->width, self->height, scale);
+			return img_to_buffer(img, req->width, req->height,
+				req->scale);
 		}
 		return NULL;
 	}
 
 	/* window icon */
-	if (self->view_icon_prefer_client) {
-		buffer = load_client_icon(self, icon_size, scale);
+	if (req->view_icon_prefer_client) {
+		buffer = load_client_icon(req, icon_size);
 		if (buffer) {
 			return buffer;
 		}
-		buffer = load_server_icon(self, icon_size, scale);
+		buffer = load_server_icon(req, icon_size);
 		if (buffer) {
 			return buffer;
 		}
 	} else {
-		buffer = load_server_icon(self, icon_size, scale);
+		buffer = load_server_icon(req, icon_size);
 		if (buffer) {
 			return buffer;
 		}
-		buffer = load_client_icon(self, icon_size, scale);
+		buffer = load_client_icon(req, icon_size);
 		if (buffer) {
 			return buffer;
 		}
 	}
 	/* If both client and server icons are unavailable, use the fallback icon */
-	img = desktop_entry_load_icon(rc.fallback_app_icon_name,
-		icon_size, scale);
+	img = desktop_entry_load_icon(req->fallback_icon_name,
+		icon_size, req->scale);
 	if (img) {
 		wlr_log(WLR_DEBUG, "loaded fallback icon");
-		return img_to_buffer(img, self->width, self->height, scale);
+		return img_to_buffer(img, req->width, req->height, req->scale);
 	}
+	return NULL;
+}
+
+/* Runs on a worker thread */
+static void
+run_request(void *data)
+{
+	struct icon_request *req = data;
+	req->buffer = load_icon(req);
+}
+
+static void
+detach_request(struct scaled_icon_buffer *self)
+{
+	if (self->request) {
+		wl_list_remove(&self->request_link);
+		self->request = NULL;
+	}
+}
+
+static void
+destroy_request(struct icon_request *req)
+{
+	assert(wl_list_empty(&req->waiters));
+	if (req->client_buffer) {
+		wlr_buffer_unlock(&req->client_buffer->base);
+	}
+	/* Scaled buffers which took the buffer hold their own locks */
+	if (req->buffer && !req->buffer->base.dropped) {
+		wlr_buffer_drop(&req->buffer->base);
+	}
+	free(req->icon_name);
+	free(req->view_app_id);
+	free(req->view_icon_name);
+	free(req->fallback_icon_name);
+	free(req);
+}
+
+/* Runs on the main thread once run_request() has returned */
+static void
+handle_request_done(void *data)
+{
+	struct icon_request *req = data;
+	req->done = true;
+	wl_list_remove(&req->link);
+
+	/*
+	 * Re-rendering makes _create_buffer() pick up the result. It might
+	 * not be called if an equal scaled_icon_buffer which was updated
+	 * before already shares the buffer, so detach explicitly afterwards.
+	 */
+	struct scaled_icon_buffer *self, *tmp;
+	wl_list_for_each_safe(self, tmp, &req->waiters, request_link) {
+		scaled_buffer_request_update(self->scaled_buffer,
+			self->width, self->height);
+		if (self->request == req) {
+			detach_request(self);
+		}
+	}
+	destroy_request(req);
+}
+
+static bool
+request_matches(struct icon_request *req, struct icon_request *other)
+{
+	return str_equal(req->icon_name, other->icon_name)
+		&& str_equal(req->view_app_id, other->view_app_id)
+		&& str_equal(req->view_icon_name, other->view_icon_name)
+		&& req->view_icon_prefer_client == other->view_icon_prefer_client
+		&& req->client_buffer == other->client_buffer
+		&& str_equal(req->fallback_icon_name, other->fallback_icon_name)
+		&& req->width == other->width
+		&& req->height == other->height
+		&& req->scale == other->scale;
+}
+
+static void
+submit_request(struct scaled_icon_buffer *self, double scale)
+{
+	int icon_size = MIN(self->width, self->height);
+	struct icon_request key = {
+		.icon_name = self->icon_name,
+		.view_app_id = self->view_app_id,
+		.view_icon_name = self->view_icon_name,
+		.view_icon_prefer_client = self->view_icon_prefer_client,
+		.client_buffer = self->icon_name ? NULL
+			: choose_best_icon_buffer(self, icon_size, scale),
+		.fallback_icon_name = self->icon_name ? NULL
+			: rc.fallback_app_icon_name,
+		.width = self->width,
+		.height = self->height,
+		.scale = scale,
+	};
+
+	struct icon_request *req;
+	wl_list_for_each(req, &pending_requests, link) {
+		if (request_matches(req, &key)) {
+			goto wait;
+		}
+	}
+
+	req = znew(*req);
+	*req = key;
+	req->icon_name = key.icon_name ? xstrdup(key.icon_name) : NULL;
+	req->view_app_id = key.view_app_id ? xstrdup(key.view_app_id) : NULL;
+	req->view_icon_name =
+		key.view_icon_name ? xstrdup(key.view_icon_name) : NULL;
+	req->fallback_icon_name = key.fallback_icon_name
+		? xstrdup(key.fallback_icon_name) : NULL;
+	if (req->client_buffer) {
+		wlr_buffer_lock(&req->client_buffer->base);
+	}
+	wl_list_init(&req->waiters);
+	wl_list_insert(&pending_requests, &req->link);
+
+	if (!loader) {
+		loader = thread_pool_create(ICON_LOADER_THREADS,
+			server.wl_event_loop);
+	}
+	thread_pool_submit_async(loader, run_request, handle_request_done, req);
+wait:
+	self->request = req;
+	wl_list_insert(&req->waiters, &self->request_link);
+}
+
+/*
+ * Icons which were requested while the desktop entry database was still
+ * loading are empty, and a reloaded icon theme may provide other icons.
+ */
+static void
+handle_desktop_entry_ready(struct wl_listener *listener, void *data)
+{
+	struct scaled_icon_buffer *self;
+	wl_list_for_each(self, &all_icon_buffers, link) {
+		scaled_buffer_request_update(self->scaled_buffer,
+			self->width, self->height);
+	}
+}
+
+#endif /* HAVE_LIBSFDO */
+
+static struct lab_data_buffer *
+_create_buffer(struct scaled_buffer *scaled_buffer, double scale)
+{
+#if HAVE_LIBSFDO
+	struct scaled_icon_buffer *self = scaled_buffer->data;
+
+	/* Called from handle_request_done() */
+	struct icon_request *req = self->request;
+	if (req && req->done && req->scale == scale) {
+		detach_request(self);
+		return req->buffer;
+	}
+
+	detach_request(self);
+	submit_request(self, scale);
 #endif /* HAVE_LIBSFDO */
 	return NULL;
 }
@@ -175,6 +374,10 @@ _destroy(struct scaled_buffer *scaled_buffer)
 		wl_list_remove(&self->on_view.new_app_id.link);
 		wl_list_remove(&self->on_view.destroy.link);
 	}
+#if HAVE_LIBSFDO
+	detach_request(self);
+	wl_list_remove(&self->link);
+#endif
 	free(self->view_app_id);
 	free(self->view_icon_name);
 	set_icon_buffers(self, NULL);
@@ -229,6 +432,14 @@ scaled_icon_buffer_create(struct wlr_scene_tree *parent, int width, int height)
 
 	scaled_buffer->data = self;
 
+#if HAVE_LIBSFDO
+	if (!on_desktop_entry_ready.notify) {
+		on_desktop_entry_ready.notify = handle_desktop_entry_ready;
+		desktop_entry_add_ready_listener(&on_desktop_entry_ready);
+	}
+	wl_list_insert(&all_icon_buffers, &self->link);
+#endif
+
 	return self;
 }
 
@@ -2,17 +2,86 @@
 #define _POSIX_C_SOURCE 200809L
 #include "scaled-buffer/scaled-img-buffer.h"
 #include <assert.h>
+#include <wlr/types/wlr_buffer.h>
+#include "buffer.h"
 #include "common/mem.h"
 #include "img/img.h"
 #include "node.h"
 #include "scaled-buffer/scaled-buffer.h"
 
+/*
+ * Most images are theme images like window buttons, and several of them
+ * are shown in turn by the same node as a button is hovered or toggled.
+ * Keep recently rendered images so that those changes only swap buffers.
+ */
+#define RENDERED_IMG_CACHE_SIZE 256
+
+struct rendered_img {
+	struct lab_img *img;
+	int width;
+	int height;
+	double scale;
+	struct lab_data_buffer *buffer;
+	struct wl_list link; /* rendered_imgs */
+};
+
+/* Recently used in front */
+static struct wl_list rendered_imgs = WL_LIST_INIT(&rendered_imgs);
+static int nr_rendered_imgs;
+
+static void
+rendered_img_destroy(struct rendered_img *rendered)
+{
+	wl_list_remove(&rendered->link);
+	nr_rendered_imgs--;
+	lab_img_destroy(rendered->img);
+	wlr_buffer_unlock(&rendered->buffer->base);
+	free(rendered);
+}
+
 static struct lab_data_buffer *
 _create_buffer(struct scaled_buffer *scaled_buffer, double scale)
 {
 	struct scaled_img_buffer *self = scaled_buffer->data;
+
+	struct rendered_img *rendered;
+	wl_list_for_each(rendered, &rendered_imgs, link) {
+		if (rendered->width == self->width
+				&& rendered->height == self->height
+				&& rendered->scale == scale
+				&& lab_img_equal(rendered->img, self->img)) {
+			wl_list_remove(&rendered->link);
+			wl_list_insert(&rendered_imgs, &rendered->link);
+			return rendered->buffer;
+		}
+	}
+
 	struct lab_data_buffer *buffer = lab_img_render(self->img,
 		self->width, self->height, scale);
+	if (!buffer) {
+		return NULL;
+	}
+
+	/*
+	 * The cache holds a lock instead of owning the buffer, so that it
+	 * is freed once neither the cache nor any scaled_buffer uses it.
+	 */
+	wlr_buffer_lock(&buffer->base);
+	wlr_buffer_drop(&buffer->base);
+
+	if (nr_rendered_imgs == RENDERED_IMG_CACHE_SIZE) {
+		rendered_img_destroy(wl_container_of(rendered_imgs.prev,
+			rendered, link));
+	}
+	rendered = znew(*rendered);
+	rendered->img = lab_img_copy(self->img);
+	rendered->width = self->width;
+	rendered->height = self->height;
+	rendered->scale = scale;
+	rendered->buffer = buffer;
+	wl_list_insert(&rendered_imgs, &rendered->link);
+	nr_rendered_imgs++;
+
 	return buffer;
 }
 
@@ -65,3 +134,28 @@ scaled_img_buffer_create(struct wlr_scene_tree *parent, struct lab_img *img,
 
 	return self;
 }
+
+void
+scaled_img_buffer_update(struct scaled_img_buffer *self, struct lab_img *img)
+{
+	assert(self);
+	assert(img);
+
+	if (lab_img_equal(self->img, img)) {
+		return;
+	}
+	lab_img_destroy(self->img);
+	self->img = lab_img_copy(img);
+
+	scaled_buffer_request_update(self->scaled_buffer,
+		self->width, self->height);
+}
+
+void
+scaled_img_buffer_clear_cache(void)
+{
+	struct rendered_img *rendered, *tmp;
+	wl_list_for_each_safe(rendered, tmp, &rendered_imgs, link) {
+		rendered_img_destroy(rendered);
+	}
+}
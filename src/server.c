@@ -55,7 +55,11 @@
 #include "common/macros.h"
 #include "common/mem.h"
 #include "common/nag.h"
+#include "common/buf.h"
 #include "common/scene-helpers.h"
+#include "common/thread-pool.h"
+#include "common/time.h"
+#include "config/keybind.h"
 #include "config/rcxml.h"
 #include "config/session.h"
 #include "decorations.h"
@@ -73,7 +77,9 @@
 #include "scaled-buffer/scaled-buffer.h"
 #include "session-lock.h"
 #include "ssd.h"
+#include "startup-timeline.h"
 #include "theme.h"
+#include "toplevel-capture.h"
 #include "view.h"
 #include "workspaces.h"
 #include "xwayland.h"
@@ -85,9 +91,81 @@
 #define LAB_WLR_LINUX_DMABUF_VERSION 4
 #define LAB_WLR_PRESENTATION_TIME_VERSION 2
 
+static const char *const config_domain_names[CONFIG_DOMAIN_COUNT] = {
+	[CONFIG_DOMAIN_CORE] = "core",
+	[CONFIG_DOMAIN_THEME] = "theme",
+	[CONFIG_DOMAIN_FONTS] = "fonts",
+	[CONFIG_DOMAIN_ICON_THEME] = "icon-theme",
+	[CONFIG_DOMAIN_KEYBINDS] = "keybinds",
+	[CONFIG_DOMAIN_MOUSEBINDS] = "mousebinds",
+	[CONFIG_DOMAIN_INPUT] = "input",
+	[CONFIG_DOMAIN_WINDOW_RULES] = "window-rules",
+	[CONFIG_DOMAIN_REGIONS] = "regions",
+	[CONFIG_DOMAIN_WORKSPACES] = "workspaces",
+	[CONFIG_DOMAIN_MENUS] = "menus",
+};
+
+#define DOMAIN(d) (1u << CONFIG_DOMAIN_##d)
+
+/*
+ * rc.xml is read and parsed on a worker thread when SIGHUP is received so
+ * that slow storage or a large config does not hold up frames. Only one
+ * reload is in flight at a time; further requests are coalesced.
+ */
+static struct {
+	struct thread_pool *pool;
+	bool busy;
+	bool pending;
+	bool finishing;
+} reloader;
+
+struct reload_job {
+	/* Copied from rc on the main thread, which owns it */
+	char *config_file;
+	bool merge_config;
+	struct rcxml_source *source;
+	double parse_ms;
+};
+
+/* Logs the time elapsed since @start and returns the current time */
+static double
+log_phase(const char *phase, double start)
+{
+	double now = get_time_ms();
+	wlr_log(WLR_INFO, "reconfigure: %s took %.1f ms", phase, now - start);
+	return now;
+}
+
+static void
+log_changed_domains(unsigned int changed)
+{
+	struct buf names = BUF_INIT;
+	for (int i = 0; i < CONFIG_DOMAIN_COUNT; i++) {
+		if (changed & (1u << i)) {
+			buf_add_fmt(&names, " %s", config_domain_names[i]);
+		}
+	}
+	wlr_log(WLR_INFO, "reconfigure: changed:%s", names.len ? names.data : " none");
+	buf_reset(&names);
+}
+
+/*
+ * rc.xml is always read again, but subsystems are only reloaded if the
+ * fingerprint of a config domain they depend on has changed. For example,
+ * editing a keybind does not re-render the decorations of all windows.
+ *
+ * @source holds rc.xml already parsed by rcxml_source_load(). If NULL, it
+ * is read synchronously.
+ *
+ * @reload_all reloads every subsystem regardless of fingerprints, which is
+ * needed to recreate all buffers and textures for a new renderer.
+ */
 static void
-reload_config_and_theme(void)
+reload_config_and_theme(struct rcxml_source *source, bool reload_all)
 {
+	double start_ms = get_time_ms();
+	double phase_ms = start_ms;
+
 	/* Avoid UAF when dialog client is used during reconfigure */
 	action_prompts_destroy();
 
@@ -97,41 +175,160 @@ reload_config_and_theme(void)
 	 */
 	desktop_cancel_pending_auto_raise();
 
-	scaled_buffer_invalidate_sharing();
+	uint64_t fingerprints[CONFIG_DOMAIN_COUNT];
+	memcpy(fingerprints, rc.fingerprints, sizeof(fingerprints));
+
 	rcxml_finish();
 	nag_reset();
-	rcxml_read(rc.config_file);
-	theme_finish(rc.theme);
-	theme_init(rc.theme, rc.theme_name);
+	if (source) {
+		rcxml_read_source(source);
+	} else {
+		rcxml_read(rc.config_file);
+	}
+	phase_ms = log_phase("rc.xml", phase_ms);
+
+	unsigned int changed = 0;
+	for (int i = 0; i < CONFIG_DOMAIN_COUNT; i++) {
+		if (reload_all || fingerprints[i] != rc.fingerprints[i]) {
+			changed |= 1u << i;
+		}
+	}
+	log_changed_domains(changed);
+
+	/* Decorations also depend on <core><gap> and <resize> settings */
+	bool theme_changed = changed & (DOMAIN(THEME) | DOMAIN(FONTS));
+	bool ssd_changed = theme_changed || (changed & DOMAIN(CORE));
+
+	if (theme_changed) {
+		scaled_buffer_invalidate_sharing();
+		theme_finish(rc.theme);
+		theme_init(rc.theme, rc.theme_name);
+		phase_ms = log_phase("theme", phase_ms);
+	}
 
 #if HAVE_LIBSFDO
-	desktop_entry_finish();
-	desktop_entry_init();
+	/* Only reloads if the icon theme or data dirs have changed */
+	desktop_entry_reconfigure();
 #endif
 
-	struct view *view;
-	wl_list_for_each(view, &server.views, link) {
-		view_reload_ssd(view);
+	if (ssd_changed) {
+		struct view *view;
+		wl_list_for_each(view, &server.views, link) {
+			view_reload_ssd(view);
+		}
+		resize_indicator_reconfigure();
+		phase_ms = log_phase("decorations", phase_ms);
 	}
 
 	cycle_finish(/*switch_focus*/ false);
-	menu_reconfigure();
-	seat_reconfigure();
-	regions_reconfigure();
-	resize_indicator_reconfigure();
+
+	/* The client-menu depends on the number of workspaces */
+	if (changed & (DOMAIN(MENUS) | DOMAIN(THEME) | DOMAIN(FONTS)
+			| DOMAIN(ICON_THEME) | DOMAIN(WORKSPACES))) {
+		menu_reconfigure();
+		phase_ms = log_phase("menus", phase_ms);
+	}
+
+	/* Snap overlays use theme colors and <snapping> settings */
+	if (changed & (DOMAIN(INPUT) | DOMAIN(THEME) | DOMAIN(CORE))) {
+		seat_reconfigure();
+		phase_ms = log_phase("seat", phase_ms);
+	} else {
+		/*
+		 * Keybinds are always freed by rcxml_finish(), so the new
+		 * ones need their keycodes for layout-independent matching.
+		 */
+		keyboard_reset_current_keybind();
+		keybind_update_keycodes();
+	}
+
+	if (changed & DOMAIN(REGIONS)) {
+		regions_reconfigure();
+		phase_ms = log_phase("regions", phase_ms);
+	}
 	kde_server_decoration_update_default();
-	workspaces_reconfigure();
+	/* The workspace OSD also uses theme colors and the OSD font */
+	if (changed & (DOMAIN(WORKSPACES) | DOMAIN(THEME) | DOMAIN(FONTS))) {
+		workspaces_reconfigure();
+		phase_ms = log_phase("workspaces", phase_ms);
+	}
 
+	wlr_log(WLR_INFO, "reconfigure: done in %.1f ms", get_time_ms() - start_ms);
 	wl_event_loop_add_idle(server.wl_event_loop, nag_show_callback, NULL);
 }
 
-static int
-handle_sighup(int signal, void *data)
+/* Runs on a worker thread */
+static void
+run_reload_job(void *data)
+{
+	struct reload_job *job = data;
+	double start_ms = get_time_ms();
+	job->source = rcxml_source_load(job->config_file, job->merge_config);
+	job->parse_ms = get_time_ms() - start_ms;
+}
+
+static void submit_reload(void);
+
+static void
+handle_reload_job_done(void *data)
 {
+	struct reload_job *job = data;
+	reloader.busy = false;
+	if (reloader.finishing) {
+		goto out;
+	}
+	if (reloader.pending) {
+		/* Files may have changed since, so there is no point applying this */
+		reloader.pending = false;
+		submit_reload();
+		goto out;
+	}
+
+	const char *error = rcxml_source_get_error(job->source);
+	if (error) {
+		/* Keep running with the current config rather than the defaults */
+		nag_reset();
+		nag_log(WLR_ERROR, "config not reloaded: error parsing %s "
+			"(read in %.1f ms)", error, job->parse_ms);
+		wl_event_loop_add_idle(server.wl_event_loop, nag_show_callback, NULL);
+		goto out;
+	}
+
+	wlr_log(WLR_INFO, "reconfigure: rc.xml read in %.1f ms off the main thread",
+		job->parse_ms);
 	keyboard_cancel_all_keybind_repeats(&server.seat);
-	session_environment_init();
-	reload_config_and_theme();
+	reload_config_and_theme(job->source, /* reload_all */ false);
 	output_virtual_update_fallback();
+out:
+	rcxml_source_destroy(job->source);
+	free(job->config_file);
+	free(job);
+}
+
+static void
+submit_reload(void)
+{
+	if (!reloader.pool) {
+		reloader.pool = thread_pool_create(1, server.wl_event_loop);
+	}
+	/* The worker reads the XDG Base Dir variables, so set them up first */
+	session_environment_init();
+	reloader.busy = true;
+	struct reload_job *job = znew(*job);
+	job->config_file = rc.config_file ? xstrdup(rc.config_file) : NULL;
+	job->merge_config = rc.merge_config;
+	thread_pool_submit_async(reloader.pool, run_reload_job,
+		handle_reload_job_done, job);
+}
+
+static int
+handle_sighup(int signal, void *data)
+{
+	if (reloader.busy) {
+		reloader.pending = true;
+		return 0;
+	}
+	submit_reload();
 	return 0;
 }
 
@@ -195,7 +392,8 @@ handle_sigchld(int signal, void *data)
 		switch (info.si_code) {
 		case CLD_EXITED:
 			if (!action_check_prompt_result(info.si_pid, info.si_status)
-					&& !nag_check_pid(info.si_pid)) {
+					&& !nag_check_pid(info.si_pid)
+					&& !session_check_pid(info.si_pid, info.si_status)) {
 				wlr_log(info.si_status == 0 ? WLR_DEBUG : WLR_ERROR,
 					"spawned child %ld exited with %d",
 					(long)info.si_pid, info.si_status);
@@ -211,6 +409,7 @@ handle_sigchld(int signal, void *data)
 			/* Allow cleanup of killed prompt */
 			action_check_prompt_result(info.si_pid, -info.si_status);
 			nag_check_pid(info.si_pid);
+			session_check_pid(info.si_pid, -info.si_status);
 			break;
 		default:
 			wlr_log(WLR_ERROR,
@@ -435,7 +634,7 @@ handle_renderer_lost(struct wl_listener *listener, void *data)
 			server.allocator, server.renderer);
 	}
 
-	reload_config_and_theme();
+	reload_config_and_theme(NULL, /* reload_all */ true);
 
 	magnifier_reset();
 
@@ -443,38 +642,20 @@ handle_renderer_lost(struct wl_listener *listener, void *data)
 	wlr_renderer_destroy(old_renderer);
 }
 
-static void
-handle_toplevel_capture_source_destroy(struct wl_listener *listener, void *data)
-{
-	struct view *view = wl_container_of(listener, view, capture.on_capture_source_destroy);
-	assert(view->capture.source);
-	view->capture.source = NULL;
-	wl_list_remove(&listener->link);
-	wl_list_init(&listener->link);
-}
+#if HAVE_LIBSFDO
+static struct wl_listener on_desktop_entry_ready;
 
+/*
+ * Icons refresh themselves (see scaled-icon-buffer.c), but application
+ * names shown by an open window switcher were looked up before the
+ * database had been loaded or from the previous one.
+ */
 static void
-handle_toplevel_capture_request(struct wl_listener *listener, void *data)
+handle_desktop_entry_ready(struct wl_listener *listener, void *data)
 {
-	struct wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request *request = data;
-	struct view *view = request->toplevel_handle->data;
-	assert(view);
-	wlr_log(WLR_INFO, "Capturing toplevel %s", view->app_id);
-
-	if (!view->capture.source) {
-		view->capture.source = wlr_ext_image_capture_source_v1_create_with_scene_node(
-			&view->capture.scene->tree.node, server.wl_event_loop,
-			server.allocator, server.renderer);
-		assert(view->capture.source);
-
-		view->capture.on_capture_source_destroy.notify =
-			handle_toplevel_capture_source_destroy;
-		wl_signal_add(&view->capture.source->events.destroy,
-			&view->capture.on_capture_source_destroy);
-	}
-	wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request_accept(
-		request, view->capture.source);
+	cycle_reinitialize();
 }
+#endif
 
 void
 server_init(void)
@@ -526,6 +707,7 @@ server_init(void)
 		fprintf(stderr, helpful_seat_error_message);
 		exit(EXIT_FAILURE);
 	}
+	startup_timeline_mark("backend");
 
 	/* Create headless backend to enable adding virtual outputs later on */
 	wlr_multi_for_each_backend(server.backend,
@@ -604,6 +786,7 @@ server_init(void)
 		wlr_log(WLR_ERROR, "unable to create allocator");
 		exit(EXIT_FAILURE);
 	}
+	startup_timeline_mark("renderer");
 
 	wl_list_init(&server.views);
 	wl_list_init(&server.unmanaged_surfaces);
@@ -756,17 +939,7 @@ server_init(void)
 	wlr_ext_image_copy_capture_manager_v1_create(server.wl_display, 1);
 	wlr_ext_output_image_capture_source_manager_v1_create(server.wl_display, 1);
 
-	server.toplevel_capture.manager =
-		wlr_ext_foreign_toplevel_image_capture_source_manager_v1_create(
-			server.wl_display, 1);
-	if (server.toplevel_capture.manager) {
-		server.toplevel_capture.on.new_request.notify = handle_toplevel_capture_request;
-		wl_signal_add(&server.toplevel_capture.manager->events.new_request,
-			&server.toplevel_capture.on.new_request);
-	} else {
-		/* Allow safe removal on shutdown */
-		wl_list_init(&server.toplevel_capture.on.new_request.link);
-	}
+	toplevel_capture_init();
 
 	wlr_data_control_manager_v1_create(server.wl_display);
 	wlr_ext_data_control_manager_v1_create(server.wl_display,
@@ -834,12 +1007,18 @@ server_init(void)
 	wlr_xdg_foreign_v1_create(server.wl_display, registry);
 	wlr_xdg_foreign_v2_create(server.wl_display, registry);
 
+	startup_timeline_mark("globals");
+
 #if HAVE_LIBSFDO
 	desktop_entry_init();
+	on_desktop_entry_ready.notify = handle_desktop_entry_ready;
+	desktop_entry_add_ready_listener(&on_desktop_entry_ready);
+	startup_timeline_mark("desktop entries");
 #endif
 
 #if HAVE_XWAYLAND
 	xwayland_server_init(server.compositor);
+	startup_timeline_mark("xwayland");
 #endif
 	wl_event_loop_add_idle(server.wl_event_loop, nag_show_callback, NULL);
 }
@@ -876,10 +1055,15 @@ server_start(void)
 void
 server_finish(void)
 {
+	reloader.finishing = true;
+	thread_pool_destroy(reloader.pool);
+	reloader.pool = NULL;
+
 #if HAVE_XWAYLAND
 	xwayland_server_finish();
 #endif
 #if HAVE_LIBSFDO
+	wl_list_remove(&on_desktop_entry_ready.link);
 	desktop_entry_finish();
 #endif
 	wl_event_source_remove(server.sighup_source);
@@ -904,7 +1088,7 @@ server_finish(void)
 		server.drm_lease_request.notify = NULL;
 	}
 
-	wl_list_remove(&server.toplevel_capture.on.new_request.link);
+	toplevel_capture_finish();
 
 	wlr_backend_destroy(server.backend);
 	wlr_allocator_destroy(server.allocator);
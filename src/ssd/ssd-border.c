@@ -26,34 +26,29 @@ ssd_border_create(struct ssd *ssd)
 	ssd->border.tree = lab_wlr_scene_tree_create(ssd->tree);
 	wlr_scene_node_set_position(&ssd->border.tree->node, -theme->border_width, 0);
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_border_subtree *subtree = &ssd->border.subtrees[active];
-		subtree->tree = lab_wlr_scene_tree_create(ssd->border.tree);
-		struct wlr_scene_tree *parent = subtree->tree;
-		wlr_scene_node_set_enabled(&parent->node, active);
-		float *color = theme->window[active].border_color;
-
-		subtree->left = lab_wlr_scene_rect_create(parent,
-			theme->border_width, height, color);
-		wlr_scene_node_set_position(&subtree->left->node, 0, 0);
-
-		subtree->right = lab_wlr_scene_rect_create(parent,
-			theme->border_width, height, color);
-		wlr_scene_node_set_position(&subtree->right->node,
-			theme->border_width + width, 0);
-
-		subtree->bottom = lab_wlr_scene_rect_create(parent,
-			full_width, theme->border_width, color);
-		wlr_scene_node_set_position(&subtree->bottom->node,
-			0, height);
-
-		subtree->top = lab_wlr_scene_rect_create(parent,
-			MAX(width - 2 * corner_width, 0), theme->border_width, color);
-		wlr_scene_node_set_position(&subtree->top->node,
-			theme->border_width + corner_width,
-			-(ssd->titlebar.height + theme->border_width));
-	}
+	struct wlr_scene_tree *parent = ssd->border.tree;
+	float *color = theme->window[ssd->state.active].border_color;
+
+	ssd->border.left = lab_wlr_scene_rect_create(parent,
+		theme->border_width, height, color);
+	wlr_scene_node_set_position(&ssd->border.left->node, 0, 0);
+
+	ssd->border.right = lab_wlr_scene_rect_create(parent,
+		theme->border_width, height, color);
+	wlr_scene_node_set_position(&ssd->border.right->node,
+		theme->border_width + width, 0);
+
+	ssd->border.bottom = lab_wlr_scene_rect_create(parent,
+		full_width, theme->border_width, color);
+	wlr_scene_node_set_position(&ssd->border.bottom->node,
+		0, height);
+
+	ssd->border.top = lab_wlr_scene_rect_create(parent,
+		MAX(width - 2 * corner_width, 0), theme->border_width, color);
+	wlr_scene_node_set_position(&ssd->border.top->node,
+		theme->border_width + corner_width,
+		-(ssd->titlebar.height + theme->border_width));
+	ssd_border_update_color(ssd);
 
 	if (view->maximized == VIEW_AXIS_BOTH) {
 		wlr_scene_node_set_enabled(&ssd->border.tree->node, false);
@@ -129,30 +124,48 @@ ssd_border_update(struct ssd *ssd)
 		? 0
 		: theme->border_width + corner_width;
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_border_subtree *subtree = &ssd->border.subtrees[active];
-
-		wlr_scene_rect_set_size(subtree->left,
-			theme->border_width, side_height);
-		wlr_scene_node_set_position(&subtree->left->node,
-			0, side_y);
-
-		wlr_scene_rect_set_size(subtree->right,
-			theme->border_width, side_height);
-		wlr_scene_node_set_position(&subtree->right->node,
-			theme->border_width + width, side_y);
-
-		wlr_scene_rect_set_size(subtree->bottom,
-			full_width, theme->border_width);
-		wlr_scene_node_set_position(&subtree->bottom->node,
-			0, height);
-
-		wlr_scene_rect_set_size(subtree->top,
-			top_width, theme->border_width);
-		wlr_scene_node_set_position(&subtree->top->node,
-			top_x, -(ssd->titlebar.height + theme->border_width));
-	}
+	wlr_scene_rect_set_size(ssd->border.left,
+		theme->border_width, side_height);
+	wlr_scene_node_set_position(&ssd->border.left->node,
+		0, side_y);
+
+	wlr_scene_rect_set_size(ssd->border.right,
+		theme->border_width, side_height);
+	wlr_scene_node_set_position(&ssd->border.right->node,
+		theme->border_width + width, side_y);
+
+	wlr_scene_rect_set_size(ssd->border.bottom,
+		full_width, theme->border_width);
+	wlr_scene_node_set_position(&ssd->border.bottom->node,
+		0, height);
+
+	wlr_scene_rect_set_size(ssd->border.top,
+		top_width, theme->border_width);
+	wlr_scene_node_set_position(&ssd->border.top->node,
+		top_x, -(ssd->titlebar.height + theme->border_width));
+}
+
+/*
+ * Apply the border color of ssd->state.active. The top border of the
+ * active window doubles as keybind-inhibit indicator.
+ */
+void
+ssd_border_update_color(struct ssd *ssd)
+{
+	assert(ssd);
+	assert(ssd->border.tree);
+
+	struct theme *theme = rc.theme;
+	enum ssd_active_state active = ssd->state.active;
+	float *color = theme->window[active].border_color;
+	float *top_color = active && ssd->state.keybind_inhibit_indicator
+		? theme->window_toggled_keybinds_color
+		: color;
+
+	wlr_scene_rect_set_color(ssd->border.top, top_color);
+	wlr_scene_rect_set_color(ssd->border.bottom, color);
+	wlr_scene_rect_set_color(ssd->border.left, color);
+	wlr_scene_rect_set_color(ssd->border.right, color);
 }
 
 void
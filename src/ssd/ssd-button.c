@@ -58,27 +58,61 @@ attach_ssd_button(struct wl_list *button_parts, enum lab_node_type type,
 		wlr_scene_node_set_position(icon_node, icon_padding, 0);
 		button->window_icon = icon_buffer;
 	} else {
-		for (uint8_t state_set = LAB_BS_DEFAULT;
-				state_set <= LAB_BS_ALL; state_set++) {
-			if (!imgs[state_set]) {
-				continue;
-			}
-			struct scaled_img_buffer *img_buffer = scaled_img_buffer_create(
-				root, imgs[state_set], rc.theme->window_button_width,
-				rc.theme->window_button_height);
-			assert(img_buffer);
-			struct wlr_scene_node *icon_node = &img_buffer->scene_buffer->node;
-			wlr_scene_node_set_enabled(icon_node, false);
-			button->img_buffers[state_set] = img_buffer;
-		}
 		/* Initially show non-hover, non-toggled, unrounded variant */
-		wlr_scene_node_set_enabled(
-			&button->img_buffers[LAB_BS_DEFAULT]->scene_buffer->node, true);
+		assert(imgs[LAB_BS_DEFAULT]);
+		button->imgs = imgs;
+		button->img_buffer = scaled_img_buffer_create(root,
+			imgs[LAB_BS_DEFAULT], rc.theme->window_button_width,
+			rc.theme->window_button_height);
+		assert(button->img_buffer);
 	}
 
 	return button;
 }
 
+/* Show the image for the current combination of hover/toggled/rounded states */
+static void
+update_img(struct ssd_button *button)
+{
+	if (!button->img_buffer) {
+		return;
+	}
+	struct lab_img *img = button->imgs[button->state_set];
+	struct wlr_scene_node *node = &button->img_buffer->scene_buffer->node;
+	wlr_scene_node_set_enabled(node, (bool)img);
+	if (img) {
+		scaled_img_buffer_update(button->img_buffer, img);
+	}
+}
+
+void
+ssd_button_set_imgs(struct ssd_button *button,
+		struct lab_img *imgs[LAB_BS_ALL + 1])
+{
+	if (button->imgs == imgs) {
+		return;
+	}
+	button->imgs = imgs;
+	update_img(button);
+}
+
+void
+ssd_button_update_state(struct ssd_button *button,
+		enum lab_button_state state, bool enable)
+{
+	uint8_t state_set = button->state_set;
+	if (enable) {
+		state_set |= state;
+	} else {
+		state_set &= ~state;
+	}
+	if (state_set == button->state_set) {
+		return;
+	}
+	button->state_set = state_set;
+	update_img(button);
+}
+
 /* called from node descriptor destroy */
 void ssd_button_free(struct ssd_button *button)
 {
@@ -47,7 +47,7 @@ corner_scale_crop(struct wlr_scene_buffer *buffer, int horizontal_overlap,
  * drop-shadow.
  */
 static void
-set_shadow_parts_geometry(struct ssd_shadow_subtree *subtree,
+set_shadow_parts_geometry(struct ssd_shadow_scene *shadow,
 		int width, int height, int titlebar_height, int corner_size,
 		int inset, int visible_shadow_width)
 {
@@ -90,55 +90,55 @@ set_shadow_parts_geometry(struct ssd_shadow_subtree *subtree,
 
 	x = width - inset + horizontal_overlap_downsized;
 	y = -titlebar_height + height - inset + vertical_overlap_downsized;
-	wlr_scene_node_set_position(&subtree->bottom_right->node, x, y);
-	corner_scale_crop(subtree->bottom_right, horizontal_overlap_downsized,
+	wlr_scene_node_set_position(&shadow->bottom_right->node, x, y);
+	corner_scale_crop(shadow->bottom_right, horizontal_overlap_downsized,
 		vertical_overlap_downsized, corner_size);
 
 	x = -visible_shadow_width;
 	y = -titlebar_height + height - inset + vertical_overlap;
-	wlr_scene_node_set_position(&subtree->bottom_left->node, x, y);
-	corner_scale_crop(subtree->bottom_left, horizontal_overlap,
+	wlr_scene_node_set_position(&shadow->bottom_left->node, x, y);
+	corner_scale_crop(shadow->bottom_left, horizontal_overlap,
 		vertical_overlap, corner_size);
 
 	x = -visible_shadow_width;
 	y = -titlebar_height - visible_shadow_width;
-	wlr_scene_node_set_position(&subtree->top_left->node, x, y);
-	corner_scale_crop(subtree->top_left, horizontal_overlap_downsized,
+	wlr_scene_node_set_position(&shadow->top_left->node, x, y);
+	corner_scale_crop(shadow->top_left, horizontal_overlap_downsized,
 		vertical_overlap_downsized, corner_size);
 
 	x = width - inset + horizontal_overlap;
 	y = -titlebar_height - visible_shadow_width;
-	wlr_scene_node_set_position(&subtree->top_right->node, x, y);
-	corner_scale_crop(subtree->top_right, horizontal_overlap,
+	wlr_scene_node_set_position(&shadow->top_right->node, x, y);
+	corner_scale_crop(shadow->top_right, horizontal_overlap,
 		vertical_overlap, corner_size);
 
 	x = width;
 	y = -titlebar_height + inset;
-	wlr_scene_node_set_position(&subtree->right->node, x, y);
-	wlr_scene_buffer_set_dest_size(subtree->right,
+	wlr_scene_node_set_position(&shadow->right->node, x, y);
+	wlr_scene_buffer_set_dest_size(shadow->right,
 		visible_shadow_width, MAX(height - 2 * inset, 0));
-	wlr_scene_node_set_enabled(&subtree->right->node, show_sides);
+	wlr_scene_node_set_enabled(&shadow->right->node, show_sides);
 
 	x = inset;
 	y = -titlebar_height + height;
-	wlr_scene_node_set_position(&subtree->bottom->node, x, y);
-	wlr_scene_buffer_set_dest_size(subtree->bottom,
+	wlr_scene_node_set_position(&shadow->bottom->node, x, y);
+	wlr_scene_buffer_set_dest_size(shadow->bottom,
 		MAX(width - 2 * inset, 0), visible_shadow_width);
-	wlr_scene_node_set_enabled(&subtree->bottom->node, show_topbottom);
+	wlr_scene_node_set_enabled(&shadow->bottom->node, show_topbottom);
 
 	x = -visible_shadow_width;
 	y = -titlebar_height + inset;
-	wlr_scene_node_set_position(&subtree->left->node, x, y);
-	wlr_scene_buffer_set_dest_size(subtree->left,
+	wlr_scene_node_set_position(&shadow->left->node, x, y);
+	wlr_scene_buffer_set_dest_size(shadow->left,
 		visible_shadow_width, MAX(height - 2 * inset, 0));
-	wlr_scene_node_set_enabled(&subtree->left->node, show_sides);
+	wlr_scene_node_set_enabled(&shadow->left->node, show_sides);
 
 	x = inset;
 	y = -titlebar_height - visible_shadow_width;
-	wlr_scene_node_set_position(&subtree->top->node, x, y);
-	wlr_scene_buffer_set_dest_size(subtree->top,
+	wlr_scene_node_set_position(&shadow->top->node, x, y);
+	wlr_scene_buffer_set_dest_size(shadow->top,
 		MAX(width - 2 * inset, 0), visible_shadow_width);
-	wlr_scene_node_set_enabled(&subtree->top->node, show_topbottom);
+	wlr_scene_node_set_enabled(&shadow->top->node, show_topbottom);
 }
 
 static void
@@ -150,41 +150,33 @@ set_shadow_geometry(struct ssd *ssd)
 	int width = view->current.width;
 	int height = view_effective_height(view, false) + titlebar_height;
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_shadow_subtree *subtree = &ssd->shadow.subtrees[active];
-		if (!subtree->tree) {
-			/* Looks like this type of shadow is disabled */
-			continue;
-		}
+	enum ssd_active_state active = ssd->state.active;
 
-		int visible_shadow_width = theme->window[active].shadow_size;
-		/* inset as a proportion of shadow width */
-		double inset_proportion = SSD_SHADOW_INSET;
-		/* inset in actual pixels */
-		int inset = inset_proportion * (double)visible_shadow_width;
-
-		/*
-		 * Total size of corner buffers including inset and visible
-		 * portion.  Top and bottom are the same size (only the cutout
-		 * is different).  The buffers are square so width == height.
-		 */
-		int corner_size =
-			theme->window[active].shadow_corner_top->logical_height;
-
-		set_shadow_parts_geometry(subtree, width, height,
-			titlebar_height, corner_size, inset,
-			visible_shadow_width);
-	}
+	int visible_shadow_width = theme->window[active].shadow_size;
+	/* inset as a proportion of shadow width */
+	double inset_proportion = SSD_SHADOW_INSET;
+	/* inset in actual pixels */
+	int inset = inset_proportion * (double)visible_shadow_width;
+
+	/*
+	 * Total size of corner buffers including inset and visible
+	 * portion.  Top and bottom are the same size (only the cutout
+	 * is different).  The buffers are square so width == height.
+	 */
+	int corner_size =
+		theme->window[active].shadow_corner_top->logical_height;
+
+	set_shadow_parts_geometry(&ssd->shadow, width, height,
+		titlebar_height, corner_size, inset,
+		visible_shadow_width);
 }
 
 static struct wlr_scene_buffer *
-make_shadow(struct view *view,
-	struct wlr_scene_tree *parent, struct wlr_buffer *buf,
+make_shadow(struct view *view, struct wlr_scene_tree *parent,
 	enum wl_output_transform tx)
 {
 	struct wlr_scene_buffer *scene_buf =
-		lab_wlr_scene_buffer_create(parent, buf);
+		lab_wlr_scene_buffer_create(parent, NULL);
 	wlr_scene_buffer_set_transform(scene_buf, tx);
 	scene_buf->point_accepts_input = never_accepts_input;
 	/*
@@ -195,6 +187,32 @@ make_shadow(struct view *view,
 	return scene_buf;
 }
 
+static void
+create_shadow_parts(struct ssd *ssd)
+{
+	struct view *view = ssd->view;
+	struct wlr_scene_tree *parent = ssd->shadow.tree;
+	struct ssd_shadow_scene *shadow = &ssd->shadow;
+
+	/* The buffers are set in ssd_shadow_set_active() */
+	shadow->bottom_right = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_NORMAL);
+	shadow->bottom_left = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_FLIPPED);
+	shadow->top_left = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_180);
+	shadow->top_right = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_FLIPPED_180);
+	shadow->right = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_NORMAL);
+	shadow->bottom = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_90);
+	shadow->left = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_180);
+	shadow->top = make_shadow(view, parent,
+		WL_OUTPUT_TRANSFORM_270);
+}
+
 void
 ssd_shadow_create(struct ssd *ssd)
 {
@@ -204,46 +222,15 @@ ssd_shadow_create(struct ssd *ssd)
 	ssd->shadow.tree = lab_wlr_scene_tree_create(ssd->tree);
 
 	struct theme *theme = rc.theme;
-	struct view *view = ssd->view;
-
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_shadow_subtree *subtree = &ssd->shadow.subtrees[active];
-
-		if (!rc.shadows_enabled) {
-			/* Shadows are globally disabled */
-			continue;
-		}
-		if (theme->window[active].shadow_size == 0) {
-			/* Window shadows are disabled */
-			continue;
-		}
 
-		subtree->tree = lab_wlr_scene_tree_create(ssd->shadow.tree);
-		struct wlr_scene_tree *parent = subtree->tree;
-		struct wlr_buffer *corner_top_buffer =
-			&theme->window[active].shadow_corner_top->base;
-		struct wlr_buffer *corner_bottom_buffer =
-			&theme->window[active].shadow_corner_bottom->base;
-		struct wlr_buffer *edge_buffer =
-			&theme->window[active].shadow_edge->base;
-
-		subtree->bottom_right = make_shadow(view, parent,
-			corner_bottom_buffer, WL_OUTPUT_TRANSFORM_NORMAL);
-		subtree->bottom_left = make_shadow(view, parent,
-			corner_bottom_buffer, WL_OUTPUT_TRANSFORM_FLIPPED);
-		subtree->top_left = make_shadow(view, parent,
-			corner_top_buffer, WL_OUTPUT_TRANSFORM_180);
-		subtree->top_right = make_shadow(view, parent,
-			corner_top_buffer, WL_OUTPUT_TRANSFORM_FLIPPED_180);
-		subtree->right = make_shadow(view, parent,
-			edge_buffer, WL_OUTPUT_TRANSFORM_NORMAL);
-		subtree->bottom = make_shadow(view, parent,
-			edge_buffer, WL_OUTPUT_TRANSFORM_90);
-		subtree->left = make_shadow(view, parent,
-			edge_buffer, WL_OUTPUT_TRANSFORM_180);
-		subtree->top = make_shadow(view, parent,
-			edge_buffer, WL_OUTPUT_TRANSFORM_270);
+	/*
+	 * Skip the shadow parts entirely if shadows are globally disabled
+	 * or if the theme disables them for both active states.
+	 */
+	if (rc.shadows_enabled && (theme->window[SSD_ACTIVE].shadow_size > 0
+			|| theme->window[SSD_INACTIVE].shadow_size > 0)) {
+		create_shadow_parts(ssd);
+		ssd_shadow_set_active(ssd);
 	}
 
 	ssd_shadow_update(ssd);
@@ -268,13 +255,50 @@ ssd_shadow_update(struct ssd *ssd)
 		}
 	};
 	bool show_shadows = rc.shadows_enabled && !maximized
-		&& (!view_is_tiled(ssd->view) || tiled_shadows);
+		&& (!view_is_tiled(ssd->view) || tiled_shadows)
+		&& ssd->shadow.top
+		&& theme->window[ssd->state.active].shadow_size > 0;
 	wlr_scene_node_set_enabled(&ssd->shadow.tree->node, show_shadows);
 	if (show_shadows) {
 		set_shadow_geometry(ssd);
 	}
 }
 
+void
+ssd_shadow_set_active(struct ssd *ssd)
+{
+	assert(ssd);
+	assert(ssd->shadow.tree);
+
+	struct ssd_shadow_scene *shadow = &ssd->shadow;
+	if (!shadow->top) {
+		return;
+	}
+
+	struct theme *theme = rc.theme;
+	enum ssd_active_state active = ssd->state.active;
+	if (theme->window[active].shadow_size == 0) {
+		/* Hidden by ssd_shadow_update() */
+		return;
+	}
+
+	struct wlr_buffer *corner_top_buffer =
+		&theme->window[active].shadow_corner_top->base;
+	struct wlr_buffer *corner_bottom_buffer =
+		&theme->window[active].shadow_corner_bottom->base;
+	struct wlr_buffer *edge_buffer =
+		&theme->window[active].shadow_edge->base;
+
+	wlr_scene_buffer_set_buffer(shadow->bottom_right, corner_bottom_buffer);
+	wlr_scene_buffer_set_buffer(shadow->bottom_left, corner_bottom_buffer);
+	wlr_scene_buffer_set_buffer(shadow->top_left, corner_top_buffer);
+	wlr_scene_buffer_set_buffer(shadow->top_right, corner_top_buffer);
+	wlr_scene_buffer_set_buffer(shadow->right, edge_buffer);
+	wlr_scene_buffer_set_buffer(shadow->bottom, edge_buffer);
+	wlr_scene_buffer_set_buffer(shadow->left, edge_buffer);
+	wlr_scene_buffer_set_buffer(shadow->top, edge_buffer);
+}
+
 void
 ssd_shadow_destroy(struct ssd *ssd)
 {
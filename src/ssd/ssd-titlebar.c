@@ -30,83 +30,84 @@ ssd_titlebar_create(struct ssd *ssd)
 	struct theme *theme = rc.theme;
 	int width = view->current.width;
 	int corner_width = ssd_get_corner_width();
+	enum ssd_active_state active = ssd->state.active;
 
 	ssd->titlebar.tree = lab_wlr_scene_tree_create(ssd->tree);
 	node_descriptor_create(&ssd->titlebar.tree->node,
 		LAB_NODE_TITLEBAR, view, /*data*/ NULL);
-
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-		subtree->tree = lab_wlr_scene_tree_create(ssd->titlebar.tree);
-		struct wlr_scene_tree *parent = subtree->tree;
-		wlr_scene_node_set_enabled(&parent->node, active);
-		wlr_scene_node_set_position(&parent->node, 0, -theme->titlebar_height);
-
-		struct wlr_buffer *titlebar_fill =
-			&theme->window[active].titlebar_fill->base;
-		struct wlr_buffer *corner_top_left =
-			&theme->window[active].corner_top_left_normal->base;
-		struct wlr_buffer *corner_top_right =
-			&theme->window[active].corner_top_right_normal->base;
-
-		/* Background */
-		subtree->bar = lab_wlr_scene_buffer_create(parent, titlebar_fill);
-		/*
-		 * Work around the wlroots/pixman bug that widened 1px buffer
-		 * becomes translucent when bilinear filtering is used.
-		 * TODO: remove once https://gitlab.freedesktop.org/wlroots/wlroots/-/issues/3990
-		 * is solved
-		 */
-		if (wlr_renderer_is_pixman(server.renderer)) {
-			wlr_scene_buffer_set_filter_mode(
-				subtree->bar, WLR_SCALE_FILTER_NEAREST);
-		}
-		wlr_scene_node_set_position(&subtree->bar->node, corner_width, 0);
-
-		subtree->corner_left = lab_wlr_scene_buffer_create(parent, corner_top_left);
-		wlr_scene_node_set_position(&subtree->corner_left->node,
-			-rc.theme->border_width, -rc.theme->border_width);
-
-		subtree->corner_right = lab_wlr_scene_buffer_create(parent, corner_top_right);
-		wlr_scene_node_set_position(&subtree->corner_right->node,
-			width - corner_width, -rc.theme->border_width);
-
-		/* Title */
-		subtree->title = scaled_font_buffer_create_for_titlebar(
-			subtree->tree, theme->titlebar_height,
-			theme->window[active].titlebar_pattern);
-		assert(subtree->title);
-		node_descriptor_create(&subtree->title->scene_buffer->node,
+	struct wlr_scene_tree *parent = ssd->titlebar.tree;
+	wlr_scene_node_set_position(&parent->node, 0, -theme->titlebar_height);
+
+	struct wlr_buffer *titlebar_fill =
+		&theme->window[active].titlebar_fill->base;
+	struct wlr_buffer *corner_top_left =
+		&theme->window[active].corner_top_left_normal->base;
+	struct wlr_buffer *corner_top_right =
+		&theme->window[active].corner_top_right_normal->base;
+
+	/* Background */
+	ssd->titlebar.bar = lab_wlr_scene_buffer_create(parent, titlebar_fill);
+	/*
+	 * Work around the wlroots/pixman bug that widened 1px buffer
+	 * becomes translucent when bilinear filtering is used.
+	 * TODO: remove once https://gitlab.freedesktop.org/wlroots/wlroots/-/issues/3990
+	 * is solved
+	 */
+	if (wlr_renderer_is_pixman(server.renderer)) {
+		wlr_scene_buffer_set_filter_mode(
+			ssd->titlebar.bar, WLR_SCALE_FILTER_NEAREST);
+	}
+	wlr_scene_node_set_position(&ssd->titlebar.bar->node, corner_width, 0);
+
+	ssd->titlebar.corner_left =
+		lab_wlr_scene_buffer_create(parent, corner_top_left);
+	wlr_scene_node_set_position(&ssd->titlebar.corner_left->node,
+		-rc.theme->border_width, -rc.theme->border_width);
+
+	ssd->titlebar.corner_right =
+		lab_wlr_scene_buffer_create(parent, corner_top_right);
+	wlr_scene_node_set_position(&ssd->titlebar.corner_right->node,
+		width - corner_width, -rc.theme->border_width);
+
+	/* Title */
+	enum ssd_active_state state;
+	FOR_EACH_ACTIVE_STATE(state) {
+		struct scaled_font_buffer *title =
+			scaled_font_buffer_create_for_titlebar(parent,
+				theme->titlebar_height,
+				theme->window[state].titlebar_pattern);
+		assert(title);
+		node_descriptor_create(&title->scene_buffer->node,
 			LAB_NODE_TITLE, view, /*data*/ NULL);
+		ssd->titlebar.title[state] = title;
+	}
 
-		/* Buttons */
-		int x = theme->window_titlebar_padding_width;
+	/* Buttons */
+	int x = theme->window_titlebar_padding_width;
 
-		/* Center vertically within titlebar */
-		int y = (theme->titlebar_height - theme->window_button_height) / 2;
+	/* Center vertically within titlebar */
+	int y = (theme->titlebar_height - theme->window_button_height) / 2;
 
-		wl_list_init(&subtree->buttons_left);
-		wl_list_init(&subtree->buttons_right);
+	wl_list_init(&ssd->titlebar.buttons_left);
+	wl_list_init(&ssd->titlebar.buttons_right);
 
-		for (int b = 0; b < rc.nr_title_buttons_left; b++) {
-			enum lab_node_type type = rc.title_buttons_left[b];
-			struct lab_img **imgs =
-				theme->window[active].button_imgs[type];
-			attach_ssd_button(&subtree->buttons_left, type, parent,
-				imgs, x, y, view);
-			x += theme->window_button_width + theme->window_button_spacing;
-		}
+	for (int b = 0; b < rc.nr_title_buttons_left; b++) {
+		enum lab_node_type type = rc.title_buttons_left[b];
+		struct lab_img **imgs =
+			theme->window[active].button_imgs[type];
+		attach_ssd_button(&ssd->titlebar.buttons_left, type, parent,
+			imgs, x, y, view);
+		x += theme->window_button_width + theme->window_button_spacing;
+	}
 
-		x = width - theme->window_titlebar_padding_width + theme->window_button_spacing;
-		for (int b = rc.nr_title_buttons_right - 1; b >= 0; b--) {
-			x -= theme->window_button_width + theme->window_button_spacing;
-			enum lab_node_type type = rc.title_buttons_right[b];
-			struct lab_img **imgs =
-				theme->window[active].button_imgs[type];
-			attach_ssd_button(&subtree->buttons_right, type, parent,
-				imgs, x, y, view);
-		}
+	x = width - theme->window_titlebar_padding_width + theme->window_button_spacing;
+	for (int b = rc.nr_title_buttons_right - 1; b >= 0; b--) {
+		x -= theme->window_button_width + theme->window_button_spacing;
+		enum lab_node_type type = rc.title_buttons_right[b];
+		struct lab_img **imgs =
+			theme->window[active].button_imgs[type];
+		attach_ssd_button(&ssd->titlebar.buttons_right, type, parent,
+			imgs, x, y, view);
 	}
 
 	update_visible_buttons(ssd);
@@ -133,25 +134,38 @@ ssd_titlebar_create(struct ssd *ssd)
 	}
 }
 
-static void
-update_button_state(struct ssd_button *button, enum lab_button_state state,
-		bool enable)
+/*
+ * Swap the buffers of the titlebar for those of ssd->state.active.
+ *
+ * Button images are shared between all windows via scaled_buffer and
+ * the title is rendered for both states in advance, so this does not
+ * render anything.
+ */
+void
+ssd_titlebar_set_active(struct ssd *ssd)
 {
-	if (enable) {
-		button->state_set |= state;
-	} else {
-		button->state_set &= ~state;
-	}
-	/* Switch the displayed icon buffer to the new one */
-	for (uint8_t state_set = LAB_BS_DEFAULT;
-			state_set <= LAB_BS_ALL; state_set++) {
-		struct scaled_img_buffer *buffer = button->img_buffers[state_set];
-		if (!buffer) {
-			continue;
-		}
-		wlr_scene_node_set_enabled(&buffer->scene_buffer->node,
-			state_set == button->state_set);
+	struct theme *theme = rc.theme;
+	enum ssd_active_state active = ssd->state.active;
+
+	wlr_scene_buffer_set_buffer(ssd->titlebar.bar,
+		&theme->window[active].titlebar_fill->base);
+	wlr_scene_buffer_set_buffer(ssd->titlebar.corner_left,
+		&theme->window[active].corner_top_left_normal->base);
+	wlr_scene_buffer_set_buffer(ssd->titlebar.corner_right,
+		&theme->window[active].corner_top_right_normal->base);
+
+	struct ssd_button *button;
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
+		ssd_button_set_imgs(button,
+			theme->window[active].button_imgs[button->type]);
 	}
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
+		ssd_button_set_imgs(button,
+			theme->window[active].button_imgs[button->type]);
+	}
+
+	/* Only toggles the title nodes as both states are rendered already */
+	ssd_update_title(ssd);
 }
 
 static void
@@ -164,50 +178,40 @@ set_squared_corners(struct ssd *ssd, bool enable)
 
 	int x = enable ? 0 : corner_width;
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-
-		wlr_scene_node_set_position(&subtree->bar->node, x, 0);
-		wlr_scene_buffer_set_dest_size(subtree->bar,
-			MAX(width - 2 * x, 0), theme->titlebar_height);
+	wlr_scene_node_set_position(&ssd->titlebar.bar->node, x, 0);
+	wlr_scene_buffer_set_dest_size(ssd->titlebar.bar,
+		MAX(width - 2 * x, 0), theme->titlebar_height);
 
-		wlr_scene_node_set_enabled(&subtree->corner_left->node, !enable);
+	wlr_scene_node_set_enabled(&ssd->titlebar.corner_left->node, !enable);
 
-		wlr_scene_node_set_enabled(&subtree->corner_right->node, !enable);
+	wlr_scene_node_set_enabled(&ssd->titlebar.corner_right->node, !enable);
 
-		/* (Un)round the corner buttons */
-		struct ssd_button *button;
-		wl_list_for_each(button, &subtree->buttons_left, link) {
-			update_button_state(button, LAB_BS_ROUNDED, !enable);
-			break;
-		}
-		wl_list_for_each(button, &subtree->buttons_right, link) {
-			update_button_state(button, LAB_BS_ROUNDED, !enable);
-			break;
-		}
+	/* (Un)round the corner buttons */
+	struct ssd_button *button;
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
+		ssd_button_update_state(button, LAB_BS_ROUNDED, !enable);
+		break;
+	}
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
+		ssd_button_update_state(button, LAB_BS_ROUNDED, !enable);
+		break;
 	}
 }
 
 static void
 set_alt_button_icon(struct ssd *ssd, enum lab_node_type type, bool enable)
 {
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-
-		struct ssd_button *button;
-		wl_list_for_each(button, &subtree->buttons_left, link) {
-			if (button->type == type) {
-				update_button_state(button,
-					LAB_BS_TOGGLED, enable);
-			}
+	struct ssd_button *button;
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
+		if (button->type == type) {
+			ssd_button_update_state(button,
+				LAB_BS_TOGGLED, enable);
 		}
-		wl_list_for_each(button, &subtree->buttons_right, link) {
-			if (button->type == type) {
-				update_button_state(button,
-					LAB_BS_TOGGLED, enable);
-			}
+	}
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
+		if (button->type == type) {
+			ssd_button_update_state(button,
+				LAB_BS_TOGGLED, enable);
 		}
 	}
 }
@@ -246,24 +250,20 @@ update_visible_buttons(struct ssd *ssd)
 		}
 	}
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-		int button_count = 0;
-
-		struct ssd_button *button;
-		wl_list_for_each(button, &subtree->buttons_left, link) {
-			wlr_scene_node_set_enabled(button->node,
-				button_count < button_count_left);
-			button_count++;
-		}
+	int button_count = 0;
 
-		button_count = 0;
-		wl_list_for_each(button, &subtree->buttons_right, link) {
-			wlr_scene_node_set_enabled(button->node,
-				button_count < button_count_right);
-			button_count++;
-		}
+	struct ssd_button *button;
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
+		wlr_scene_node_set_enabled(button->node,
+			button_count < button_count_left);
+		button_count++;
+	}
+
+	button_count = 0;
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
+		wlr_scene_node_set_enabled(button->node,
+			button_count < button_count_right);
+		button_count++;
 	}
 }
 
@@ -310,28 +310,24 @@ ssd_titlebar_update(struct ssd *ssd)
 	int x;
 	int bg_offset = maximized || squared ? 0 : corner_width;
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-		wlr_scene_buffer_set_dest_size(subtree->bar,
-			MAX(width - bg_offset * 2, 0), theme->titlebar_height);
-
-		x = theme->window_titlebar_padding_width;
-		struct ssd_button *button;
-		wl_list_for_each(button, &subtree->buttons_left, link) {
-			wlr_scene_node_set_position(button->node, x, y);
-			x += theme->window_button_width + theme->window_button_spacing;
-		}
+	wlr_scene_buffer_set_dest_size(ssd->titlebar.bar,
+		MAX(width - bg_offset * 2, 0), theme->titlebar_height);
+
+	x = theme->window_titlebar_padding_width;
+	struct ssd_button *button;
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
+		wlr_scene_node_set_position(button->node, x, y);
+		x += theme->window_button_width + theme->window_button_spacing;
+	}
 
-		x = width - corner_width;
-		wlr_scene_node_set_position(&subtree->corner_right->node,
-			x, -rc.theme->border_width);
+	x = width - corner_width;
+	wlr_scene_node_set_position(&ssd->titlebar.corner_right->node,
+		x, -rc.theme->border_width);
 
-		x = width - theme->window_titlebar_padding_width + theme->window_button_spacing;
-		wl_list_for_each(button, &subtree->buttons_right, link) {
-			x -= theme->window_button_width + theme->window_button_spacing;
-			wlr_scene_node_set_position(button->node, x, y);
-		}
+	x = width - theme->window_titlebar_padding_width + theme->window_button_spacing;
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
+		x -= theme->window_button_width + theme->window_button_spacing;
+		wlr_scene_node_set_position(button->node, x, y);
 	}
 
 	ssd_update_title(ssd);
@@ -350,11 +346,6 @@ ssd_titlebar_destroy(struct ssd *ssd)
 }
 
 /*
- * For ssd_update_title* we do not early out because
- * .active and .inactive may result in different sizes
- * of the title (font family/size) or background of
- * the title (different button/border width).
- *
  * Both, wlr_scene_node_set_enabled() and wlr_scene_node_set_position()
  * check for actual changes and return early if there is no change in state.
  * Always using wlr_scene_node_set_enabled(node, true) will thus not cause
@@ -371,14 +362,12 @@ ssd_update_title_positions(struct ssd *ssd, int offset_left, int offset_right)
 
 	enum ssd_active_state active;
 	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
-		struct scaled_font_buffer *title = subtree->title;
-		int x, y;
-
-		x = offset_left;
-		y = (theme->titlebar_height - title->height) / 2;
+		struct scaled_font_buffer *title = ssd->titlebar.title[active];
+		int x = offset_left;
+		int y = (theme->titlebar_height - title->height) / 2;
 
-		if (title_bg_width <= 0) {
+		/* Only the title of the current state is shown */
+		if (title_bg_width <= 0 || active != ssd->state.active) {
 			wlr_scene_node_set_enabled(&title->scene_buffer->node, false);
 			continue;
 		}
@@ -412,7 +401,6 @@ ssd_update_title_positions(struct ssd *ssd, int offset_left, int offset_right)
 static void
 get_title_offsets(struct ssd *ssd, int *offset_left, int *offset_right)
 {
-	struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[SSD_ACTIVE];
 	int button_width = rc.theme->window_button_width;
 	int button_spacing = rc.theme->window_button_spacing;
 	int padding_width = rc.theme->window_titlebar_padding_width;
@@ -420,12 +408,12 @@ get_title_offsets(struct ssd *ssd, int *offset_left, int *offset_right)
 	*offset_right = padding_width;
 
 	struct ssd_button *button;
-	wl_list_for_each(button, &subtree->buttons_left, link) {
+	wl_list_for_each(button, &ssd->titlebar.buttons_left, link) {
 		if (button->node->enabled) {
 			*offset_left += button_width + button_spacing;
 		}
 	}
-	wl_list_for_each(button, &subtree->buttons_right, link) {
+	wl_list_for_each(button, &ssd->titlebar.buttons_right, link) {
 		if (button->node->enabled) {
 			*offset_right += button_width + button_spacing;
 		}
@@ -451,9 +439,13 @@ ssd_update_title(struct ssd *ssd)
 	get_title_offsets(ssd, &offset_left, &offset_right);
 	int title_bg_width = view->current.width - offset_left - offset_right;
 
+	/*
+	 * Both states are rendered here so that (de)activation only needs
+	 * to toggle the title nodes instead of re-rendering the title.
+	 */
 	enum ssd_active_state active;
 	FOR_EACH_ACTIVE_STATE(active) {
-		struct ssd_titlebar_subtree *subtree = &ssd->titlebar.subtrees[active];
+		struct scaled_font_buffer *title = ssd->titlebar.title[active];
 		struct ssd_state_title_width *dstate = &state->dstates[active];
 		const float *text_color = theme->window[active].label_text_color;
 		struct font *font = active ?
@@ -471,12 +463,11 @@ ssd_update_title(struct ssd *ssd)
 		}
 
 		const float bg_color[4] = {0, 0, 0, 0}; /* ignored */
-		scaled_font_buffer_update(subtree->title, view->title,
-			title_bg_width, font,
-			text_color, bg_color);
+		scaled_font_buffer_update(title, view->title, title_bg_width,
+			font, text_color, bg_color);
 
 		/* And finally update the cache */
-		dstate->width = subtree->title->width;
+		dstate->width = title->width;
 		dstate->truncated = title_bg_width <= dstate->width;
 	}
 
@@ -501,11 +492,12 @@ ssd_update_hovered_button(struct wlr_scene_node *node)
 
 	/* Disable old hover */
 	if (server.hovered_button) {
-		update_button_state(server.hovered_button, LAB_BS_HOVERED, false);
+		ssd_button_update_state(server.hovered_button,
+			LAB_BS_HOVERED, false);
 	}
 	server.hovered_button = button;
 	if (button) {
-		update_button_state(button, LAB_BS_HOVERED, true);
+		ssd_button_update_state(button, LAB_BS_HOVERED, true);
 	}
 }
 
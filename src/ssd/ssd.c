@@ -156,6 +156,8 @@ ssd_create(struct view *view, bool active)
 		LAB_NODE_SSD_ROOT, view, /*data*/ NULL);
 
 	wlr_scene_node_lower_to_bottom(&ssd->tree->node);
+	ssd->state.active = active ? SSD_ACTIVE : SSD_INACTIVE;
+	ssd->state.keybind_inhibit_indicator = view->inhibits_keybinds;
 	ssd->titlebar.height = rc.theme->titlebar_height;
 	ssd_shadow_create(ssd);
 	ssd_extents_create(ssd);
@@ -172,8 +174,6 @@ ssd_create(struct view *view, bool active)
 		ssd_set_titlebar(ssd, false);
 	}
 	ssd->margin = ssd_thickness(view);
-	ssd_set_active(ssd, active);
-	ssd_enable_keybind_inhibit_indicator(ssd, view->inhibits_keybinds);
 	ssd->state.geometry = view->current;
 
 	return ssd;
@@ -311,20 +311,17 @@ ssd_set_active(struct ssd *ssd, bool active)
 	if (!ssd) {
 		return;
 	}
-	enum ssd_active_state active_state;
-	FOR_EACH_ACTIVE_STATE(active_state) {
-		wlr_scene_node_set_enabled(
-			&ssd->border.subtrees[active_state].tree->node,
-			active == active_state);
-		wlr_scene_node_set_enabled(
-			&ssd->titlebar.subtrees[active_state].tree->node,
-			active == active_state);
-		if (ssd->shadow.subtrees[active_state].tree) {
-			wlr_scene_node_set_enabled(
-				&ssd->shadow.subtrees[active_state].tree->node,
-				active == active_state);
-		}
+	enum ssd_active_state active_state = active ? SSD_ACTIVE : SSD_INACTIVE;
+	if (ssd->state.active == active_state) {
+		return;
 	}
+	ssd->state.active = active_state;
+
+	ssd_titlebar_set_active(ssd);
+	ssd_border_update_color(ssd);
+	ssd_shadow_set_active(ssd);
+	/* Active and inactive shadows may differ in size */
+	ssd_shadow_update(ssd);
 }
 
 void
@@ -346,10 +343,8 @@ ssd_enable_keybind_inhibit_indicator(struct ssd *ssd, bool enable)
 		return;
 	}
 
-	float *color = enable
-		? rc.theme->window_toggled_keybinds_color
-		: rc.theme->window[SSD_ACTIVE].border_color;
-	wlr_scene_rect_set_color(ssd->border.subtrees[SSD_ACTIVE].top, color);
+	ssd->state.keybind_inhibit_indicator = enable;
+	ssd_border_update_color(ssd);
 }
 
 bool
@@ -370,17 +365,14 @@ ssd_debug_get_node_name(const struct ssd *ssd, struct wlr_scene_node *node)
 	if (node == &ssd->tree->node) {
 		return "view->ssd";
 	}
-	if (node == &ssd->titlebar.subtrees[SSD_ACTIVE].tree->node) {
-		return "titlebar.active";
-	}
-	if (node == &ssd->titlebar.subtrees[SSD_INACTIVE].tree->node) {
-		return "titlebar.inactive";
+	if (node == &ssd->titlebar.tree->node) {
+		return "titlebar";
 	}
-	if (node == &ssd->border.subtrees[SSD_ACTIVE].tree->node) {
-		return "border.active";
+	if (node == &ssd->border.tree->node) {
+		return "border";
 	}
-	if (node == &ssd->border.subtrees[SSD_INACTIVE].tree->node) {
-		return "border.inactive";
+	if (node == &ssd->shadow.tree->node) {
+		return "shadow";
 	}
 	if (node == &ssd->extents.tree->node) {
 		return "extents";
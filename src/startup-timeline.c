@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include "startup-timeline.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <wayland-server-core.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/util/log.h>
+#include "common/buf.h"
+#include "common/macros.h"
+#include "common/time.h"
+
+/* Enough for all marks placed in the tree, further ones are dropped */
+#define STARTUP_TIMELINE_MAX_MARKS 32
+
+struct mark {
+	const char *phase;
+	double ms; /* since startup_timeline_init() */
+};
+
+static struct {
+	double start_ms;
+	struct mark marks[STARTUP_TIMELINE_MAX_MARKS];
+	size_t nr_marks;
+	bool done;
+
+	/* The summary is emitted once both have happened */
+	bool first_frame;
+	bool autostarted;
+
+	/* Output whose first presented frame ends the timeline */
+	struct wlr_output *output;
+	struct wl_listener present;
+	struct wl_listener destroy;
+} timeline;
+
+void
+startup_timeline_init(void)
+{
+	timeline.start_ms = get_time_ms();
+}
+
+void
+startup_timeline_mark(const char *phase)
+{
+	if (timeline.done || timeline.nr_marks == ARRAY_SIZE(timeline.marks)) {
+		return;
+	}
+	timeline.marks[timeline.nr_marks++] = (struct mark){
+		.phase = phase,
+		.ms = get_time_ms() - timeline.start_ms,
+	};
+}
+
+static void
+log_summary(void)
+{
+	wlr_log(WLR_INFO, "startup timeline:");
+	double prev_ms = 0;
+	for (size_t i = 0; i < timeline.nr_marks; i++) {
+		struct mark *mark = &timeline.marks[i];
+		wlr_log(WLR_INFO, "  %8.1f ms  (+%7.1f ms)  %s",
+			mark->ms, mark->ms - prev_ms, mark->phase);
+		prev_ms = mark->ms;
+	}
+}
+
+/* One JSON object per line so that runs can be appended and compared */
+static void
+write_json(const char *path)
+{
+	struct buf json = BUF_INIT;
+	buf_add_fmt(&json, "{\"version\":\"%s\",\"phases\":[", LABWC_VERSION);
+	for (size_t i = 0; i < timeline.nr_marks; i++) {
+		struct mark *mark = &timeline.marks[i];
+		buf_add_fmt(&json, "%s{\"name\":\"%s\",\"ms\":%.3f}",
+			i ? "," : "", mark->phase, mark->ms);
+	}
+	buf_add(&json, "]}\n");
+
+	FILE *file = fopen(path, "a");
+	if (!file) {
+		wlr_log_errno(WLR_ERROR, "cannot open %s", path);
+	} else {
+		fputs(json.data, file);
+		fclose(file);
+	}
+	buf_reset(&json);
+}
+
+static void
+finish(void)
+{
+	if (!timeline.first_frame || !timeline.autostarted) {
+		return;
+	}
+	timeline.done = true;
+
+	log_summary();
+	const char *path = getenv("LABWC_STARTUP_TIMELINE");
+	if (path && *path) {
+		write_json(path);
+	}
+}
+
+void
+startup_timeline_autostart_done(void)
+{
+	startup_timeline_mark("autostart");
+	timeline.autostarted = true;
+	finish();
+}
+
+static void
+unwatch_output(void)
+{
+	if (timeline.output) {
+		wl_list_remove(&timeline.present.link);
+		wl_list_remove(&timeline.destroy.link);
+		timeline.output = NULL;
+	}
+}
+
+static void
+handle_present(struct wl_listener *listener, void *data)
+{
+	struct wlr_output_event_present *event = data;
+	if (!event->presented) {
+		return;
+	}
+	startup_timeline_mark("first frame");
+	unwatch_output();
+	timeline.first_frame = true;
+	finish();
+}
+
+static void
+handle_destroy(struct wl_listener *listener, void *data)
+{
+	/* Wait for the next output to be configured instead */
+	unwatch_output();
+}
+
+void
+startup_timeline_watch_output(struct wlr_output *wlr_output)
+{
+	if (timeline.first_frame || timeline.output) {
+		return;
+	}
+	startup_timeline_mark("output modeset");
+
+	timeline.output = wlr_output;
+	timeline.present.notify = handle_present;
+	wl_signal_add(&wlr_output->events.present, &timeline.present);
+	timeline.destroy.notify = handle_destroy;
+	wl_signal_add(&wlr_output->events.destroy, &timeline.destroy);
+}
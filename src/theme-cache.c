@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include "theme-cache.h"
+#include <cairo.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wlr/util/log.h>
+#include "buffer.h"
+#include "common/buf.h"
+#include "common/mem.h"
+
+#define THEME_CACHE_MAGIC "LABWCTC"
+#define THEME_CACHE_VERSION 1
+/* Pixel data of each entry starts at a multiple of this */
+#define THEME_CACHE_ALIGN 16
+
+/*
+ * File layout:
+ *   struct cache_header
+ *   struct cache_entry[nr_entries]
+ *   pixel data of each entry at cache_entry.offset
+ *
+ * All values are in host byte order. The cache is only ever read by the
+ * machine that wrote it, so this is not a portable format.
+ */
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t nr_entries;
+	uint64_t key;
+};
+
+struct cache_entry {
+	/* A width of zero denotes a NULL buffer */
+	uint32_t width;
+	uint32_t height;
+	uint32_t stride;
+	uint32_t reserved;
+	uint64_t offset;
+};
+
+static void
+get_cache_dir(struct buf *dir)
+{
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home && *cache_home) {
+		buf_add_fmt(dir, "%s/labwc", cache_home);
+		return;
+	}
+	const char *home = getenv("HOME");
+	if (home && *home) {
+		buf_add_fmt(dir, "%s/.cache/labwc", home);
+	}
+}
+
+static bool
+make_cache_dir(const char *dir)
+{
+	/* Create parent ($HOME/.cache) first; ignore errors as it may exist */
+	char *parent = xstrdup(dir);
+	char *slash = strrchr(parent, '/');
+	if (slash && slash != parent) {
+		*slash = '\0';
+		mkdir(parent, 0700);
+	}
+	free(parent);
+
+	if (mkdir(dir, 0700) && errno != EEXIST) {
+		wlr_log_errno(WLR_DEBUG, "cannot create %s", dir);
+		return false;
+	}
+	return true;
+}
+
+static size_t
+align_up(size_t value)
+{
+	return (value + THEME_CACHE_ALIGN - 1) & ~(size_t)(THEME_CACHE_ALIGN - 1);
+}
+
+static bool
+entry_is_valid(const struct cache_entry *entry, size_t file_size)
+{
+	if (!entry->width) {
+		return true;
+	}
+	if (!entry->height || entry->width > INT16_MAX
+			|| entry->height > INT16_MAX) {
+		return false;
+	}
+	int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32,
+		entry->width);
+	if (stride < 0 || entry->stride != (uint32_t)stride) {
+		return false;
+	}
+	size_t size = (size_t)entry->stride * entry->height;
+	return entry->offset <= file_size && size <= file_size - entry->offset;
+}
+
+bool
+theme_cache_load(uint64_t key, struct lab_data_buffer **slots[],
+		size_t nr_slots)
+{
+	struct buf path = BUF_INIT;
+	get_cache_dir(&path);
+	if (!path.len) {
+		buf_reset(&path);
+		return false;
+	}
+	buf_add(&path, "/theme-assets");
+
+	bool ret = false;
+	int fd = open(path.data, O_RDONLY | O_CLOEXEC);
+	buf_reset(&path);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) || (size_t)st.st_size < sizeof(struct cache_header)
+			+ nr_slots * sizeof(struct cache_entry)) {
+		close(fd);
+		return false;
+	}
+	size_t size = st.st_size;
+	const uint8_t *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+
+	const struct cache_header *header = (const void *)map;
+	const struct cache_entry *entries = (const void *)(header + 1);
+	if (memcmp(header->magic, THEME_CACHE_MAGIC, sizeof(header->magic))
+			|| header->version != THEME_CACHE_VERSION
+			|| header->nr_entries != nr_slots
+			|| header->key != key) {
+		goto out;
+	}
+	for (size_t i = 0; i < nr_slots; i++) {
+		if (!entry_is_valid(&entries[i], size)) {
+			wlr_log(WLR_INFO, "ignoring corrupt theme cache");
+			goto out;
+		}
+	}
+
+	/*
+	 * Copy the pixels out of the mapping so that the buffers do not keep
+	 * the file mapped and are freed like any other lab_data_buffer
+	 */
+	for (size_t i = 0; i < nr_slots; i++) {
+		const struct cache_entry *entry = &entries[i];
+		if (!entry->width) {
+			*slots[i] = NULL;
+			continue;
+		}
+		size_t len = (size_t)entry->stride * entry->height;
+		void *data = xmalloc(len);
+		memcpy(data, map + entry->offset, len);
+		*slots[i] = buffer_create_from_data(data, entry->width,
+			entry->height, entry->stride);
+	}
+	ret = true;
+out:
+	munmap((void *)map, size);
+	return ret;
+}
+
+static bool
+write_all(int fd, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		p += n;
+		len -= n;
+	}
+	return true;
+}
+
+static bool
+write_cache(int fd, uint64_t key, struct lab_data_buffer **slots[],
+		size_t nr_slots)
+{
+	struct cache_header header = {
+		.magic = THEME_CACHE_MAGIC,
+		.version = THEME_CACHE_VERSION,
+		.nr_entries = nr_slots,
+		.key = key,
+	};
+	struct cache_entry *entries = znew_n(*entries, nr_slots);
+
+	size_t offset = align_up(sizeof(header) + nr_slots * sizeof(*entries));
+	for (size_t i = 0; i < nr_slots; i++) {
+		struct lab_data_buffer *buffer = *slots[i];
+		if (!buffer) {
+			continue;
+		}
+		cairo_surface_flush(buffer->surface);
+		entries[i] = (struct cache_entry){
+			.width = buffer->base.width,
+			.height = buffer->base.height,
+			.stride = buffer->stride,
+			.offset = offset,
+		};
+		offset = align_up(offset + buffer->stride * buffer->base.height);
+	}
+
+	bool ok = write_all(fd, &header, sizeof(header))
+		&& write_all(fd, entries, nr_slots * sizeof(*entries));
+	for (size_t i = 0; ok && i < nr_slots; i++) {
+		if (!entries[i].width) {
+			continue;
+		}
+		ok = lseek(fd, entries[i].offset, SEEK_SET) >= 0
+			&& write_all(fd, (*slots[i])->data,
+				(size_t)entries[i].stride * entries[i].height);
+	}
+	free(entries);
+	return ok;
+}
+
+void
+theme_cache_save(uint64_t key, struct lab_data_buffer **slots[],
+		size_t nr_slots)
+{
+	struct buf dir = BUF_INIT;
+	get_cache_dir(&dir);
+	if (!dir.len || !make_cache_dir(dir.data)) {
+		buf_reset(&dir);
+		return;
+	}
+
+	/* Write to a temporary file and rename() so readers never see a partial file */
+	struct buf tmp = BUF_INIT;
+	buf_add_fmt(&tmp, "%s/theme-assets.XXXXXX", dir.data);
+	struct buf path = BUF_INIT;
+	buf_add_fmt(&path, "%s/theme-assets", dir.data);
+	buf_reset(&dir);
+
+	int fd = mkstemp(tmp.data);
+	if (fd < 0) {
+		wlr_log_errno(WLR_DEBUG, "cannot create %s", tmp.data);
+		goto out;
+	}
+	bool ok = write_cache(fd, key, slots, nr_slots);
+	if (close(fd)) {
+		ok = false;
+	}
+	if (!ok || rename(tmp.data, path.data)) {
+		wlr_log_errno(WLR_DEBUG, "cannot write %s", path.data);
+		unlink(tmp.data);
+	}
+out:
+	buf_reset(&tmp);
+	buf_reset(&path);
+}
@@ -24,15 +24,21 @@
 #include "common/dir.h"
 #include "common/font.h"
 #include "common/graphic-helpers.h"
+#include "common/hash.h"
 #include "common/match.h"
 #include "common/mem.h"
 #include "common/parse-bool.h"
+#include "common/shadow-gradient.h"
 #include "common/string-helpers.h"
+#include "common/thread-pool.h"
+#include "common/time.h"
 #include "config/rcxml.h"
 #include "img/img.h"
 #include "labwc.h"
 #include "buffer.h"
+#include "scaled-buffer/scaled-img-buffer.h"
 #include "ssd.h"
+#include "theme-cache.h"
 
 struct button {
 	const char *name;
@@ -273,7 +279,7 @@ load_button(struct theme *theme, struct button *b, enum ssd_active_state active)
  * ...in the button array definition below.
  */
 static void
-load_buttons(struct theme *theme)
+load_buttons(struct theme *theme, enum ssd_active_state active)
 {
 	struct button buttons[] = { {
 		.name = "menu",
@@ -371,9 +377,7 @@ load_buttons(struct theme *theme)
 	}, };
 
 	for (size_t i = 0; i < ARRAY_SIZE(buttons); ++i) {
-		struct button *b = &buttons[i];
-		load_button(theme, b, SSD_INACTIVE);
-		load_button(theme, b, SSD_ACTIVE);
+		load_button(theme, &buttons[i], active);
 	}
 }
 
@@ -1413,7 +1417,7 @@ create_backgrounds(struct theme *theme)
 }
 
 static void
-create_corners(struct theme *theme)
+create_corners(struct theme *theme, enum ssd_active_state active)
 {
 	int corner_width = ssd_get_corner_width();
 
@@ -1424,181 +1428,107 @@ create_corners(struct theme *theme)
 		.height = theme->titlebar_height + theme->border_width,
 	};
 
-	enum ssd_active_state active;
-	FOR_EACH_ACTIVE_STATE(active) {
-		struct rounded_corner_ctx ctx = {
-			.box = &box,
-			.radius = rc.corner_radius,
-			.line_width = theme->border_width,
-			.fill_pattern = theme->window[active].titlebar_pattern,
-			.border_color = theme->window[active].border_color,
-			.corner = ROUNDED_CORNER_TOP_LEFT,
-		};
-		theme->window[active].corner_top_left_normal = rounded_rect(&ctx);
-		ctx.corner = ROUNDED_CORNER_TOP_RIGHT;
-		theme->window[active].corner_top_right_normal = rounded_rect(&ctx);
-	}
+	struct rounded_corner_ctx ctx = {
+		.box = &box,
+		.radius = rc.corner_radius,
+		.line_width = theme->border_width,
+		.fill_pattern = theme->window[active].titlebar_pattern,
+		.border_color = theme->window[active].border_color,
+		.corner = ROUNDED_CORNER_TOP_LEFT,
+	};
+	theme->window[active].corner_top_left_normal = rounded_rect(&ctx);
+	ctx.corner = ROUNDED_CORNER_TOP_RIGHT;
+	theme->window[active].corner_top_right_normal = rounded_rect(&ctx);
+}
+
+static void
+get_shadow_size(struct theme *theme, enum ssd_active_state active,
+		int *visible_size, int *total_size)
+{
+	/* Size of shadow visible extending beyond the window */
+	*visible_size = theme->window[active].shadow_size;
+	/* How far inside the window the shadow inset begins */
+	int inset = (double)*visible_size * SSD_SHADOW_INSET;
+	/* Total width including visible and obscured portion */
+	*total_size = *visible_size + inset;
 }
 
 /*
- * Draw the buffer used to render the edges of window drop-shadows. The buffer
- * is 1 pixel tall and `visible_size` pixels wide and can be rotated and scaled for the
- * different edges.  The buffer is drawn as would be found at the right-hand
- * edge of a window. The gradient has a color of `start_color` at its left edge
- * fading to clear at its right edge.
+ * Draw the buffer used to render the corners of window drop-shadows. The
+ * shadow looks better if the buffer is inset behind the window, so the buffer
+ * is square with a size of radius+inset. The buffer is drawn for the
+ * bottom-right corner but can be rotated for other corners.
  */
-static void
-shadow_edge_gradient(struct lab_data_buffer *buffer,
-		int visible_size, int total_size, float start_color[4])
+static struct lab_data_buffer *
+create_shadow_corner(const uint32_t *profile, int visible_size,
+		int total_size, int titlebar_height, const float color[4])
 {
+	struct lab_data_buffer *buffer =
+		buffer_create_cairo(total_size, total_size, 1.0);
 	if (!buffer) {
-		/* This type of shadow is disabled, do nothing */
-		return;
+		wlr_log(WLR_ERROR, "Failed to allocate shadow buffer");
+		return NULL;
 	}
-
 	assert(buffer->format == DRM_FORMAT_ARGB8888);
-	uint8_t *pixels = buffer->data;
-
-	/* Inset portion which is obscured */
-	int inset = total_size - visible_size;
-
-	/* Standard deviation normalised against the shadow width, squared */
-	double variance = 0.3 * 0.3;
-
-	for (int x = 0; x < visible_size; x++) {
-		/*
-		 * x normalised against total shadow width. We add on inset here
-		 * because we don't bother drawing inset for the edge shadow
-		 * buffers but still need the pattern to line up with the corner
-		 * shadow buffers which do have inset drawn.
-		 */
-		double xn = (double)(x + inset) / (double)total_size;
-
-		/* Gaussian dropoff */
-		double alpha = exp(-(xn * xn) / variance);
-
-		/* RGBA values are all pre-multiplied */
-		pixels[4 * x] = start_color[2] * alpha * 255;
-		pixels[4 * x + 1] = start_color[1] * alpha * 255;
-		pixels[4 * x + 2] = start_color[0] * alpha * 255;
-		pixels[4 * x + 3] = start_color[3] * alpha * 255;
-	}
+	shadow_gradient_corner(buffer->data, buffer->stride, profile,
+		visible_size, total_size, titlebar_height, color);
+	cairo_surface_mark_dirty(buffer->surface);
+	return buffer;
 }
 
 /*
- * Draw the buffer used to render the corners of window drop-shadows.  The
- * shadow looks better if the buffer is inset behind the window, so the buffer
- * is square with a size of radius+inset.  The buffer is drawn for the
- * bottom-right corner but can be rotated for other corners.  The gradient fades
- * from `start_color` at the top-left to clear at the opposite edge.
+ * Edge shadows don't need to be inset so the buffers are sized just for the
+ * visible width and 1 pixel tall; they can be rotated and scaled for the
+ * different edges. Corners are inset so the buffers are larger for this.
  *
- * If the window is translucent we don't want the shadow to be visible through
- * it.  For the bottom corners of the window this is easy, we just erase the
- * square of the buffer which will be behind the window.  For the top it's a
- * little more complicated because the titlebar can have rounded corners.
- * However, the titlebar itself is always opaque so we only have to erase the
- * L-shaped area of the buffer which can appear behind the non-titlebar part of
- * the window.
+ * All three buffers are derived from the same 1-D profile.
  */
 static void
-shadow_corner_gradient(struct lab_data_buffer *buffer, int visible_size,
-	int total_size, int titlebar_height, float start_color[4])
+create_shadows(struct theme *theme, enum ssd_active_state active)
 {
-	if (!buffer) {
-		/* This type of shadow is disabled, do nothing */
+	int visible_size, total_size;
+	get_shadow_size(theme, active, &visible_size, &total_size);
+	if (visible_size <= 0) {
 		return;
 	}
+	const float *color = theme->window[active].shadow_color;
 
-	assert(buffer->format == DRM_FORMAT_ARGB8888);
-	uint8_t *pixels = buffer->data;
-
-	/* Standard deviation normalised against the shadow width, squared */
-	double variance = 0.3 * 0.3;
-
-	int inset = total_size - visible_size;
-
-	for (int y = 0; y < total_size; y++) {
-		uint8_t *pixel_row = &pixels[y * buffer->stride];
-		for (int x = 0; x < total_size; x++) {
-			/* x and y normalised against total shadow width */
-			double x_norm = (double)(x) / (double)total_size;
-			double y_norm = (double)(y) / (double)total_size;
-			/*
-			 * For Gaussian drop-off in 2d you can just calculate
-			 * the outer product of the horizontal and vertical
-			 * profiles.
-			 */
-			double gauss_x = exp(-(x_norm * x_norm) / variance);
-			double gauss_y = exp(-(y_norm * y_norm) / variance);
-			double alpha = gauss_x * gauss_y;
-
-			/*
-			 * Erase the L-shaped region which could be visible
-			 * through a transparent window but not obscured by the
-			 * titlebar. If inset is smaller than the titlebar
-			 * height then there's nothing to do, this is handled by
-			 * (inset - titlebar_height) being negative.
-			 */
-			bool in1 = x < inset && y < inset - titlebar_height;
-			bool in2 = x < inset - titlebar_height && y < inset;
-			if (in1 || in2) {
-				alpha = 0.0;
-			}
+	uint32_t *profile = znew_n(*profile, total_size);
+	shadow_gradient_profile(profile, total_size);
 
-			/* RGBA values are all pre-multiplied */
-			pixel_row[4 * x] = start_color[2] * alpha * 255;
-			pixel_row[4 * x + 1] = start_color[1] * alpha * 255;
-			pixel_row[4 * x + 2] = start_color[0] * alpha * 255;
-			pixel_row[4 * x + 3] = start_color[3] * alpha * 255;
-		}
+	struct lab_data_buffer *buffer = buffer_create_cairo(visible_size, 1, 1.0);
+	if (buffer) {
+		assert(buffer->format == DRM_FORMAT_ARGB8888);
+		shadow_gradient_edge(buffer->data, profile, visible_size,
+			total_size, color);
+		cairo_surface_mark_dirty(buffer->surface);
+	} else {
+		wlr_log(WLR_ERROR, "Failed to allocate shadow buffer");
 	}
-}
+	theme->window[active].shadow_edge = buffer;
 
-static void
-create_shadow(struct theme *theme, enum ssd_active_state active)
-{
-	/* Size of shadow visible extending beyond the window */
-	int visible_size = theme->window[active].shadow_size;
-	/* How far inside the window the shadow inset begins */
-	int inset = (double)visible_size * SSD_SHADOW_INSET;
-	/* Total width including visible and obscured portion */
-	int total_size = visible_size + inset;
+	theme->window[active].shadow_corner_top = create_shadow_corner(profile,
+		visible_size, total_size, theme->titlebar_height, color);
+	theme->window[active].shadow_corner_bottom = create_shadow_corner(
+		profile, visible_size, total_size, 0, color);
 
-	/*
-	 * Edge shadows don't need to be inset so the buffers are sized just for
-	 * the visible width.  Corners are inset so the buffers are larger for
-	 * this.
-	 */
-	if (visible_size > 0) {
-		theme->window[active].shadow_edge = buffer_create_cairo(
-			visible_size, 1, 1.0);
-		theme->window[active].shadow_corner_top = buffer_create_cairo(
-			total_size, total_size, 1.0);
-		theme->window[active].shadow_corner_bottom = buffer_create_cairo(
-			total_size, total_size, 1.0);
-		if (!theme->window[active].shadow_corner_top
-				|| !theme->window[active].shadow_corner_bottom
-				|| !theme->window[active].shadow_edge) {
-			wlr_log(WLR_ERROR, "Failed to allocate shadow buffer");
-			return;
-		}
-	}
+	free(profile);
+}
 
-	shadow_edge_gradient(theme->window[active].shadow_edge, visible_size,
-		total_size, theme->window[active].shadow_color);
-	shadow_corner_gradient(theme->window[active].shadow_corner_top,
-		visible_size, total_size,
-		theme->titlebar_height, theme->window[active].shadow_color);
-	shadow_corner_gradient(theme->window[active].shadow_corner_bottom,
-		visible_size, total_size, 0,
-		theme->window[active].shadow_color);
+static struct lab_data_buffer *
+copy_buffer(struct lab_data_buffer *buffer)
+{
+	return buffer ? buffer_create_from_wlr_buffer(&buffer->base) : NULL;
 }
 
-static void
-create_shadows(struct theme *theme)
+static bool
+shadows_equal(struct theme *theme)
 {
-	create_shadow(theme, SSD_INACTIVE);
-	create_shadow(theme, SSD_ACTIVE);
+	return theme->window[SSD_INACTIVE].shadow_size
+			== theme->window[SSD_ACTIVE].shadow_size
+		&& !memcmp(theme->window[SSD_INACTIVE].shadow_color,
+			theme->window[SSD_ACTIVE].shadow_color,
+			sizeof(theme->window[SSD_ACTIVE].shadow_color));
 }
 
 static void
@@ -1814,9 +1744,151 @@ post_processing(struct theme *theme)
 	}
 }
 
+struct asset_job {
+	void (*func)(struct theme *theme, enum ssd_active_state active);
+	struct theme *theme;
+	enum ssd_active_state active;
+};
+
+static void
+run_asset_job(void *data)
+{
+	struct asset_job *job = data;
+	job->func(job->theme, job->active);
+}
+
+/*
+ * Bump this whenever the way corners or shadows are rendered changes, so
+ * that buffers cached by an older version are not reused.
+ */
+#define THEME_CACHE_RENDER_VERSION 2
+
+static uint64_t
+hash_background(uint64_t hash, const struct theme_background *bg)
+{
+	hash = hash_add(hash, &bg->gradient, sizeof(bg->gradient));
+	hash = hash_add(hash, bg->color, sizeof(bg->color));
+	hash = hash_add(hash, bg->color_split_to, sizeof(bg->color_split_to));
+	hash = hash_add(hash, bg->color_to, sizeof(bg->color_to));
+	return hash_add(hash, bg->color_to_split_to,
+		sizeof(bg->color_to_split_to));
+}
+
+/*
+ * The key is built from the resolved theme values rather than from the
+ * theme files, so that themerc, themerc-override and rc.xml settings are
+ * all accounted for without having to track which files were read.
+ */
+static uint64_t
+get_cache_key(struct theme *theme)
+{
+	int version = THEME_CACHE_RENDER_VERSION;
+	int corner_width = ssd_get_corner_width();
+
+	uint64_t hash = HASH_INIT;
+	hash = hash_add(hash, &version, sizeof(version));
+	hash = hash_add(hash, &theme->titlebar_height,
+		sizeof(theme->titlebar_height));
+	hash = hash_add(hash, &theme->border_width, sizeof(theme->border_width));
+	hash = hash_add(hash, &rc.corner_radius, sizeof(rc.corner_radius));
+	hash = hash_add(hash, &corner_width, sizeof(corner_width));
+
+	enum ssd_active_state active;
+	FOR_EACH_ACTIVE_STATE(active) {
+		hash = hash_background(hash, &theme->window[active].title_bg);
+		hash = hash_add(hash, theme->window[active].border_color,
+			sizeof(theme->window[active].border_color));
+		hash = hash_add(hash, &theme->window[active].shadow_size,
+			sizeof(theme->window[active].shadow_size));
+		hash = hash_add(hash, theme->window[active].shadow_color,
+			sizeof(theme->window[active].shadow_color));
+	}
+	return hash;
+}
+
+/*
+ * Render corners, load buttons and render shadows for both active states
+ * concurrently. Each job writes only to its own fields of theme->window[]
+ * and only reads the theme and rc otherwise, so the jobs do not need any
+ * synchronization beyond waiting for all of them to finish.
+ *
+ * Titlebar patterns must be created beforehand because corners use them.
+ */
+static void
+create_assets(struct theme *theme)
+{
+	void (*funcs[])(struct theme *theme, enum ssd_active_state active) = {
+		load_buttons,
+		create_corners,
+		create_shadows,
+	};
+	struct asset_job jobs[ARRAY_SIZE(funcs) * 2];
+
+	/*
+	 * Corners and shadows are restored from the on-disk cache if the
+	 * theme has not changed since they were last rendered. Buttons are
+	 * not cached because they are only decoded here and rendered later
+	 * for each output scale.
+	 */
+	struct lab_data_buffer **cached[] = {
+		&theme->window[SSD_INACTIVE].corner_top_left_normal,
+		&theme->window[SSD_INACTIVE].corner_top_right_normal,
+		&theme->window[SSD_INACTIVE].shadow_edge,
+		&theme->window[SSD_INACTIVE].shadow_corner_top,
+		&theme->window[SSD_INACTIVE].shadow_corner_bottom,
+		&theme->window[SSD_ACTIVE].corner_top_left_normal,
+		&theme->window[SSD_ACTIVE].corner_top_right_normal,
+		&theme->window[SSD_ACTIVE].shadow_edge,
+		&theme->window[SSD_ACTIVE].shadow_corner_top,
+		&theme->window[SSD_ACTIVE].shadow_corner_bottom,
+	};
+	uint64_t key = get_cache_key(theme);
+	bool cache_hit = theme_cache_load(key, cached, ARRAY_SIZE(cached));
+	size_t nr_funcs = cache_hit ? 1 : ARRAY_SIZE(funcs);
+
+	/* Identical shadows for both states are only rendered once */
+	bool share_shadows = !cache_hit && shadows_equal(theme);
+
+	struct thread_pool *pool = thread_pool_create(0, NULL);
+	size_t i = 0;
+	enum ssd_active_state active;
+	FOR_EACH_ACTIVE_STATE(active) {
+		for (size_t j = 0; j < nr_funcs; j++) {
+			if (funcs[j] == create_shadows && active == SSD_ACTIVE
+					&& share_shadows) {
+				continue;
+			}
+			jobs[i] = (struct asset_job){
+				.func = funcs[j],
+				.theme = theme,
+				.active = active,
+			};
+			thread_pool_submit(pool, run_asset_job, &jobs[i++]);
+		}
+	}
+	thread_pool_wait(pool);
+	thread_pool_destroy(pool);
+
+	if (share_shadows) {
+		theme->window[SSD_ACTIVE].shadow_edge = copy_buffer(
+			theme->window[SSD_INACTIVE].shadow_edge);
+		theme->window[SSD_ACTIVE].shadow_corner_top = copy_buffer(
+			theme->window[SSD_INACTIVE].shadow_corner_top);
+		theme->window[SSD_ACTIVE].shadow_corner_bottom = copy_buffer(
+			theme->window[SSD_INACTIVE].shadow_corner_bottom);
+	}
+
+	if (!cache_hit) {
+		theme_cache_save(key, cached, ARRAY_SIZE(cached));
+	}
+	wlr_log(WLR_DEBUG, "theme asset cache %s", cache_hit ? "hit" : "miss");
+}
+
 void
 theme_init(struct theme *theme, const char *theme_name)
 {
+	double start_ms = get_time_ms();
+
 	/*
 	 * Set some default values. This is particularly important on
 	 * reconfigure as not all themes set all options
@@ -1843,9 +1915,13 @@ theme_init(struct theme *theme, const char *theme_name)
 
 	post_processing(theme);
 	create_backgrounds(theme);
-	create_corners(theme);
-	load_buttons(theme);
-	create_shadows(theme);
+
+	double assets_start_ms = get_time_ms();
+	create_assets(theme);
+
+	wlr_log(WLR_INFO, "loaded theme '%s' in %.1f ms (assets %.1f ms)",
+		theme_name ? theme_name : "", get_time_ms() - start_ms,
+		get_time_ms() - assets_start_ms);
 }
 
 static void destroy_img(struct lab_img **img)
@@ -1857,6 +1933,8 @@ static void destroy_img(struct lab_img **img)
 void
 theme_finish(struct theme *theme)
 {
+	scaled_img_buffer_clear_cache();
+
 	for (enum lab_node_type type = LAB_NODE_BUTTON_FIRST;
 			type <= LAB_NODE_BUTTON_LAST; type++) {
 		for (uint8_t state_set = LAB_BS_DEFAULT;
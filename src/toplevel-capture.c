@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include "toplevel-capture.h"
+#include <assert.h>
+#include <pixman.h>
+#include <stdint.h>
+#include <wlr/types/wlr_ext_foreign_toplevel_list_v1.h>
+#include <wlr/types/wlr_ext_image_capture_source_v1.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/util/log.h>
+#include "common/mem.h"
+#include "common/time.h"
+#include "labwc.h"
+#include "view.h"
+
+/* Interval of the periodic statistics while frames are captured */
+#define CAPTURE_STATS_INTERVAL_MS 60000
+
+struct capture_stats {
+	double start_ms;
+	int nr_frames;
+	/* Sum of the damaged area of all frames */
+	uint64_t damaged_pixels;
+};
+
+struct toplevel_capture {
+	struct view *view;
+	struct wlr_ext_image_capture_source_v1 *source;
+
+	/* Since the last periodic log and since the capture started */
+	struct capture_stats interval;
+	struct capture_stats total;
+
+	struct wl_listener on_source_frame;
+	struct wl_listener on_source_destroy;
+};
+
+static uint64_t
+get_region_area(const pixman_region32_t *region)
+{
+	int nr_rects;
+	const pixman_box32_t *rects =
+		pixman_region32_rectangles((pixman_region32_t *)region, &nr_rects);
+	uint64_t area = 0;
+	for (int i = 0; i < nr_rects; i++) {
+		area += (uint64_t)(rects[i].x2 - rects[i].x1)
+			* (rects[i].y2 - rects[i].y1);
+	}
+	return area;
+}
+
+/*
+ * The copy itself is done by wlroots, so the damaged area per frame is
+ * logged as a measure of its cost rather than timing it.
+ */
+static void
+log_stats(struct toplevel_capture *capture, struct capture_stats *stats,
+		enum wlr_log_importance verbosity, const char *what)
+{
+	double seconds = (get_time_ms() - stats->start_ms) / 1000.0;
+	if (!stats->nr_frames || seconds <= 0) {
+		return;
+	}
+	uint64_t frame_pixels =
+		(uint64_t)capture->source->width * capture->source->height;
+	double damaged = frame_pixels
+		? 100.0 * stats->damaged_pixels / stats->nr_frames / frame_pixels
+		: 0;
+	wlr_log(verbosity, "capture of %s: %s %d frames in %.0f s "
+		"(%.1f fps), %.1f%% of %ux%u damaged per frame",
+		capture->view->app_id, what,
+		stats->nr_frames, seconds, stats->nr_frames / seconds, damaged,
+		capture->source->width, capture->source->height);
+}
+
+static void
+reset_stats(struct capture_stats *stats)
+{
+	*stats = (struct capture_stats){
+		.start_ms = get_time_ms(),
+	};
+}
+
+static void
+handle_source_frame(struct wl_listener *listener, void *data)
+{
+	struct toplevel_capture *capture =
+		wl_container_of(listener, capture, on_source_frame);
+	struct wlr_ext_image_capture_source_v1_frame_event *event = data;
+
+	uint64_t area = get_region_area(event->damage);
+	capture->interval.nr_frames++;
+	capture->interval.damaged_pixels += area;
+	capture->total.nr_frames++;
+	capture->total.damaged_pixels += area;
+
+	if (get_time_ms() - capture->interval.start_ms
+			>= CAPTURE_STATS_INTERVAL_MS) {
+		log_stats(capture, &capture->interval, WLR_DEBUG, "last");
+		reset_stats(&capture->interval);
+	}
+}
+
+static void
+destroy_capture(struct toplevel_capture *capture)
+{
+	log_stats(capture, &capture->total, WLR_INFO, "captured");
+	capture->view->capture.source = NULL;
+	wl_list_remove(&capture->on_source_frame.link);
+	wl_list_remove(&capture->on_source_destroy.link);
+	free(capture);
+}
+
+static void
+handle_source_destroy(struct wl_listener *listener, void *data)
+{
+	struct toplevel_capture *capture =
+		wl_container_of(listener, capture, on_source_destroy);
+	destroy_capture(capture);
+}
+
+static void
+handle_new_request(struct wl_listener *listener, void *data)
+{
+	struct wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request *request = data;
+	struct view *view = request->toplevel_handle->data;
+	assert(view);
+	wlr_log(WLR_INFO, "Capturing toplevel %s", view->app_id);
+
+	/* The source is shared by all capture sessions of the view */
+	struct toplevel_capture *capture = view->capture.source;
+	if (!capture) {
+		capture = znew(*capture);
+		capture->view = view;
+		capture->source = wlr_ext_image_capture_source_v1_create_with_scene_node(
+			&view->capture.scene->tree.node, server.wl_event_loop,
+			server.allocator, server.renderer);
+		assert(capture->source);
+		reset_stats(&capture->interval);
+		reset_stats(&capture->total);
+
+		capture->on_source_frame.notify = handle_source_frame;
+		wl_signal_add(&capture->source->events.frame,
+			&capture->on_source_frame);
+		capture->on_source_destroy.notify = handle_source_destroy;
+		wl_signal_add(&capture->source->events.destroy,
+			&capture->on_source_destroy);
+		view->capture.source = capture;
+	}
+	wlr_ext_foreign_toplevel_image_capture_source_manager_v1_request_accept(
+		request, capture->source);
+}
+
+void
+toplevel_capture_init(void)
+{
+	server.toplevel_capture.manager =
+		wlr_ext_foreign_toplevel_image_capture_source_manager_v1_create(
+			server.wl_display, 1);
+	if (server.toplevel_capture.manager) {
+		server.toplevel_capture.on.new_request.notify = handle_new_request;
+		wl_signal_add(&server.toplevel_capture.manager->events.new_request,
+			&server.toplevel_capture.on.new_request);
+	} else {
+		/* Allow safe removal on shutdown */
+		wl_list_init(&server.toplevel_capture.on.new_request.link);
+	}
+}
+
+void
+toplevel_capture_finish(void)
+{
+	wl_list_remove(&server.toplevel_capture.on.new_request.link);
+}
+
+void
+toplevel_capture_view_destroy(struct view *view)
+{
+	if (view->capture.source) {
+		destroy_capture(view->capture.source);
+	}
+}
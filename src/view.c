@@ -30,6 +30,7 @@
 #include "snap.h"
 #include "ssd.h"
 #include "theme.h"
+#include "toplevel-capture.h"
 #include "window-rules.h"
 #include "wlr/util/log.h"
 #include "workspaces.h"
@@ -39,6 +40,12 @@
 #include "xwayland.h"
 #endif
 
+/* Sources of view.stacking_order for views raised or lowered */
+static struct {
+	int64_t front;
+	int64_t back;
+} stacking;
+
 struct view *
 view_from_wlr_surface(struct wlr_surface *surface)
 {
@@ -307,14 +314,41 @@ view_matches_criteria(struct view *view, enum lab_view_criteria criteria)
 	return true;
 }
 
-struct view *
-view_next(struct wl_list *head, struct view *view, enum lab_view_criteria criteria)
+/*
+ * Views on the current workspace, omnipresent ones included, are also
+ * kept in a list of their own so that workspace-scoped iteration does not
+ * have to skip over the views on all other workspaces.
+ */
+static bool
+use_workspace_list(struct wl_list *head, enum lab_view_criteria criteria)
+{
+	return head == &server.views
+		&& (criteria & LAB_VIEW_CRITERIA_CURRENT_WORKSPACE)
+		&& server.workspaces.current;
+}
+
+static struct view *
+find_view(struct wl_list *head, struct view *view,
+		enum lab_view_criteria criteria, bool reverse)
 {
 	assert(head);
 
-	struct wl_list *elm = view ? &view->link : head;
+	if (use_workspace_list(head, criteria)) {
+		head = &server.workspaces.current->views;
+		struct wl_list *elm = view ? &view->workspace_link : head;
+		for (elm = reverse ? elm->prev : elm->next; elm != head;
+				elm = reverse ? elm->prev : elm->next) {
+			view = wl_container_of(elm, view, workspace_link);
+			if (view_matches_criteria(view, criteria)) {
+				return view;
+			}
+		}
+		return NULL;
+	}
 
-	for (elm = elm->next; elm != head; elm = elm->next) {
+	struct wl_list *elm = view ? &view->link : head;
+	for (elm = reverse ? elm->prev : elm->next; elm != head;
+			elm = reverse ? elm->prev : elm->next) {
 		view = wl_container_of(elm, view, link);
 		if (view_matches_criteria(view, criteria)) {
 			return view;
@@ -324,19 +358,15 @@ view_next(struct wl_list *head, struct view *view, enum lab_view_criteria criter
 }
 
 struct view *
-view_prev(struct wl_list *head, struct view *view, enum lab_view_criteria criteria)
+view_next(struct wl_list *head, struct view *view, enum lab_view_criteria criteria)
 {
-	assert(head);
-
-	struct wl_list *elm = view ? &view->link : head;
+	return find_view(head, view, criteria, /* reverse */ false);
+}
 
-	for (elm = elm->prev; elm != head; elm = elm->prev) {
-		view = wl_container_of(elm, view, link);
-		if (view_matches_criteria(view, criteria)) {
-			return view;
-		}
-	}
-	return NULL;
+struct view *
+view_prev(struct wl_list *head, struct view *view, enum lab_view_criteria criteria)
+{
+	return find_view(head, view, criteria, /* reverse */ true);
 }
 
 void
@@ -1575,11 +1605,51 @@ view_toggle_always_on_bottom(struct view *view)
 	}
 }
 
+/*
+ * Insert the view into the list of its workspace at the position matching
+ * its place in server.views, which only takes as long as there are views
+ * on that workspace.
+ */
+static void
+insert_into_workspace(struct view *view)
+{
+	struct wl_list *pos = &view->workspace->views;
+	struct view *other;
+	wl_list_for_each(other, &view->workspace->views, workspace_link) {
+		if (other->stacking_order < view->stacking_order) {
+			break;
+		}
+		pos = &other->workspace_link;
+	}
+	wl_list_insert(pos, &view->workspace_link);
+}
+
+static void
+insert_omnipresent(struct view *view)
+{
+	struct wl_list *pos = &server.workspaces.omnipresent_views;
+	struct view *other;
+	wl_list_for_each(other, &server.workspaces.omnipresent_views,
+			omnipresent_link) {
+		if (other->stacking_order < view->stacking_order) {
+			break;
+		}
+		pos = &other->omnipresent_link;
+	}
+	wl_list_insert(pos, &view->omnipresent_link);
+}
+
 void
 view_toggle_visible_on_all_workspaces(struct view *view)
 {
 	assert(view);
 	view->visible_on_all_workspaces = !view->visible_on_all_workspaces;
+	if (view->visible_on_all_workspaces) {
+		insert_omnipresent(view);
+	} else {
+		wl_list_remove(&view->omnipresent_link);
+		wl_list_init(&view->omnipresent_link);
+	}
 	ssd_update_geometry(view->ssd);
 }
 
@@ -1589,7 +1659,9 @@ view_move_to_workspace(struct view *view, struct workspace *workspace)
 	assert(view);
 	assert(workspace);
 	if (view->workspace != workspace) {
+		wl_list_remove(&view->workspace_link);
 		view->workspace = workspace;
+		insert_into_workspace(view);
 		wlr_scene_node_reparent(&view->scene_tree->node,
 			workspace->view_trees[view->layer]);
 	}
@@ -2167,16 +2239,32 @@ for_each_subview(struct view *view, void (*action)(struct view *))
 static void
 move_to_front(struct view *view)
 {
+	view->stacking_order = ++stacking.front;
 	wl_list_remove(&view->link);
 	wl_list_insert(&server.views, &view->link);
+	wl_list_remove(&view->workspace_link);
+	wl_list_insert(&view->workspace->views, &view->workspace_link);
+	if (view->visible_on_all_workspaces) {
+		wl_list_remove(&view->omnipresent_link);
+		wl_list_insert(&server.workspaces.omnipresent_views,
+			&view->omnipresent_link);
+	}
 	wlr_scene_node_raise_to_top(&view->scene_tree->node);
 }
 
 static void
 move_to_back(struct view *view)
 {
+	view->stacking_order = --stacking.back;
 	wl_list_remove(&view->link);
 	wl_list_append(&server.views, &view->link);
+	wl_list_remove(&view->workspace_link);
+	wl_list_append(&view->workspace->views, &view->workspace_link);
+	if (view->visible_on_all_workspaces) {
+		wl_list_remove(&view->omnipresent_link);
+		wl_list_append(&server.workspaces.omnipresent_views,
+			&view->omnipresent_link);
+	}
 	wlr_scene_node_lower_to_bottom(&view->scene_tree->node);
 }
 
@@ -2485,7 +2573,18 @@ view_init(struct view *view)
 
 	view->capture.scene = wlr_scene_create();
 	view->capture.scene->restack_xwayland_surfaces = false;
-	wl_list_init(&view->capture.on_capture_source_destroy.link);
+	wl_list_init(&view->omnipresent_link);
+}
+
+void
+view_add_to_stack(struct view *view)
+{
+	assert(view);
+	assert(view->workspace);
+
+	view->stacking_order = ++stacking.front;
+	wl_list_insert(&server.views, &view->link);
+	wl_list_insert(&view->workspace->views, &view->workspace_link);
 }
 
 void
@@ -2507,8 +2606,7 @@ view_destroy(struct view *view)
 	wl_list_remove(&view->request_fullscreen.link);
 	wl_list_remove(&view->set_title.link);
 	wl_list_remove(&view->destroy.link);
-	wl_list_remove(&view->capture.on_capture_source_destroy.link);
-
+	toplevel_capture_view_destroy(view);
 	wlr_scene_node_destroy(&view->capture.scene->tree.node);
 
 	if (view->foreign_toplevel) {
@@ -2573,8 +2671,10 @@ view_destroy(struct view *view)
 	zfree(view->title);
 	zfree(view->app_id);
 
-	/* Remove view from server.views */
+	/* Remove view from server.views and the per-workspace lists */
 	wl_list_remove(&view->link);
+	wl_list_remove(&view->workspace_link);
+	wl_list_remove(&view->omnipresent_link);
 	free(view);
 
 	cursor_update_focus();
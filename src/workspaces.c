@@ -2,8 +2,6 @@
 #define _POSIX_C_SOURCE 200809L
 #include "workspaces.h"
 #include <assert.h>
-#include <cairo.h>
-#include <pango/pangocairo.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,16 +9,17 @@
 #include <wlr/types/wlr_ext_workspace_v1.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_scene.h>
-#include "buffer.h"
 #include "common/font.h"
-#include "common/graphic-helpers.h"
+#include "common/lab-scene-rect.h"
 #include "common/list.h"
+#include "common/macros.h"
 #include "common/mem.h"
 #include "common/scene-helpers.h"
 #include "config/rcxml.h"
 #include "input/keyboard.h"
 #include "labwc.h"
 #include "output.h"
+#include "scaled-buffer/scaled-font-buffer.h"
 #include "show-desktop.h"
 #include "theme.h"
 #include "view.h"
@@ -60,125 +59,178 @@ parse_workspace_index(const char *name)
 	return index;
 }
 
+struct osd_layout {
+	int margin;
+	int padding;
+	int box_width;
+	int box_height;
+	bool hide_boxes;
+	int boxes_width;
+	int width;
+	int height;
+};
+
 static void
-_osd_update(void)
+osd_get_layout(struct osd_layout *layout)
 {
 	struct theme *theme = rc.theme;
+	*layout = (struct osd_layout){
+		.margin = 10,
+		.padding = 2,
+		.box_width = theme->osd_workspace_switcher_boxes_width,
+		.box_height = theme->osd_workspace_switcher_boxes_height,
+	};
+	layout->hide_boxes = !layout->box_width || !layout->box_height;
+
+	int workspace_count = wl_list_length(&server.workspaces.all);
+	layout->boxes_width = workspace_count
+		* (layout->box_width + layout->padding) - layout->padding;
+	layout->width = layout->margin * 2 + MAX(layout->boxes_width, 200);
+	layout->height = layout->margin * (layout->hide_boxes ? 2 : 3)
+		+ layout->box_height + font_height(&rc.font_osd);
+}
+
+/*
+ * Build the OSD of an output from scene nodes which are kept while the OSD
+ * is hidden. The font buffers cache their rendering for each output scale,
+ * so switching workspaces only moves the active box and swaps the label.
+ */
+static void
+osd_create(struct output *output)
+{
+	struct theme *theme = rc.theme;
+	struct osd_layout layout;
+	osd_get_layout(&layout);
+
+	struct wlr_scene_tree *tree = lab_wlr_scene_tree_create(&server.scene->tree);
+	wlr_scene_node_set_enabled(&tree->node, false);
+	output->workspace_osd.tree = tree;
+	output->workspace_osd.boxes = NULL;
+	output->workspace_osd.active_box = NULL;
+
+	/* Background and border */
+	struct lab_scene_rect_options bg_opts = {
+		.border_colors = (float *[1]) {theme->osd_border_color},
+		.nr_borders = 1,
+		.border_width = theme->osd_border_width,
+		.bg_color = theme->osd_bg_color,
+		.width = layout.width,
+		.height = layout.height,
+	};
+	lab_scene_rect_create(tree, &bg_opts);
+
+	/* Box outlines, one child per workspace, and the active box fill */
+	struct workspace *workspace;
+	if (!layout.hide_boxes) {
+		struct wlr_scene_tree *boxes = lab_wlr_scene_tree_create(tree);
+		int x = (layout.width - layout.boxes_width) / 2;
+		wl_list_for_each(workspace, &server.workspaces.all, link) {
+			struct lab_scene_rect_options box_opts = {
+				.border_colors = (float *[1]) {theme->osd_label_text_color},
+				.nr_borders = 1,
+				.border_width =
+					theme->osd_workspace_switcher_boxes_border_width,
+				.width = layout.box_width,
+				.height = layout.box_height,
+			};
+			struct lab_scene_rect *box = lab_scene_rect_create(boxes,
+				&box_opts);
+			wlr_scene_node_set_position(&box->tree->node, x,
+				layout.margin);
+			x += layout.box_width + layout.padding;
+		}
+		output->workspace_osd.boxes = boxes;
+		output->workspace_osd.active_box = lab_wlr_scene_rect_create(tree,
+			layout.box_width, layout.box_height,
+			theme->osd_label_text_color);
+	}
+
+	/* Workspace names, one child per workspace */
+	struct wlr_scene_tree *labels = lab_wlr_scene_tree_create(tree);
+	int y = layout.hide_boxes
+		? (layout.height - font_height(&rc.font_osd)) / 2
+		: layout.margin * 2 + layout.box_height;
+	wl_list_for_each(workspace, &server.workspaces.all, link) {
+		struct scaled_font_buffer *label = scaled_font_buffer_create(labels);
+		scaled_font_buffer_update(label, workspace->name,
+			layout.width - 2 * layout.margin, &rc.font_osd,
+			theme->osd_label_text_color, theme->osd_bg_color);
+		/* Center workspace indicator on the x axis */
+		wlr_scene_node_set_position(&label->scene_buffer->node,
+			(layout.width - label->width) / 2, y);
+	}
+	output->workspace_osd.labels = labels;
+	output->workspace_osd.width = layout.width;
+	output->workspace_osd.height = layout.height;
+}
+
+static void
+osd_destroy(struct output *output)
+{
+	if (output->workspace_osd.tree) {
+		wlr_scene_node_destroy(&output->workspace_osd.tree->node);
+		output->workspace_osd.tree = NULL;
+	}
+}
 
-	/* Settings */
-	uint16_t margin = 10;
-	uint16_t padding = 2;
-	uint16_t rect_height = theme->osd_workspace_switcher_boxes_height;
-	uint16_t rect_width = theme->osd_workspace_switcher_boxes_width;
-	bool hide_boxes = theme->osd_workspace_switcher_boxes_width == 0 ||
-		theme->osd_workspace_switcher_boxes_height == 0;
-
-	/* Dimensions */
-	size_t workspace_count = wl_list_length(&server.workspaces.all);
-	uint16_t marker_width = workspace_count * (rect_width + padding) - padding;
-	uint16_t width = margin * 2 + (marker_width < 200 ? 200 : marker_width);
-	uint16_t height = margin * (hide_boxes ? 2 : 3) + rect_height + font_height(&rc.font_osd);
-
-	cairo_t *cairo;
-	cairo_surface_t *surface;
+static struct wlr_scene_node *
+get_nth_child(struct wlr_scene_tree *tree, int index)
+{
+	struct wlr_scene_node *node;
+	wl_list_for_each(node, &tree->children, link) {
+		if (!index--) {
+			return node;
+		}
+	}
+	return NULL;
+}
+
+static void
+_osd_update(void)
+{
+	int current = 0;
 	struct workspace *workspace;
+	wl_list_for_each(workspace, &server.workspaces.all, link) {
+		if (workspace == server.workspaces.current) {
+			break;
+		}
+		current++;
+	}
 
 	struct output *output;
 	wl_list_for_each(output, &server.outputs, link) {
 		if (!output_is_usable(output)) {
 			continue;
 		}
-		struct lab_data_buffer *buffer = buffer_create_cairo(width, height,
-			output->wlr_output->scale);
-		if (!buffer) {
-			wlr_log(WLR_ERROR, "Failed to allocate buffer for workspace OSD");
-			continue;
+		if (!output->workspace_osd.tree) {
+			osd_create(output);
 		}
 
-		cairo = cairo_create(buffer->surface);
-
-		/* Background */
-		set_cairo_color(cairo, theme->osd_bg_color);
-		cairo_rectangle(cairo, 0, 0, width, height);
-		cairo_fill(cairo);
-
-		/* Border */
-		set_cairo_color(cairo, theme->osd_border_color);
-		struct wlr_fbox border_fbox = {
-			.width = width,
-			.height = height,
-		};
-		draw_cairo_border(cairo, border_fbox, theme->osd_border_width);
-
-		/* Boxes */
-		uint16_t x;
-		if (!hide_boxes) {
-			x = (width - marker_width) / 2;
-			wl_list_for_each(workspace, &server.workspaces.all, link) {
-				bool active = workspace == server.workspaces.current;
-				set_cairo_color(cairo, rc.theme->osd_label_text_color);
-				struct wlr_fbox fbox = {
-					.x = x,
-					.y = margin,
-					.width = rect_width,
-					.height = rect_height,
-				};
-				draw_cairo_border(cairo, fbox,
-					theme->osd_workspace_switcher_boxes_border_width);
-				if (active) {
-					cairo_rectangle(cairo, x, margin,
-						rect_width, rect_height);
-					cairo_fill(cairo);
-				}
-				x += rect_width + padding;
-			}
+		/* Only show the label of the current workspace */
+		int index = 0;
+		struct wlr_scene_node *node;
+		wl_list_for_each(node, &output->workspace_osd.labels->children,
+				link) {
+			wlr_scene_node_set_enabled(node, index++ == current);
 		}
 
-		/* Text */
-		set_cairo_color(cairo, rc.theme->osd_label_text_color);
-		PangoLayout *layout = pango_cairo_create_layout(cairo);
-		pango_context_set_round_glyph_positions(pango_layout_get_context(layout), false);
-		pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
-
-		/* Center workspace indicator on the x axis */
-		int req_width = font_width(&rc.font_osd, server.workspaces.current->name);
-		req_width = MIN(req_width, width - 2 * margin);
-		x = (width - req_width) / 2;
-		if (!hide_boxes) {
-			cairo_move_to(cairo, x, margin * 2 + rect_height);
-		} else {
-			cairo_move_to(cairo, x, (height - font_height(&rc.font_osd)) / 2.0);
-		}
-		PangoFontDescription *desc = font_to_pango_desc(&rc.font_osd);
-		//pango_font_description_set_weight(desc, PANGO_WEIGHT_BOLD);
-		pango_layout_set_font_description(layout, desc);
-		pango_layout_set_width(layout, req_width * PANGO_SCALE);
-		pango_font_description_free(desc);
-		pango_layout_set_text(layout, server.workspaces.current->name, -1);
-		pango_cairo_show_layout(cairo, layout);
-
-		g_object_unref(layout);
-		surface = cairo_get_target(cairo);
-		cairo_surface_flush(surface);
-		cairo_destroy(cairo);
-
-		if (!output->workspace_osd) {
-			output->workspace_osd = lab_wlr_scene_buffer_create(
-				&server.scene->tree, NULL);
+		if (output->workspace_osd.active_box) {
+			node = get_nth_child(output->workspace_osd.boxes, current);
+			wlr_scene_node_set_position(
+				&output->workspace_osd.active_box->node,
+				node->x, node->y);
 		}
+
 		/* Position the whole thing */
 		struct wlr_box output_box;
 		wlr_output_layout_get_box(server.output_layout,
 			output->wlr_output, &output_box);
-		int lx = output_box.x + (output_box.width - width) / 2;
-		int ly = output_box.y + (output_box.height - height) / 2;
-		wlr_scene_node_set_position(&output->workspace_osd->node, lx, ly);
-		wlr_scene_buffer_set_buffer(output->workspace_osd, &buffer->base);
-		wlr_scene_buffer_set_dest_size(output->workspace_osd,
-			buffer->logical_width, buffer->logical_height);
-
-		/* And finally drop the buffer so it will get destroyed on OSD hide */
-		wlr_buffer_drop(&buffer->base);
+		int lx = output_box.x
+			+ (output_box.width - output->workspace_osd.width) / 2;
+		int ly = output_box.y
+			+ (output_box.height - output->workspace_osd.height) / 2;
+		wlr_scene_node_set_position(&output->workspace_osd.tree->node,
+			lx, ly);
 	}
 }
 
@@ -230,6 +282,7 @@ add_workspace(const char *name)
 {
 	struct workspace *workspace = znew(*workspace);
 	workspace->name = xstrdup(name);
+	wl_list_init(&workspace->views);
 	workspace->tree = lab_wlr_scene_tree_create(server.workspace_tree);
 	workspace->view_trees[VIEW_LAYER_ALWAYS_ON_BOTTOM] =
 		lab_wlr_scene_tree_create(workspace->tree);
@@ -284,8 +337,8 @@ workspace_has_views(struct workspace *workspace)
 {
 	struct view *view;
 
-	for_each_view(view, &server.views, LAB_VIEW_CRITERIA_NO_OMNIPRESENT) {
-		if (view->workspace == workspace) {
+	wl_list_for_each(view, &workspace->views, workspace_link) {
+		if (view_matches_criteria(view, LAB_VIEW_CRITERIA_NO_OMNIPRESENT)) {
 			return true;
 		}
 	}
@@ -366,8 +419,9 @@ _osd_show(void)
 	_osd_update();
 	struct output *output;
 	wl_list_for_each(output, &server.outputs, link) {
-		if (output_is_usable(output) && output->workspace_osd) {
-			wlr_scene_node_set_enabled(&output->workspace_osd->node, true);
+		if (output_is_usable(output) && output->workspace_osd.tree) {
+			wlr_scene_node_set_enabled(
+				&output->workspace_osd.tree->node, true);
 		}
 	}
 	if (keyboard_get_all_modifiers(&server.seat)) {
@@ -399,6 +453,7 @@ workspaces_init(void)
 		&server.workspaces.on_ext_manager.commit);
 
 	wl_list_init(&server.workspaces.all);
+	wl_list_init(&server.workspaces.omnipresent_views);
 
 	struct workspace_config *conf;
 	wl_list_for_each(conf, &rc.workspace_config.workspaces, link) {
@@ -447,15 +502,13 @@ workspaces_switch_to(struct workspace *target, bool update_focus)
 		server.workspaces.current->ext_workspace, false);
 
 	/*
-	 * Move Omnipresent views to new workspace.
-	 * Not using for_each_view() since it skips views that
-	 * view_is_focusable() returns false (e.g. Conky).
+	 * Move Omnipresent views to new workspace, including those that
+	 * view_is_focusable() returns false for (e.g. Conky).
 	 */
 	struct view *view;
-	wl_list_for_each_reverse(view, &server.views, link) {
-		if (view->visible_on_all_workspaces) {
-			view_move_to_workspace(view, target);
-		}
+	wl_list_for_each_reverse(view, &server.workspaces.omnipresent_views,
+			omnipresent_link) {
+		view_move_to_workspace(view, target);
 	}
 
 	/* Enable the new workspace */
@@ -506,11 +559,10 @@ workspaces_osd_hide(struct seat *seat)
 	assert(seat);
 	struct output *output;
 	wl_list_for_each(output, &server.outputs, link) {
-		if (!output->workspace_osd) {
-			continue;
+		if (output->workspace_osd.tree) {
+			wlr_scene_node_set_enabled(
+				&output->workspace_osd.tree->node, false);
 		}
-		wlr_scene_node_set_enabled(&output->workspace_osd->node, false);
-		wlr_scene_buffer_set_buffer(output->workspace_osd, NULL);
 	}
 	seat->workspace_osd_shown_by_modifier = false;
 
@@ -554,8 +606,8 @@ destroy_workspace(struct workspace *workspace)
 	free(workspace);
 }
 
-void
-workspaces_reconfigure(void)
+static void
+update_workspaces(void)
 {
 	/*
 	 * Compare actual workspace list with the new desired configuration to:
@@ -605,11 +657,10 @@ workspaces_reconfigure(void)
 		wlr_log(WLR_DEBUG, "Destroying workspace \"%s\"",
 			workspace->name);
 
-		struct view *view;
-		wl_list_for_each(view, &server.views, link) {
-			if (view->workspace == workspace) {
-				view_move_to_workspace(view, first_workspace);
-			}
+		struct view *view, *tmp;
+		wl_list_for_each_safe(view, tmp, &workspace->views,
+				workspace_link) {
+			view_move_to_workspace(view, first_workspace);
 		}
 
 		if (server.workspaces.current == workspace) {
@@ -625,6 +676,22 @@ workspaces_reconfigure(void)
 	}
 }
 
+void
+workspaces_reconfigure(void)
+{
+	update_workspaces();
+
+	/*
+	 * The OSDs depend on the theme and the workspace names. Destroy
+	 * them only now as switching away from a removed workspace above
+	 * shows the OSD, which would cache the old workspaces.
+	 */
+	struct output *output;
+	wl_list_for_each(output, &server.outputs, link) {
+		osd_destroy(output);
+	}
+}
+
 void
 workspaces_destroy(void)
 {
@@ -1102,7 +1102,7 @@ handle_new_xdg_toplevel(struct wl_listener *listener, void *data)
 	CONNECT_SIGNAL(toplevel, xdg_toplevel_view, set_parent);
 	CONNECT_SIGNAL(xdg_surface, xdg_toplevel_view, new_popup);
 
-	wl_list_insert(&server.views, &view->link);
+	view_add_to_stack(view);
 	view->creation_id = server.next_view_creation_id++;
 }
 
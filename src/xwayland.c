@@ -3,6 +3,7 @@
 #include "xwayland.h"
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wlr/types/wlr_compositor.h>
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_scene.h>
@@ -11,6 +12,7 @@
 #include <wlr/xwayland.h>
 #include "buffer.h"
 #include "common/array.h"
+#include "common/hash.h"
 #include "common/macros.h"
 #include "common/mem.h"
 #include "common/scene-helpers.h"
@@ -654,6 +656,18 @@ handle_set_strut_partial(struct wl_listener *listener, void *data)
 	}
 }
 
+static uint64_t
+hash_icon_data(const uint32_t *data, size_t len)
+{
+	/* Word-wise FNV-1a, icons can be several megabytes */
+	uint64_t hash = HASH_INIT;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash_add(hash, &len, sizeof(len));
+}
+
 static void
 handle_set_icon(struct wl_listener *listener, void *data)
 {
@@ -664,32 +678,38 @@ handle_set_icon(struct wl_listener *listener, void *data)
 	if (!wlr_xwayland_surface_fetch_icon(xwayland_view->xwayland_surface,
 			&icon_reply)) {
 		wlr_log(WLR_INFO, "Invalid x11 icon");
+		xwayland_view->icon_hash = 0;
 		view_set_icon(&xwayland_view->base, NULL, NULL);
 		goto out;
 	}
 
+	/*
+	 * Some clients set the same icon over and over again, don't make
+	 * scaled_icon_buffers reload it each time
+	 */
+	uint64_t hash = hash_icon_data(
+		xcb_get_property_value(icon_reply._reply),
+		xcb_get_property_value_length(icon_reply._reply) / 4);
+	if (hash == xwayland_view->icon_hash) {
+		goto out;
+	}
+	xwayland_view->icon_hash = hash;
+
 	xcb_ewmh_wm_icon_iterator_t iter = xcb_ewmh_get_wm_icon_iterator(&icon_reply);
 	struct wl_array buffers;
 	wl_array_init(&buffers);
 	for (; iter.rem; xcb_ewmh_get_wm_icon_next(&iter)) {
 		size_t stride = iter.width * 4;
-		uint32_t *buf = xzalloc(iter.height * stride);
-
-		/* Pre-multiply alpha */
-		for (uint32_t y = 0; y < iter.height; y++) {
-			for (uint32_t x = 0; x < iter.width; x++) {
-				uint32_t i = x + y * iter.width;
-				uint8_t *src_pixel = (uint8_t *)&iter.data[i];
-				uint8_t *dst_pixel = (uint8_t *)&buf[i];
-				dst_pixel[0] = src_pixel[0] * src_pixel[3] / 255;
-				dst_pixel[1] = src_pixel[1] * src_pixel[3] / 255;
-				dst_pixel[2] = src_pixel[2] * src_pixel[3] / 255;
-				dst_pixel[3] = src_pixel[3];
-			}
-		}
+		uint32_t *buf = xmalloc(iter.height * stride);
+		memcpy(buf, iter.data, iter.height * stride);
 
+		/*
+		 * Clients often provide many sizes of which only one is shown,
+		 * so alpha is only pre-multiplied once a size has been chosen
+		 */
 		struct lab_data_buffer *buffer = buffer_create_from_data(
 			buf, iter.width, iter.height, stride);
+		buffer->straight_alpha = true;
 		array_add(&buffers, buffer);
 	}
 
@@ -1034,7 +1054,7 @@ xwayland_view_create(struct wlr_xwayland_surface *xsurface, bool mapped)
 	/* Events from the view itself */
 	CONNECT_SIGNAL(view, &xwayland_view->on_view, always_on_top);
 
-	wl_list_insert(&server.views, &view->link);
+	view_add_to_stack(view);
 	view->creation_id = server.next_view_creation_id++;
 
 	if (xsurface->surface) {
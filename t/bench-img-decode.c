@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Micro-benchmark for decoding XPM and XBM images of the sizes found in
+ * Openbox themes and in legacy application icons.
+ *
+ * Run with: meson test -C build --benchmark --verbose
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "common/buf.h"
+#include "common/macros.h"
+#include "common/time.h"
+#include "img/xbm-decode.h"
+#include "img/xpm-decode.h"
+
+#define ITERATIONS 2000
+
+/* Characters used for pixels, a subset of what real files use */
+static const char pixel_chars[] =
+	".+@#$%&*=-;>,')!~{]^/(_:<[}|1234567890abcdefghijklmnopqrstuvwxyz";
+
+static void
+create_xpm(struct buf *buf, int size, int nr_colors, int cpp)
+{
+	int nr_chars = sizeof(pixel_chars) - 1;
+	buf_add(buf, "/* XPM */\nstatic char *icon[] = {\n");
+	buf_add_fmt(buf, "\"%d %d %d %d\",\n", size, size, nr_colors, cpp);
+	for (int i = 0; i < nr_colors; i++) {
+		buf_add(buf, "\"");
+		for (int c = 0, n = i; c < cpp; c++, n /= nr_chars) {
+			buf_add_char(buf, pixel_chars[n % nr_chars]);
+		}
+		buf_add_fmt(buf, " c #%06X\",\n", (i * 0x10325) & 0xffffff);
+	}
+	for (int y = 0; y < size; y++) {
+		buf_add(buf, "\"");
+		for (int x = 0; x < size; x++) {
+			/* Runs of a few pixels, like in real images */
+			int n = ((x / 3) * 7 + y * 13) % nr_colors;
+			for (int c = 0; c < cpp; c++, n /= nr_chars) {
+				buf_add_char(buf, pixel_chars[n % nr_chars]);
+			}
+		}
+		buf_add(buf, "\",\n");
+	}
+	buf_add(buf, "};\n");
+}
+
+static void
+create_xbm(struct buf *buf, int size)
+{
+	buf_add_fmt(buf, "#define button_width %d\n", size);
+	buf_add_fmt(buf, "#define button_height %d\n", size);
+	buf_add(buf, "static unsigned char button_bits[] = {\n");
+	int bytes = (size + 7) / 8 * size;
+	for (int i = 0; i < bytes; i++) {
+		buf_add_fmt(buf, "0x%02x%s", (i * 37) & 0xff,
+			i + 1 < bytes ? ", " : " };\n");
+	}
+}
+
+static void
+bench(const char *name, struct buf *buf, bool is_xpm)
+{
+	double start = get_time_ms();
+	for (int i = 0; i < ITERATIONS; i++) {
+		int width, height;
+		uint32_t *pixels = is_xpm
+			? xpm_decode(buf->data, buf->len, &width, &height)
+			: xbm_decode(buf->data, buf->len, 0xff000000,
+				&width, &height);
+		if (!pixels) {
+			fprintf(stderr, "failed to decode %s\n", name);
+			exit(EXIT_FAILURE);
+		}
+		free(pixels);
+	}
+	double elapsed = get_time_ms() - start;
+	printf("%-28s %8.2f us/image, %7.1f MB/s\n", name,
+		elapsed * 1000.0 / ITERATIONS,
+		buf->len * ITERATIONS / (elapsed * 1000.0));
+}
+
+int main(int argc, char **argv)
+{
+	const struct {
+		const char *name;
+		int size;
+		int nr_colors;
+		int cpp;
+	} xpms[] = {
+		{ "xpm 8x8, 4 colors", 8, 4, 1 },
+		{ "xpm 48x48, 64 colors", 48, 64, 1 },
+		{ "xpm 128x128, 1024 colors", 128, 1024, 2 },
+	};
+
+	for (size_t i = 0; i < ARRAY_SIZE(xpms); i++) {
+		struct buf buf = BUF_INIT;
+		create_xpm(&buf, xpms[i].size, xpms[i].nr_colors, xpms[i].cpp);
+		bench(xpms[i].name, &buf, true);
+		buf_reset(&buf);
+	}
+
+	const int xbm_sizes[] = { 8, 64 };
+	for (size_t i = 0; i < ARRAY_SIZE(xbm_sizes); i++) {
+		struct buf buf = BUF_INIT;
+		char name[32];
+		create_xbm(&buf, xbm_sizes[i]);
+		snprintf(name, sizeof(name), "xbm %dx%d", xbm_sizes[i],
+			xbm_sizes[i]);
+		bench(name, &buf, false);
+		buf_reset(&buf);
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Micro-benchmark for downscaling icons, comparing the box filter with
+ * cairo's CAIRO_FILTER_GOOD as previously used by buffer_resize().
+ *
+ * Quality is given as PSNR against an exact floating point area average,
+ * higher is better.
+ *
+ * Run with: meson test -C build --benchmark --verbose
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <cairo.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "common/macros.h"
+#include "common/resample.h"
+#include "common/time.h"
+
+#define SRC_SIZE 512
+#define ITERATIONS 50
+
+/* Concentric rings, which alias badly when sampled too sparsely */
+static void
+draw_pattern(uint32_t *pixels, int size)
+{
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			double dx = x - size / 2.0;
+			double dy = y - size / 2.0;
+			double r = sqrt(dx * dx + dy * dy);
+			uint32_t a = r < size / 2.0 ? 255 : 0;
+			uint32_t v = (0.5 + 0.5 * sin(r * r / size)) * a;
+			pixels[y * size + x] = a << 24 | v << 16 | v << 8 | (a - v);
+		}
+	}
+}
+
+static void
+resample_reference(const uint32_t *src, int src_size, double *dst,
+		int dst_size)
+{
+	double ratio = (double)src_size / dst_size;
+	for (int y = 0; y < dst_size; y++) {
+		for (int x = 0; x < dst_size; x++) {
+			for (int c = 0; c < 4; c++) {
+				double sum = 0;
+				double x0 = x * ratio, x1 = (x + 1) * ratio;
+				double y0 = y * ratio, y1 = (y + 1) * ratio;
+				for (int sy = floor(y0); sy < y1; sy++) {
+					double wy = fmin(y1, sy + 1) - fmax(y0, sy);
+					for (int sx = floor(x0); sx < x1; sx++) {
+						double wx = fmin(x1, sx + 1)
+							- fmax(x0, sx);
+						uint32_t p = src[sy * src_size + sx];
+						sum += wx * wy * ((p >> (8 * c)) & 0xff);
+					}
+				}
+				dst[(y * dst_size + x) * 4 + c] =
+					sum / (ratio * ratio);
+			}
+		}
+	}
+}
+
+static double
+psnr(const uint32_t *pixels, const double *reference, int size)
+{
+	double error = 0;
+	for (int i = 0; i < size * size; i++) {
+		for (int c = 0; c < 4; c++) {
+			double d = ((pixels[i] >> (8 * c)) & 0xff)
+				- reference[i * 4 + c];
+			error += d * d;
+		}
+	}
+	error /= size * size * 4;
+	return error > 0 ? 10 * log10(255.0 * 255.0 / error) : INFINITY;
+}
+
+static void
+resample_cairo(cairo_surface_t *src, int src_size, cairo_surface_t *dst,
+		int dst_size)
+{
+	cairo_t *cairo = cairo_create(dst);
+	double scale = (double)dst_size / src_size;
+	cairo_scale(cairo, scale, scale);
+	cairo_set_source_surface(cairo, src, 0, 0);
+	cairo_pattern_set_filter(cairo_get_source(cairo), CAIRO_FILTER_GOOD);
+	cairo_set_operator(cairo, CAIRO_OPERATOR_SOURCE);
+	cairo_paint(cairo);
+	cairo_surface_flush(dst);
+	cairo_destroy(cairo);
+}
+
+int main(int argc, char **argv)
+{
+	const int sizes[] = { 16, 24, 32, 64, 128 };
+
+	cairo_surface_t *src = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+		SRC_SIZE, SRC_SIZE);
+	uint32_t *src_pixels = (uint32_t *)cairo_image_surface_get_data(src);
+	int src_stride = cairo_image_surface_get_stride(src);
+	draw_pattern(src_pixels, SRC_SIZE);
+	cairo_surface_mark_dirty(src);
+
+	for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+		int size = sizes[i];
+		cairo_surface_t *dst = cairo_image_surface_create(
+			CAIRO_FORMAT_ARGB32, size, size);
+		uint32_t *dst_pixels =
+			(uint32_t *)cairo_image_surface_get_data(dst);
+		double *reference = calloc(size * size * 4, sizeof(*reference));
+		resample_reference(src_pixels, SRC_SIZE, reference, size);
+
+		double start = get_time_ms();
+		for (int j = 0; j < ITERATIONS; j++) {
+			resample_cairo(src, SRC_SIZE, dst, size);
+		}
+		double cairo_ms = (get_time_ms() - start) / ITERATIONS;
+		double cairo_psnr = psnr(dst_pixels, reference, size);
+
+		start = get_time_ms();
+		for (int j = 0; j < ITERATIONS; j++) {
+			resample_box_argb32(src_pixels, SRC_SIZE, SRC_SIZE,
+				src_stride, dst_pixels, size, size, size * 4);
+		}
+		double box_ms = (get_time_ms() - start) / ITERATIONS;
+		double box_psnr = psnr(dst_pixels, reference, size);
+
+		printf("%dpx -> %3dpx: cairo %.3f ms (%.1f dB), "
+			"box %.3f ms (%.1f dB), %.1fx faster\n",
+			SRC_SIZE, size, cairo_ms, cairo_psnr, box_ms, box_psnr,
+			box_ms > 0 ? cairo_ms / box_ms : 0);
+
+		free(reference);
+		cairo_surface_destroy(dst);
+	}
+	cairo_surface_destroy(src);
+	return 0;
+}
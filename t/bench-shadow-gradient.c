@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Micro-benchmark for drawing window shadow corners, comparing the
+ * separable integer implementation with evaluating the 2-D Gaussian
+ * for every pixel.
+ *
+ * Run with: meson test -C build --benchmark --verbose
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "common/macros.h"
+#include "common/shadow-gradient.h"
+#include "common/time.h"
+
+#define ITERATIONS 200
+
+static void
+draw_corner_per_pixel(uint32_t *pixels, int total_size, const float color[4])
+{
+	double variance = 0.3 * 0.3;
+	for (int y = 0; y < total_size; y++) {
+		uint8_t *row = (uint8_t *)&pixels[y * total_size];
+		for (int x = 0; x < total_size; x++) {
+			double xn = (double)x / (double)total_size;
+			double yn = (double)y / (double)total_size;
+			double alpha = exp(-(xn * xn) / variance)
+				* exp(-(yn * yn) / variance);
+			row[4 * x] = color[2] * alpha * 255;
+			row[4 * x + 1] = color[1] * alpha * 255;
+			row[4 * x + 2] = color[0] * alpha * 255;
+			row[4 * x + 3] = color[3] * alpha * 255;
+		}
+	}
+}
+
+static void
+draw_corner_separable(uint32_t *pixels, uint32_t *profile, int visible_size,
+		int total_size, const float color[4])
+{
+	shadow_gradient_profile(profile, total_size);
+	shadow_gradient_corner(pixels, total_size * sizeof(*pixels), profile,
+		visible_size, total_size, 0, color);
+}
+
+int main(int argc, char **argv)
+{
+	const float color[4] = { 0.0f, 0.0f, 0.0f, 0.5f };
+	const int sizes[] = { 20, 60, 120 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+		int visible_size = sizes[i];
+		int total_size = visible_size + (int)(visible_size * 0.3);
+		uint32_t *profile = calloc(total_size, sizeof(*profile));
+		uint32_t *pixels = calloc(total_size * total_size,
+			sizeof(*pixels));
+
+		double start = get_time_ms();
+		for (int j = 0; j < ITERATIONS; j++) {
+			draw_corner_per_pixel(pixels, total_size, color);
+		}
+		double per_pixel = (get_time_ms() - start) / ITERATIONS;
+
+		start = get_time_ms();
+		for (int j = 0; j < ITERATIONS; j++) {
+			draw_corner_separable(pixels, profile, visible_size,
+				total_size, color);
+		}
+		double separable = (get_time_ms() - start) / ITERATIONS;
+
+		printf("shadow %3dpx: per-pixel %.3f ms, separable %.3f ms (%.1fx)\n",
+			visible_size, per_pixel, separable,
+			separable > 0 ? per_pixel / separable : 0);
+
+		free(pixels);
+		free(profile);
+	}
+	return 0;
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Micro-benchmark for the time the compositor is blocked when launching a
+ * process, comparing vfork() as used by spawn_primary_client() with the
+ * fork() it replaces, for increasing resident set sizes of the parent.
+ *
+ * Only the time until the spawn call returns is measured since that is
+ * what stalls the event loop; the child is reaped outside of the timing.
+ *
+ * Run with: meson test -C build --benchmark --verbose
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "common/macros.h"
+#include "common/spawn.h"
+#include "common/time.h"
+
+#define ITERATIONS 50
+#define COMMAND "true"
+
+static pid_t
+spawn_fork(void)
+{
+	pid_t pid = fork();
+	if (pid == 0) {
+		execlp(COMMAND, COMMAND, NULL);
+		_exit(127);
+	}
+	return pid;
+}
+
+static pid_t
+spawn_vfork(void)
+{
+	return spawn_primary_client(COMMAND);
+}
+
+static double
+measure(pid_t (*spawn)(void))
+{
+	double total = 0;
+	for (int i = 0; i < ITERATIONS; i++) {
+		double start = get_time_ms();
+		pid_t pid = spawn();
+		total += get_time_ms() - start;
+		if (pid > 0) {
+			waitpid(pid, NULL, 0);
+		}
+	}
+	return total / ITERATIONS;
+}
+
+int main(int argc, char **argv)
+{
+	const size_t rss_mb[] = { 0, 64, 256, 1024 };
+
+	for (size_t i = 0; i < ARRAY_SIZE(rss_mb); i++) {
+		/* Touch every page so that it is actually mapped */
+		size_t size = rss_mb[i] << 20;
+		char *ballast = NULL;
+		if (size) {
+			ballast = calloc(1, size);
+			if (!ballast) {
+				printf("%4zu MiB: cannot allocate, skipping\n",
+					rss_mb[i]);
+				continue;
+			}
+			memset(ballast, 1, size);
+		}
+
+		double fork_ms = measure(spawn_fork);
+		double vfork_ms = measure(spawn_vfork);
+		printf("%4zu MiB rss: fork %.3f ms, vfork %.3f ms, %.1fx faster\n",
+			rss_mb[i], fork_ms, vfork_ms,
+			vfork_ms > 0 ? fork_ms / vfork_ms : 0);
+
+		free(ballast);
+	}
+	return 0;
+}
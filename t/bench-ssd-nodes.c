@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Micro-benchmark for the size of the server side decorations in the
+ * scene-graph.
+ *
+ * The decorations are built by ssd_create() for a stack of overlapping
+ * views, using the built-in rc.xml defaults and the configured theme. The
+ * number of nodes per window is counted and wlr_scene_node_at() is timed
+ * for random points over the stack, like it is called on every cursor
+ * motion.
+ *
+ * No output is attached to the scene, so no buffers are rendered; only the
+ * shape of the scene-graph is measured.
+ *
+ * Run with: meson test -C build --benchmark --verbose
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <wlr/render/pixman.h>
+#include <wlr/types/wlr_scene.h>
+#include <wlr/util/log.h>
+#include "common/mem.h"
+#include "common/time.h"
+#include "config/rcxml.h"
+#include "labwc.h"
+#include "ssd.h"
+#include "theme.h"
+#include "view.h"
+
+#define NR_WINDOWS 200
+#define NR_LOOKUPS 100000
+#define WIDTH 640
+#define HEIGHT 480
+
+/* Normally defined in main.c, which is not linked into the benchmark */
+struct rcxml rc = { 0 };
+struct server server = { 0 };
+
+static struct theme theme;
+
+static struct view *
+create_view(struct wlr_scene_tree *parent, int x, int y, bool active)
+{
+	struct view *view = znew(*view);
+	view_init(view);
+	view->ssd_mode = LAB_SSD_MODE_FULL;
+	view->current = (struct wlr_box){
+		.x = x,
+		.y = y,
+		.width = WIDTH,
+		.height = HEIGHT,
+	};
+	view->scene_tree = wlr_scene_tree_create(parent);
+	wlr_scene_node_set_position(&view->scene_tree->node, x, y);
+	view->ssd = ssd_create(view, active);
+	return view;
+}
+
+static void
+destroy_view(struct view *view)
+{
+	ssd_destroy(view->ssd);
+	wlr_scene_node_destroy(&view->scene_tree->node);
+	wlr_scene_node_destroy(&view->capture.scene->tree.node);
+	free(view->title);
+	free(view->app_id);
+	free(view);
+}
+
+static int
+count_nodes(struct wlr_scene_node *node)
+{
+	int count = 1;
+	if (node->type == WLR_SCENE_NODE_TREE) {
+		struct wlr_scene_tree *tree = wlr_scene_tree_from_node(node);
+		struct wlr_scene_node *child;
+		wl_list_for_each(child, &tree->children, link) {
+			count += count_nodes(child);
+		}
+	}
+	return count;
+}
+
+int main(int argc, char **argv)
+{
+	wlr_log_init(WLR_ERROR, NULL);
+	wl_list_init(&server.outputs);
+	server.renderer = wlr_pixman_renderer_create();
+
+	/* Use the built-in defaults rather than the user's rc.xml */
+	rcxml_read("/dev/null");
+	theme_init(&theme, rc.theme_name);
+	rc.theme = &theme;
+
+	struct wlr_scene *scene = wlr_scene_create();
+	struct view *views[NR_WINDOWS];
+	for (int i = 0; i < NR_WINDOWS; i++) {
+		/* Leave room for the titlebar above the view */
+		views[i] = create_view(&scene->tree, (i * 37) % 1280,
+			theme.titlebar_height + (i * 23) % 600,
+			i == NR_WINDOWS - 1);
+	}
+	int nr_nodes = count_nodes(&scene->tree.node);
+	/* The view tree holds nothing but the decoration */
+	int nr_ssd_nodes = count_nodes(&views[0]->scene_tree->node) - 1;
+
+	srand(1);
+	int hits = 0;
+	double start = get_time_ms();
+	for (int i = 0; i < NR_LOOKUPS; i++) {
+		double sx, sy;
+		if (wlr_scene_node_at(&scene->tree.node, rand() % 1920,
+				rand() % 1080, &sx, &sy)) {
+			hits++;
+		}
+	}
+	double lookup_us = (get_time_ms() - start) * 1000.0 / NR_LOOKUPS;
+
+	printf("%d decoration nodes per window, %d in total, "
+		"%.2f us per wlr_scene_node_at() (%d%% hits)\n",
+		nr_ssd_nodes, nr_nodes, lookup_us, hits * 100 / NR_LOOKUPS);
+
+	for (int i = 0; i < NR_WINDOWS; i++) {
+		destroy_view(views[i]);
+	}
+	wlr_scene_node_destroy(&scene->tree.node);
+	theme_finish(&theme);
+	rcxml_finish();
+	wlr_renderer_destroy(server.renderer);
+	return 0;
+}
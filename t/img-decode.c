@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka.h>
+#include "common/macros.h"
+#include "img/xbm-decode.h"
+#include "img/xpm-decode.h"
+
+#define FUZZ_ITERATIONS 5000
+
+static const char xpm[] =
+	"/* XPM */\n"
+	"static char *test[] = {\n"
+	"/* columns rows colors chars-per-pixel */\n"
+	"\"4 3 4 1 0 0\",\n"
+	"\"  c None\",\n"
+	"\". c #ff0000\",\n"
+	"\"X c white\",\n"
+	"\"o s shadow c #00f\",\n"
+	"/* pixels */\n"
+	"\" .Xo\",\n"
+	"\"X.? \",\n"
+	"\"oooo\"\n"
+	"};\n";
+
+static const char xpm_cpp2[] =
+	"/* XPM */ static char *t[] = { \"2 1 3 2\",\n"
+	"\"aa c #123456\", \"ab c black\", \"aa c #abcdef\", \"abaa\" };";
+
+static const char xbm[] =
+	"#define test_width 10\n"
+	"#define test_height 2\n"
+	"static unsigned char test_bits[] = {\n"
+	"   0x01, 0x02, 0x80, 0x03 };\n";
+
+/* Copy without terminator so that out-of-bounds reads are caught by ASan */
+static char *
+copy_data(const char *data, size_t len)
+{
+	char *copy = malloc(len ? len : 1);
+	memcpy(copy, data, len);
+	return copy;
+}
+
+static uint32_t *
+decode(bool is_xpm, const char *data, size_t len, int *width, int *height)
+{
+	char *copy = copy_data(data, len);
+	uint32_t *pixels = is_xpm ? xpm_decode(copy, len, width, height)
+		: xbm_decode(copy, len, 0xff000000, width, height);
+	free(copy);
+	return pixels;
+}
+
+static void
+test_xpm(void **state)
+{
+	int width, height;
+	uint32_t *pixels = decode(true, xpm, strlen(xpm), &width, &height);
+	assert_non_null(pixels);
+	assert_int_equal(width, 4);
+	assert_int_equal(height, 3);
+
+	const uint32_t expected[] = {
+		0x00000000, 0xffff0000, 0xffffffff, 0xff0000ff,
+		/* unknown chars get the first color */
+		0xffffffff, 0xffff0000, 0x00000000, 0x00000000,
+		0xff0000ff, 0xff0000ff, 0xff0000ff, 0xff0000ff,
+	};
+	for (int i = 0; i < 12; i++) {
+		assert_int_equal(pixels[i], expected[i]);
+	}
+	free(pixels);
+}
+
+static void
+test_xpm_cpp2(void **state)
+{
+	int width, height;
+	uint32_t *pixels = decode(true, xpm_cpp2, strlen(xpm_cpp2),
+		&width, &height);
+	assert_non_null(pixels);
+	assert_int_equal(width, 2);
+	assert_int_equal(height, 1);
+	assert_int_equal(pixels[0], 0xff000000);
+	/* The later definition of "aa" wins */
+	assert_int_equal(pixels[1], 0xffabcdef);
+	free(pixels);
+}
+
+static void
+test_xbm(void **state)
+{
+	int width, height;
+	uint32_t *pixels = decode(false, xbm, strlen(xbm), &width, &height);
+	assert_non_null(pixels);
+	assert_int_equal(width, 10);
+	assert_int_equal(height, 2);
+	for (int i = 0; i < 20; i++) {
+		bool set = i == 0 || i == 9 || i == 17 || i == 18 || i == 19;
+		assert_int_equal(pixels[i], set ? 0xff000000 : 0);
+	}
+	free(pixels);
+}
+
+static void
+check_result(uint32_t *pixels, int width, int height)
+{
+	if (pixels) {
+		assert_true(width > 0 && width <= 1024);
+		assert_true(height > 0 && height <= 1024);
+		/* Write every pixel so that short allocations are noticed */
+		memset(pixels, 0, (size_t)width * height * sizeof(*pixels));
+		free(pixels);
+	}
+}
+
+/* Every prefix of a valid file must be handled gracefully */
+static void
+fuzz_truncate(bool is_xpm, const char *data)
+{
+	size_t len = strlen(data);
+	for (size_t i = 0; i <= len; i++) {
+		int width = 0, height = 0;
+		uint32_t *pixels = decode(is_xpm, data, i, &width, &height);
+		check_result(pixels, width, height);
+	}
+}
+
+/* Replace a few bytes by characters which are significant to the parsers */
+static void
+fuzz_mutate(bool is_xpm, const char *data)
+{
+	static const char alphabet[] = "\"{}/*,;#x0123456789abcf cCsN\n\t\\";
+	size_t len = strlen(data);
+	char *copy = malloc(len);
+	uint32_t seed = 42;
+
+	for (int i = 0; i < FUZZ_ITERATIONS; i++) {
+		memcpy(copy, data, len);
+		seed = seed * 1103515245 + 12345;
+		int nr_changes = 1 + (seed >> 16) % 4;
+		for (int j = 0; j < nr_changes; j++) {
+			seed = seed * 1103515245 + 12345;
+			size_t pos = (seed >> 8) % len;
+			seed = seed * 1103515245 + 12345;
+			copy[pos] = alphabet[(seed >> 16) % (sizeof(alphabet) - 1)];
+		}
+		int width = 0, height = 0;
+		uint32_t *pixels = decode(is_xpm, copy, len, &width, &height);
+		check_result(pixels, width, height);
+	}
+	free(copy);
+}
+
+static void
+test_fuzz(void **state)
+{
+	fuzz_truncate(true, xpm);
+	fuzz_truncate(true, xpm_cpp2);
+	fuzz_truncate(false, xbm);
+	fuzz_mutate(true, xpm);
+	fuzz_mutate(true, xpm_cpp2);
+	fuzz_mutate(false, xbm);
+}
+
+static void
+test_invalid(void **state)
+{
+	static const char *const invalid[] = {
+		"",
+		"/* XPM */ { \"0 1 1 1\", \"a c red\", \"a\" }",
+		"/* XPM */ { \"1 1 1 0\", \"a c red\", \"a\" }",
+		"/* XPM */ { \"1 1 0 1\", \"a\" }",
+		"/* XPM */ { \"2000 1 1 1\", \"a c red\", \"a\" }",
+		"/* XPM */ { \"2 1 1 1\", \"a c red\", \"a\" }",
+		"/* XPM2 */ { \"1 1 1 1\", \"a c red\", \"a\" }",
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(invalid); i++) {
+		int width, height;
+		assert_null(decode(true, invalid[i], strlen(invalid[i]),
+			&width, &height));
+	}
+
+	static const char *const invalid_xbm[] = {
+		"",
+		"#define a_width 8\n static char a_bits[] = { 0x01 };",
+		"#define a_width 0\n#define a_height 1\n { 0x01 };",
+		"#define a_width 8\n#define a_height 5000\n { 0x01 };",
+		"#define a_width 8\n#define a_height 1\n",
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(invalid_xbm); i++) {
+		int width, height;
+		assert_null(decode(false, invalid_xbm[i], strlen(invalid_xbm[i]),
+			&width, &height));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_xpm),
+		cmocka_unit_test(test_xpm_cpp2),
+		cmocka_unit_test(test_xbm),
+		cmocka_unit_test(test_invalid),
+		cmocka_unit_test(test_fuzz),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
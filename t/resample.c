@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cmocka.h>
+#include "common/resample.h"
+
+/* Deterministic pre-multiplied test pattern */
+static uint32_t *
+create_pattern(int width, int height)
+{
+	uint32_t *pixels = calloc(width * height, sizeof(*pixels));
+	uint32_t seed = 1;
+	for (int i = 0; i < width * height; i++) {
+		seed = seed * 1103515245 + 12345;
+		uint32_t a = (seed >> 24) & 0xff;
+		uint32_t r = ((seed >> 16) & 0xff) * a / 255;
+		uint32_t g = ((seed >> 8) & 0xff) * a / 255;
+		uint32_t b = (i & 0xff) * a / 255;
+		pixels[i] = a << 24 | r << 16 | g << 8 | b;
+	}
+	return pixels;
+}
+
+/* Coverage-weighted average in floating point */
+static double
+reference_channel(const uint32_t *src, int src_w, int src_h, int dst_w,
+		int dst_h, int x, int y, int shift)
+{
+	double x0 = (double)x * src_w / dst_w, x1 = (double)(x + 1) * src_w / dst_w;
+	double y0 = (double)y * src_h / dst_h, y1 = (double)(y + 1) * src_h / dst_h;
+	double sum = 0;
+	for (int sy = floor(y0); sy < y1; sy++) {
+		double wy = fmin(y1, sy + 1) - fmax(y0, sy);
+		for (int sx = floor(x0); sx < x1; sx++) {
+			double wx = fmin(x1, sx + 1) - fmax(x0, sx);
+			sum += wx * wy * ((src[sy * src_w + sx] >> shift) & 0xff);
+		}
+	}
+	return sum / ((x1 - x0) * (y1 - y0));
+}
+
+static void
+check_resample(int src_w, int src_h, int dst_w, int dst_h)
+{
+	uint32_t *src = create_pattern(src_w, src_h);
+	uint32_t *dst = calloc(dst_w * dst_h, sizeof(*dst));
+	resample_box_argb32(src, src_w, src_h, src_w * 4, dst, dst_w, dst_h,
+		dst_w * 4);
+
+	for (int y = 0; y < dst_h; y++) {
+		for (int x = 0; x < dst_w; x++) {
+			uint32_t pixel = dst[y * dst_w + x];
+			for (int shift = 0; shift < 32; shift += 8) {
+				double expected = reference_channel(src, src_w,
+					src_h, dst_w, dst_h, x, y, shift);
+				int actual = (pixel >> shift) & 0xff;
+				assert_true(fabs(actual - expected) <= 1.0);
+			}
+			/* Still valid pre-multiplied data */
+			for (int shift = 0; shift < 24; shift += 8) {
+				assert_true(((pixel >> shift) & 0xff)
+					<= pixel >> 24);
+			}
+		}
+	}
+	free(dst);
+	free(src);
+}
+
+static void
+test_downscale(void **state)
+{
+	check_resample(512, 512, 16, 16);
+	check_resample(256, 256, 24, 24);
+	check_resample(48, 48, 32, 32);
+	check_resample(100, 37, 7, 3);
+	check_resample(33, 17, 1, 1);
+}
+
+static void
+test_identity(void **state)
+{
+	uint32_t *src = create_pattern(20, 10);
+	uint32_t *dst = calloc(20 * 10, sizeof(*dst));
+	resample_box_argb32(src, 20, 10, 20 * 4, dst, 20, 10, 20 * 4);
+	for (int i = 0; i < 20 * 10; i++) {
+		assert_int_equal(dst[i], src[i]);
+	}
+	free(dst);
+	free(src);
+}
+
+static void
+test_solid(void **state)
+{
+	uint32_t src[64 * 64];
+	uint32_t dst[5 * 5];
+	for (int i = 0; i < 64 * 64; i++) {
+		src[i] = 0x80402010;
+	}
+	resample_box_argb32(src, 64, 64, 64 * 4, dst, 5, 5, 5 * 4);
+	for (int i = 0; i < 5 * 5; i++) {
+		assert_int_equal(dst[i], 0x80402010);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_downscale),
+		cmocka_unit_test(test_identity),
+		cmocka_unit_test(test_solid),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-only
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cmocka.h>
+#include "common/shadow-gradient.h"
+
+/* Same as the original per-pixel floating point implementation */
+static uint32_t
+reference_pixel(const float color[4], double alpha)
+{
+	uint8_t b = color[2] * alpha * 255;
+	uint8_t g = color[1] * alpha * 255;
+	uint8_t r = color[0] * alpha * 255;
+	uint8_t a = color[3] * alpha * 255;
+	return (uint32_t)a << 24 | (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+}
+
+static double
+gauss(int i, int total_size)
+{
+	double n = (double)i / (double)total_size;
+	return exp(-(n * n) / (0.3 * 0.3));
+}
+
+static void
+assert_pixel_near(uint32_t actual, uint32_t expected)
+{
+	for (int shift = 0; shift < 32; shift += 8) {
+		int a = (actual >> shift) & 0xff;
+		int e = (expected >> shift) & 0xff;
+		assert_true(abs(a - e) <= 1);
+	}
+}
+
+static void
+test_edge(void **state)
+{
+	const float color[4] = { 0.0f, 0.0f, 0.0f, 0.5f };
+	int visible_size = 60;
+	int total_size = visible_size + 18;
+
+	uint32_t profile[78];
+	uint32_t pixels[60];
+	shadow_gradient_profile(profile, total_size);
+	shadow_gradient_edge(pixels, profile, visible_size, total_size, color);
+
+	int inset = total_size - visible_size;
+	for (int x = 0; x < visible_size; x++) {
+		assert_pixel_near(pixels[x],
+			reference_pixel(color, gauss(x + inset, total_size)));
+	}
+}
+
+static void
+check_corner(int visible_size, int titlebar_height, const float color[4])
+{
+	int total_size = visible_size + (int)(visible_size * 0.3);
+	int inset = total_size - visible_size;
+
+	uint32_t *profile = calloc(total_size, sizeof(*profile));
+	uint32_t *pixels = calloc(total_size * total_size, sizeof(*pixels));
+	shadow_gradient_profile(profile, total_size);
+	shadow_gradient_corner(pixels, total_size * sizeof(*pixels), profile,
+		visible_size, total_size, titlebar_height, color);
+
+	for (int y = 0; y < total_size; y++) {
+		for (int x = 0; x < total_size; x++) {
+			bool in1 = x < inset && y < inset - titlebar_height;
+			bool in2 = x < inset - titlebar_height && y < inset;
+			double alpha = (in1 || in2) ? 0.0
+				: gauss(x, total_size) * gauss(y, total_size);
+			assert_pixel_near(pixels[y * total_size + x],
+				reference_pixel(color, alpha));
+		}
+	}
+	free(pixels);
+	free(profile);
+}
+
+static void
+test_corner(void **state)
+{
+	const float black[4] = { 0.0f, 0.0f, 0.0f, 0.5f };
+	const float opaque[4] = { 1.0f, 0.5f, 0.25f, 1.0f };
+
+	check_corner(40, 0, black);
+	check_corner(60, 26, black);
+	check_corner(100, 10, opaque);
+	check_corner(1, 0, opaque);
+}
+
+int main(int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_edge),
+		cmocka_unit_test(test_corner),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}